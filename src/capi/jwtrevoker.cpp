@@ -0,0 +1,137 @@
+#include "jwtrevoker.h"
+
+#include <exception>
+#include <filesystem>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+#include "../detail/Engine/Engine.hpp"
+#include "../detail/Utils/ConfigReader.hpp"
+
+// 句柄：配置表的生命周期必须覆盖引擎（Engine 只保存配置的引用）
+struct jwtrevoker {
+    std::map<std::string, std::string> config;
+    Engine engine;
+    bool logging;
+
+    jwtrevoker(std::map<std::string, std::string> _config, EngineLogSink logSink)
+        : config(std::move(_config)), engine(config, std::move(logSink)),
+          logging(!getConfigOrDefault(config, "log_file_path", "").empty()) {}
+};
+
+namespace {
+    thread_local std::string lastError;
+
+    // 在 C 边界捕获所有异常，转换为错误码；ioError 为文件读写类失败时返回的错误码
+    template<typename Fn>
+    int guarded(Fn &&fn, const int ioError = JWTREVOKER_ERROR) noexcept {
+        try {
+            lastError.clear();
+            return fn();
+        } catch (const std::invalid_argument &e) {
+            lastError = e.what();
+            return JWTREVOKER_EINVAL;
+        } catch (const std::logic_error &e) {
+            lastError = e.what();
+            return JWTREVOKER_EINVAL;
+        } catch (const std::filesystem::filesystem_error &e) {
+            lastError = e.what();
+            return JWTREVOKER_EIO;
+        } catch (const std::exception &e) {
+            lastError = e.what();
+            return ioError;
+        } catch (...) {
+            lastError = "Unknown error";
+            return JWTREVOKER_ERROR;
+        }
+    }
+
+    void requireHandle(const jwtrevoker *handle) {
+        if (!handle) throw std::invalid_argument("handle cannot be NULL");
+    }
+
+    std::string toToken(const char *token, const size_t tokenLen) {
+        if (!token || tokenLen == 0) throw std::invalid_argument("token cannot be empty");
+        return {token, tokenLen};
+    }
+}
+
+extern "C" {
+int jwtrevoker_create(const jwtrevoker_options *options, jwtrevoker_t **out) {
+    return guarded([&] {
+        if (!options || !out) throw std::invalid_argument("options and out cannot be NULL");
+        *out = nullptr;
+
+        // 配置文件中的高级参数，日志目录以 options 为准
+        std::map<std::string, std::string> config;
+        if (options->config_path) config = readConfig(options->config_path);
+        config["log_file_path"] = options->log_dir ? options->log_dir : "";
+        if (options->log_dir) std::filesystem::create_directories(options->log_dir);
+
+        // 引擎日志交给调用方的回调；没有回调时丢弃，不写宿主进程的标准输出
+        EngineLogSink logSink = [](const std::string &) {};
+        if (options->log) {
+            logSink = [log = options->log, user = options->log_user](const std::string &message) {
+                log(message.c_str(), user);
+            };
+        }
+        auto handle = std::make_unique<jwtrevoker>(std::move(config), std::move(logSink));
+        handle->engine.init(options->max_jwt_life_time, options->rotation_interval, options->bloom_filter_size,
+                            options->hash_function_num);
+        *out = handle.release();
+        return JWTREVOKER_OK;
+    });
+}
+
+void jwtrevoker_destroy(jwtrevoker_t *handle) {
+    delete handle;
+}
+
+int jwtrevoker_revoke(jwtrevoker_t *handle, const char *token, const size_t token_len, const int64_t exp_time) {
+    return guarded([&] {
+        requireHandle(handle);
+        const std::string jwt = toToken(token, token_len);
+        handle->engine.revokeJwt(jwt, exp_time);
+        if (handle->logging) handle->engine.logRevoke(jwt, exp_time);
+        return JWTREVOKER_OK;
+    });
+}
+
+int jwtrevoker_is_revoked(const jwtrevoker_t *handle, const char *token, const size_t token_len, const int64_t exp_time) {
+    return guarded([&] {
+        requireHandle(handle);
+        return handle->engine.isRevoked(toToken(token, token_len), exp_time) ? 1 : 0;
+    });
+}
+
+int jwtrevoker_rotate(jwtrevoker_t *handle) {
+    return guarded([&] {
+        requireHandle(handle);
+        handle->engine.rotate();
+        return JWTREVOKER_OK;
+    });
+}
+
+int jwtrevoker_snapshot(jwtrevoker_t *handle, const char *path) {
+    return guarded([&] {
+        requireHandle(handle);
+        if (!path) throw std::invalid_argument("path cannot be NULL");
+        handle->engine.saveSnapshot(path);
+        return JWTREVOKER_OK;
+    }, JWTREVOKER_EIO);
+}
+
+int jwtrevoker_restore(jwtrevoker_t *handle, const char *path) {
+    return guarded([&] {
+        requireHandle(handle);
+        if (!path) throw std::invalid_argument("path cannot be NULL");
+        handle->engine.loadSnapshot(path);
+        return JWTREVOKER_OK;
+    }, JWTREVOKER_EIO);
+}
+
+const char *jwtrevoker_last_error(void) {
+    return lastError.c_str();
+}
+}
@@ -0,0 +1,86 @@
+#ifndef JWTREVOKER_H
+#define JWTREVOKER_H
+
+/*
+ * libjwtrevoker：可嵌入的撤回引擎（C API）。
+ * 在网关进程内直接撤回与查询 token，不需要 master 连接、不经过网络；
+ * 需要集群协同时仍使用 JWTRevoker_BlackList 服务（Server / Scheduler 建立在同一个引擎之上）。
+ *
+ * 所有函数都不会抛出异常：成功返回 JWTREVOKER_OK（is_revoked 返回 1 / 0），
+ * 失败返回负的错误码，jwtrevoker_last_error() 给出本线程最近一次错误的描述。
+ * 同一个句柄可以被多个线程同时使用：撤回、轮换、快照与还原在引擎内部串行化；查询不加锁，
+ * 读取的是引擎发布的窗口视图，轮换与还原换下的窗口要等进行中的查询全部返回后才释放，因此可以与它们并发。
+ * 只有 jwtrevoker_destroy 需要调用方保证没有其他线程仍在使用该句柄。
+ *
+ * 库不会写标准输出或标准错误：引擎日志交给 options 中的 log 回调，未设置时丢弃。
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#if defined(JWTREVOKER_BUILDING)
+#define JWTREVOKER_API __declspec(dllexport)
+#elif defined(JWTREVOKER_SHARED)
+#define JWTREVOKER_API __declspec(dllimport)
+#else
+#define JWTREVOKER_API
+#endif
+#else
+#define JWTREVOKER_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    JWTREVOKER_OK = 0,
+    JWTREVOKER_EINVAL = -1, /* 参数无效 */
+    JWTREVOKER_EIO = -2, /* 日志目录或快照文件读写失败、快照格式错误 */
+    JWTREVOKER_ERROR = -3 /* 其他错误 */
+};
+
+typedef struct jwtrevoker jwtrevoker_t;
+
+typedef struct jwtrevoker_options {
+    unsigned int max_jwt_life_time; /* JWT 最大生存时长（秒） */
+    unsigned int rotation_interval; /* 窗口轮换间隔（秒） */
+    size_t bloom_filter_size; /* 每个窗口的比特数 */
+    unsigned int hash_function_num; /* 每个窗口的哈希函数个数 */
+    const char *log_dir; /* 撤回日志目录，启动时从中恢复；NULL 表示不持久化 */
+    const char *config_path; /* 可选的配置文件（window_filter、bloom_filter_* 等高级参数）；NULL 使用默认值 */
+    /* 可选的日志回调：每次一条完整的消息（不含末尾换行），可能从后台线程并发调用；NULL 表示丢弃日志 */
+    void (*log)(const char *message, void *user);
+    void *log_user; /* 原样传给 log 回调 */
+} jwtrevoker_options;
+
+/* 创建引擎并启动周期轮换；成功时 *out 为新句柄 */
+JWTREVOKER_API int jwtrevoker_create(const jwtrevoker_options *options, jwtrevoker_t **out);
+
+/* 停止后台线程并释放句柄（NULL 时什么都不做） */
+JWTREVOKER_API void jwtrevoker_destroy(jwtrevoker_t *handle);
+
+/* 撤回 token（exp_time 为 Unix 时间戳）；已过期或超出最大生存时长的 token 被忽略 */
+JWTREVOKER_API int jwtrevoker_revoke(jwtrevoker_t *handle, const char *token, size_t token_len, int64_t exp_time);
+
+/* 已撤回返回 1（可能误判），未撤回返回 0，出错返回负的错误码 */
+JWTREVOKER_API int jwtrevoker_is_revoked(const jwtrevoker_t *handle, const char *token, size_t token_len,
+                                         int64_t exp_time);
+
+/* 立即执行一次周期轮换（淘汰最旧的窗口） */
+JWTREVOKER_API int jwtrevoker_rotate(jwtrevoker_t *handle);
+
+/* 把当前窗口保存为快照文件 / 从快照文件还原（同一平台；不支持 window_seal 与 shm_export_path） */
+JWTREVOKER_API int jwtrevoker_snapshot(jwtrevoker_t *handle, const char *path);
+
+JWTREVOKER_API int jwtrevoker_restore(jwtrevoker_t *handle, const char *path);
+
+/* 本线程最近一次失败的描述；没有失败时为空字符串 */
+JWTREVOKER_API const char *jwtrevoker_last_error(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* JWTREVOKER_H */
@@ -4,66 +4,378 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <utility>
 
 #include "SHA256/SHA256.h"
+#include "BitmapAllocator.hpp"
+#include "SparseBitSet.hpp"
+#include "../Utils/BinaryIO.hpp"
+
+// 一个 key 的 k 个原始哈希值（各探测消息 SHA256 摘要的前 8 字节）。
+// 同一 key 在哈希函数个数相同的多个窗口间只需计算一次；k 不超过 INLINE_NUM 时不分配堆内存。
+class BloomHashes {
+public:
+    static constexpr unsigned int INLINE_NUM = 16;
+
+    unsigned int size() const { return num; }
+
+    const uint64_t* data() const { return num <= INLINE_NUM ? inlineHashes.data() : heapHashes.data(); }
+
+    uint64_t* resize(const unsigned int n) {
+        num = n;
+        if (n <= INLINE_NUM) return inlineHashes.data();
+        heapHashes.resize(n);
+        return heapHashes.data();
+    }
+
+private:
+    std::array<uint64_t, INLINE_NUM> inlineHashes{};
+    std::vector<uint64_t> heapHashes;
+    unsigned int num = 0;
+};
 
 class BaseBloomFilter {
 public:
-    BaseBloomFilter(const size_t size, const unsigned int hashFunctionNum) {
+    // k 不超过该值时使用编译期展开的探测内核，否则回退到通用循环
+    static constexpr unsigned int MAX_SPECIALIZED_HASH_NUM = BloomHashes::INLINE_NUM;
+
+    // 位图小于一页时直接使用位图，稀疏表示没有收益
+    static constexpr size_t MIN_SPARSE_BITMAP_BYTES = 4096;
+
+    BaseBloomFilter(const size_t size, const unsigned int hashFunctionNum, const BitmapAllocOptions& options = {})
+        : allocOptions(options) {
         if (size == 0) throw std::invalid_argument("The size of Bloom filter cannot be zero");
         if ((size & (size - 1)) != 0) throw std::invalid_argument("The size of a Bloom filter must be a power of 2.");
         if (hashFunctionNum == 0) throw std::invalid_argument("The number of hash functions cannot be zero");
 
-        // 初始化基本布隆过滤器
+        // 初始化基本布隆过滤器：位图按 64 位字存放，内存由 BitmapBuffer 分配（初始为零）。
+        // 新窗口先以稀疏形式只记录置位位置，置位比特数超过 sparseLimit 时再转换为位图
         this->bloomFilterSize = size;
-        this->bloomFilter.resize(size, false);
+        this->bloomFilterMask = size - 1;
         this->hashFunctionNum = hashFunctionNum;
         this->msgNum = 0;
+        this->setBitNum = 0;
+        this->sparseLimit = static_cast<size_t>(static_cast<double>(size) * options.sparseMaxFill);
+        if (sparseLimit > 0 && wordNum(size) * sizeof(uint64_t) >= MIN_SPARSE_BITMAP_BYTES) {
+            sparse = std::make_unique<SparseBitSet>();
+        } else {
+            allocateReplicas();
+            dense.value.store(true, std::memory_order_relaxed);
+        }
+        selectKernels();
     }
 
-    ~BaseBloomFilter() { bloomFilter.clear(); }
+    // 计算 key 的 k 个原始哈希值
+    static void hashKey(const std::string& key, const unsigned int hashFunctionNum, BloomHashes& hashes) {
+        // k 条探测消息（key_0 … key_{k-1}）相互独立，拼接在线程局部缓冲区中批量计算，可使用多缓冲 SIMD
+        thread_local std::string scratch;
+        thread_local std::vector<const SHA256::BYTE*> data;
+        thread_local std::vector<size_t> lens;
+        thread_local std::vector<SHA256::BYTE> digests;
+        const size_t stride = key.size() + 1 + std::numeric_limits<unsigned int>::digits10 + 1;
+        if (scratch.size() < hashFunctionNum * stride) scratch.resize(hashFunctionNum * stride);
+        if (data.size() < hashFunctionNum) {
+            data.resize(hashFunctionNum);
+            lens.resize(hashFunctionNum);
+            digests.resize(static_cast<size_t>(hashFunctionNum) * SHA256_BLOCK_SIZE);
+        }
+        for (unsigned int i = 0; i < hashFunctionNum; ++i) {
+            char* msg = scratch.data() + i * stride;
+            std::memcpy(msg, key.data(), key.size());
+            msg[key.size()] = '_';
+            const char* end = std::to_chars(msg + key.size() + 1, msg + stride, i).ptr;
+            data[i] = reinterpret_cast<const SHA256::BYTE*>(msg);
+            lens[i] = end - msg;
+        }
+
+        // SHA256散列算法输出32字节长度的哈希值
+        SHA256::sha256_batch(data.data(), lens.data(), hashFunctionNum,
+                             reinterpret_cast<SHA256::BYTE(*)[SHA256_BLOCK_SIZE]>(digests.data()));
+
+        // 取每个摘要的前 8 个字节作为原始哈希值
+        uint64_t* out = hashes.resize(hashFunctionNum);
+        for (unsigned int i = 0; i < hashFunctionNum; ++i) {
+            std::memcpy(&out[i], digests.data() + static_cast<size_t>(i) * SHA256_BLOCK_SIZE, sizeof(uint64_t));
+        }
+    }
 
     void add(const std::string& key) {
-        std::vector<size_t> indices = calcHashIndices(key);
-        for (const size_t index : indices) { bloomFilter[index % bloomFilterSize] = true; }
-        ++msgNum;
+        BloomHashes hashes;
+        hashKey(key, hashFunctionNum, hashes);
+        add(hashes);
     }
 
     bool contains(const std::string& key) const {
-        std::vector<size_t> indices = calcHashIndices(key);
-        for (const size_t index : indices) { if (!bloomFilter[index % bloomFilterSize]) { return false; } }
-        return true;
+        BloomHashes hashes;
+        hashKey(key, hashFunctionNum, hashes);
+        return contains(hashes);
+    }
+
+    // 使用预先计算的哈希值写入 / 查询（hashes 至少包含 k 个哈希值，只使用前 k 个）
+    void add(const BloomHashes& hashes) {
+        if (isDense()) (this->*addKernel)(hashes.data());
+        else addSparse(hashes.data());
+        ++msgNum;
+    }
+
+    bool contains(const BloomHashes& hashes) const {
+        return isDense() ? (this->*containsKernel)(hashes.data()) : containsSparse(hashes.data());
+    }
+
+    // 折叠：按新尺寸把位图分段后逐段按位或，得到尺寸为 newSize 的过滤器。
+    // 尺寸均为 2 的幂时 h & (newSize - 1) == (h & (size - 1)) & (newSize - 1)，折叠结果与用 newSize 重新写入完全一致
+    BaseBloomFilter folded(const size_t newSize, const BitmapAllocOptions& options = {}) const {
+        if (newSize == 0 || (newSize & (newSize - 1)) != 0 || newSize > bloomFilterSize) {
+            throw std::invalid_argument("Fold target size must be a power of 2 not larger than the current size");
+        }
+        BaseBloomFilter result(newSize, hashFunctionNum, options);
+        result.msgNum = msgNum;
+        if (!isDense()) {
+            // 稀疏窗口：逐个折叠置位位置
+            sparse->forEach([&](const uint64_t bit) { result.insertBit(bit & result.bloomFilterMask); });
+            if (!result.isDense() && result.setBitNum > result.sparseLimit) result.densify();
+            return result;
+        }
+
+        if (!result.isDense()) result.densify();
+        const uint64_t* src = replicas[0].data();
+        uint64_t* dst = result.replicas[0].data();
+        const size_t srcWords = wordNum(bloomFilterSize);
+        const size_t dstWordMask = wordNum(newSize) - 1;
+        for (size_t w = 0; w < srcWords; ++w) dst[w & dstWordMask] |= src[w];
+
+        // 不足 64 位的尺寸：在字内继续对半折叠
+        for (size_t bits = std::min<size_t>(bloomFilterSize, 64); bits > newSize; bits /= 2) {
+            dst[0] = (dst[0] | (dst[0] >> (bits / 2))) & ((1ull << (bits / 2)) - 1);
+        }
+
+        for (size_t w = 0; w <= dstWordMask; ++w) result.setBitNum += std::popcount(dst[w]);
+        for (size_t i = 1; i < result.replicas.size(); ++i) {
+            std::memcpy(result.replicas[i].data(), dst, (dstWordMask + 1) * sizeof(uint64_t));
+        }
+        return result;
+    }
+
+    // 序列化：尺寸、k、计数，随后是位图（已转换）或置位位置列表（稀疏）
+    void serialize(std::string& out) const {
+        appendPod<uint64_t>(out, bloomFilterSize);
+        appendPod<uint32_t>(out, hashFunctionNum);
+        appendPod<uint64_t>(out, msgNum);
+        appendPod<uint8_t>(out, isDense());
+        if (isDense()) {
+            appendBytes(out, replicas[0].data(), wordNum(bloomFilterSize) * sizeof(uint64_t));
+        } else {
+            appendPod<uint64_t>(out, sparse->size());
+            sparse->forEach([&](const uint64_t bit) { appendPod<uint64_t>(out, bit); });
+        }
+    }
+
+    static BaseBloomFilter deserialize(std::string_view& in, const BitmapAllocOptions& options = {}) {
+        const auto size = readPod<uint64_t>(in);
+        const auto k = readPod<uint32_t>(in);
+        BaseBloomFilter result(size, k, options);
+        result.msgNum = readPod<uint64_t>(in);
+        if (readPod<uint8_t>(in)) {
+            if (!result.isDense()) result.densify();
+            uint64_t* words = result.replicas[0].data();
+            readBytes(in, words, wordNum(size) * sizeof(uint64_t));
+            for (size_t w = 0; w < wordNum(size); ++w) result.setBitNum += std::popcount(words[w]);
+            for (size_t i = 1; i < result.replicas.size(); ++i) {
+                std::memcpy(result.replicas[i].data(), words, wordNum(size) * sizeof(uint64_t));
+            }
+        } else {
+            for (auto n = readPod<uint64_t>(in); n > 0; --n) {
+                const auto bit = readPod<uint64_t>(in);
+                if (bit >= size) throw std::runtime_error("Bloom filter bit position out of range");
+                result.insertBit(bit);
+            }
+            if (!result.isDense() && result.setBitNum > result.sparseLimit) result.densify();
+        }
+        return result;
+    }
+
+    size_t getSize() const { return bloomFilterSize; }
+
+    // 位图使用的页类型与副本数（稀疏窗口为 "sparse"，没有位图副本）
+    const char* getBacking() const { return isDense() ? replicas[0].backing() : "sparse"; }
+    size_t getReplicaNum() const { return replicas.size(); }
+
+    bool isDense() const { return dense.value.load(std::memory_order_acquire); }
+
+    // 释放已转换为位图的窗口遗留的稀疏集合。转换时可能仍有查询在读取它，
+    // 因此由写入方在之后的安全时机（如下一次轮换，持有 filtersMtx）调用
+    void releaseSparse() {
+        if (isDense()) sparse.reset();
+    }
+
+    // 已分配的内存字节数（位图副本与稀疏集合）
+    size_t getMemoryBytes() const {
+        size_t bytes = sparse ? sparse->memoryBytes() : 0;
+        for (const auto& replica : replicas) bytes += replica.size();
+        return bytes;
     }
 
+    unsigned int getHashFunctionNum() const { return hashFunctionNum; }
+
     unsigned long getMsgNum() const { return msgNum; }
 
+    // 已置位的比特数
+    size_t getSetBitNum() const { return setBitNum; }
+
+    // 填充率：置位比特数 / 布隆过滤器尺寸
+    double getFillRatio() const { return static_cast<double>(setBitNum) / static_cast<double>(bloomFilterSize); }
+
+    // 估计误判率：k 个比特恰好都被置位的概率，即 fillRatio^k
+    double getEstimatedFpr() const { return std::pow(getFillRatio(), hashFunctionNum); }
+
+    // 估计已插入的不同元素个数（Swamidass & Baldi）：n ≈ -(m / k) * ln(1 - X / m)
+    double getEstimatedItemNum() const {
+        if (setBitNum >= bloomFilterSize) return std::numeric_limits<double>::infinity();
+        return -static_cast<double>(bloomFilterSize) / hashFunctionNum * std::log1p(-getFillRatio());
+    }
+
 private:
-    std::vector<bool> bloomFilter;
+    using AddKernel = void (BaseBloomFilter::*)(const uint64_t*);
+    using ContainsKernel = bool (BaseBloomFilter::*)(const uint64_t*) const;
+
+    // 可随过滤器移动的原子标志（移动只发生在写入方持锁时）
+    struct MovableFlag {
+        std::atomic<bool> value{false};
+
+        MovableFlag() = default;
+        MovableFlag(MovableFlag&& other) noexcept : value(other.value.load(std::memory_order_relaxed)) {}
+
+        MovableFlag& operator=(MovableFlag&& other) noexcept {
+            value.store(other.value.load(std::memory_order_relaxed), std::memory_order_release);
+            return *this;
+        }
+    };
+
+    std::vector<BitmapBuffer> replicas; // replicas[i] 位于 NUMA 节点 i；未开启副本时只有一份，稀疏窗口为空
+    std::unique_ptr<SparseBitSet> sparse; // 稀疏窗口的置位位置；转换为位图后保留到 releaseSparse()，供仍在读取的查询使用
+    MovableFlag dense; // 位图已分配并填充完毕，查询改用位图内核
+    BitmapAllocOptions allocOptions;
+    size_t sparseLimit = 0; // 稀疏形式允许的最大置位比特数
     size_t bloomFilterSize = 0;
+    size_t bloomFilterMask = 0; // 尺寸为 2 的幂，取模即按位与
     unsigned int hashFunctionNum = 0;
     unsigned long msgNum = 0;
+    size_t setBitNum = 0;
+    AddKernel addKernel = nullptr;
+    ContainsKernel containsKernel = nullptr;
+
+    static size_t wordNum(const size_t bits) { return std::max<size_t>(bits / 64, 1); }
+
+    void allocateReplicas() {
+        const size_t bytes = wordNum(bloomFilterSize) * sizeof(uint64_t);
+        const int replicaNum = allocOptions.numaReplicas ? NumaTopology::instance().nodeCount() : 1;
+        replicas.reserve(replicaNum);
+        for (int node = 0; node < replicaNum; ++node) {
+            replicas.emplace_back(bytes, allocOptions.hugePages, replicaNum > 1 ? node : -1);
+        }
+    }
+
+    // 稀疏 → 位图：写入全部置位位置后再发布，查询看到 dense 时位图已完整
+    void densify() {
+        allocateReplicas();
+        sparse->forEach([&](const uint64_t bit) {
+            for (auto& replica : replicas) replica.data()[bit >> 6] |= 1ull << (bit & 63);
+        });
+        dense.value.store(true, std::memory_order_release);
+    }
+
+    void insertBit(const size_t bit) {
+        if (isDense()) setBit(bit);
+        else if (sparse->insert(bit)) ++setBitNum;
+    }
 
-    // 通过哈希函数计算下标
-    std::vector<size_t> calcHashIndices(const std::string& key) const {
-        std::vector<size_t> indices(hashFunctionNum);
+    void addSparse(const uint64_t* hashes) {
         for (unsigned int i = 0; i < hashFunctionNum; ++i) {
-            const size_t hashResult = hashSHA256(key + "_" + std::to_string(i));
-            indices[i] = hashResult;
+            if (sparse->insert(hashes[i] & bloomFilterMask)) ++setBitNum;
         }
-        return indices;
+        if (setBitNum > sparseLimit) densify();
     }
 
-    // 哈希函数SHA256
-    static size_t hashSHA256(const std::string& key) {
-        // SHA256散列算法输出32字节长度的哈希值
-        SHA256::BYTE buf[SHA256_BLOCK_SIZE];
-        SHA256::SHA256_CTX ctx;
+    bool containsSparse(const uint64_t* hashes) const {
+        for (unsigned int i = 0; i < hashFunctionNum; ++i) {
+            if (!sparse->contains(hashes[i] & bloomFilterMask)) return false;
+        }
+        return true;
+    }
+
+    // 读取当前线程所在 NUMA 节点上的副本
+    const uint64_t* localWords() const {
+        return replicas.size() > 1
+                   ? replicas[NumaTopology::instance().currentNode() % replicas.size()].data()
+                   : replicas[0].data();
+    }
+
+    static bool testBit(const uint64_t* words, const size_t bit) { return words[bit >> 6] & (1ull << (bit & 63)); }
+
+    void setBit(const size_t bit) {
+        const uint64_t mask = 1ull << (bit & 63);
+        // 仅当比特由 0 变为 1 时计数，维护真实的置位数；写入扇出到所有 NUMA 副本
+        if (!(replicas[0].data()[bit >> 6] & mask)) {
+            for (auto& replica : replicas) replica.data()[bit >> 6] |= mask;
+            ++setBitNum;
+        }
+    }
 
-        SHA256::sha256_init(&ctx);
-        SHA256::sha256_update(&ctx, reinterpret_cast<const SHA256::BYTE*>(key.c_str()), key.length());
-        SHA256::sha256_final(&ctx, buf);
+    // 编译期确定 k 的探测内核：循环完全展开，查询在第一个未置位的比特处短路返回
+    template<unsigned int K>
+    void addFixed(const uint64_t* hashes) {
+        [&]<size_t... I>(std::index_sequence<I...>) {
+            (setBit(hashes[I] & bloomFilterMask), ...);
+        }(std::make_index_sequence<K>{});
+    }
 
-        return reinterpret_cast<size_t>(buf);
+    template<unsigned int K>
+    bool containsFixed(const uint64_t* hashes) const {
+        const uint64_t* words = localWords();
+        return [&]<size_t... I>(std::index_sequence<I...>) {
+            return (testBit(words, hashes[I] & bloomFilterMask) && ...);
+        }(std::make_index_sequence<K>{});
+    }
+
+    void addGeneric(const uint64_t* hashes) {
+        for (unsigned int i = 0; i < hashFunctionNum; ++i) setBit(hashes[i] & bloomFilterMask);
+    }
+
+    bool containsGeneric(const uint64_t* hashes) const {
+        const uint64_t* words = localWords();
+        for (unsigned int i = 0; i < hashFunctionNum; ++i) {
+            if (!testBit(words, hashes[i] & bloomFilterMask)) return false;
+        }
+        return true;
+    }
+
+    // 按哈希函数个数选择探测内核（构造时确定，参数调整会重建过滤器并重新选择）
+    void selectKernels() {
+        static constexpr auto addKernels = []<size_t... I>(std::index_sequence<I...>) {
+            return std::array<AddKernel, sizeof...(I)>{&BaseBloomFilter::addFixed<I + 1>...};
+        }(std::make_index_sequence<MAX_SPECIALIZED_HASH_NUM>{});
+        static constexpr auto containsKernels = []<size_t... I>(std::index_sequence<I...>) {
+            return std::array<ContainsKernel, sizeof...(I)>{&BaseBloomFilter::containsFixed<I + 1>...};
+        }(std::make_index_sequence<MAX_SPECIALIZED_HASH_NUM>{});
+
+        if (hashFunctionNum <= MAX_SPECIALIZED_HASH_NUM) {
+            addKernel = addKernels[hashFunctionNum - 1];
+            containsKernel = containsKernels[hashFunctionNum - 1];
+        } else {
+            addKernel = &BaseBloomFilter::addGeneric;
+            containsKernel = &BaseBloomFilter::containsGeneric;
+        }
     }
 };
 
@@ -0,0 +1,273 @@
+#ifndef BINARY_FUSE_FILTER_HPP
+#define BINARY_FUSE_FILTER_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "WindowFilter.hpp"
+#include "../Utils/BinaryIO.hpp"
+
+// 只读的 3 路二元融合过滤器（Graf & Lemire, Binary Fuse Filters: Fast and Smaller Than Xor Filters）：
+// 16 位指纹每个元素约 18 比特、误判率 2^-16；8 位指纹约 9 比特、误判率 2^-8。查询固定读取 3 个相邻段中的指纹。
+// 由一组原始哈希值（BaseBloomFilter::hashKey 的第一个哈希值）一次性构建，构建后不能再写入，用于不再接收写入的窗口。
+template<typename Fingerprint>
+class BasicBinaryFuseFilter final : public WindowFilter {
+public:
+    static_assert(std::is_same_v<Fingerprint, uint8_t> || std::is_same_v<Fingerprint, uint16_t>);
+
+    static constexpr unsigned int HASH_NUM = 1;
+    static constexpr unsigned int FINGERPRINT_BITS = sizeof(Fingerprint) * 8;
+    static constexpr Tag TAG = FINGERPRINT_BITS == 16 ? Tag::BinaryFuse : Tag::BinaryFuse8;
+
+    BasicBinaryFuseFilter() { configure(0); }
+
+    // 由原始哈希值构建（重复值会被去除）；构建失败时抛出异常
+    explicit BasicBinaryFuseFilter(std::vector<uint64_t> keys) {
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+        configure(keys.size());
+        populate(keys);
+    }
+
+    void add(const BloomHashes &hashes) override {
+        (void) hashes;
+        throw std::logic_error("Binary fuse filter is immutable");
+    }
+
+    bool contains(const BloomHashes &hashes) const override {
+        if (itemNum == 0) return false;
+        const uint64_t hash = mix(hashes.data()[0], seed);
+        uint32_t h0, h1, h2;
+        positions(hash, h0, h1, h2);
+        return (fingerprint(hash) ^ fingerprints[h0] ^ fingerprints[h1] ^ fingerprints[h2]) == 0;
+    }
+
+    unsigned int requiredHashNum() const override { return HASH_NUM; }
+
+    void clear() override {
+        configure(0);
+        itemNum = 0;
+    }
+
+    void serialize(std::string &out) const override {
+        appendPod(out, TAG);
+        appendPod<uint64_t>(out, itemNum);
+        appendPod<uint64_t>(out, seed);
+        appendBytes(out, fingerprints.data(), fingerprints.size() * sizeof(Fingerprint));
+    }
+
+    // 读取 serialize 写出的数据（不含类型标识字节）
+    static std::unique_ptr<BasicBinaryFuseFilter> deserialize(std::string_view &in) {
+        auto result = std::make_unique<BasicBinaryFuseFilter>();
+        const auto num = readPod<uint64_t>(in);
+        if (num > UINT32_MAX) throw std::runtime_error("Invalid binary fuse filter size");
+        result->configure(static_cast<uint32_t>(num));
+        result->itemNum = num;
+        result->seed = readPod<uint64_t>(in);
+        readBytes(in, result->fingerprints.data(), result->fingerprints.size() * sizeof(Fingerprint));
+        return result;
+    }
+
+    // 指纹数组的比特数
+    size_t getSize() const override { return fingerprints.size() * FINGERPRINT_BITS; }
+
+    size_t getMemoryBytes() const override { return fingerprints.size() * sizeof(Fingerprint); }
+
+    unsigned long getMsgNum() const override { return itemNum; }
+
+    size_t getSetBitNum() const override { return itemNum; }
+
+    // 元素个数 / 指纹槽位数
+    double getFillRatio() const override {
+        return fingerprints.empty() ? 0 : static_cast<double>(itemNum) / static_cast<double>(fingerprints.size());
+    }
+
+    double getEstimatedFpr() const override { return itemNum == 0 ? 0 : std::ldexp(1.0, -static_cast<int>(FINGERPRINT_BITS)); }
+
+    double getEstimatedItemNum() const override { return static_cast<double>(itemNum); }
+
+    const char *getBacking() const override { return "heap"; }
+
+private:
+    static constexpr unsigned int ARITY = 3;
+    static constexpr unsigned int MAX_ITERATIONS = 100;
+
+    std::vector<Fingerprint> fingerprints;
+    size_t itemNum = 0;
+    uint64_t seed = 0;
+    uint32_t segmentLength = 0;
+    uint32_t segmentLengthMask = 0;
+    uint32_t segmentCount = 0;
+    uint32_t segmentCountLength = 0;
+
+    static uint64_t murmur64(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ull;
+        h ^= h >> 33;
+        return h;
+    }
+
+    static uint64_t mix(const uint64_t key, const uint64_t seed) { return murmur64(key + seed); }
+
+    static uint64_t splitmix64(uint64_t &state) {
+        uint64_t z = state += 0x9e3779b97f4a7c15ull;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    static uint64_t mulhi(const uint64_t a, const uint64_t b) {
+#if defined(_MSC_VER)
+        return __umulh(a, b);
+#else
+        return static_cast<uint64_t>((static_cast<unsigned __int128>(a) * b) >> 64);
+#endif
+    }
+
+    static Fingerprint fingerprint(const uint64_t hash) { return static_cast<Fingerprint>(hash ^ (hash >> 32)); }
+
+    // 元素落在连续 3 个段中，各段内的偏移取自哈希值的不同比特
+    void positions(const uint64_t hash, uint32_t &h0, uint32_t &h1, uint32_t &h2) const {
+        h0 = static_cast<uint32_t>(mulhi(hash, segmentCountLength));
+        h1 = h0 + segmentLength;
+        h2 = h1 + segmentLength;
+        h1 ^= static_cast<uint32_t>(hash >> 18) & segmentLengthMask;
+        h2 ^= static_cast<uint32_t>(hash) & segmentLengthMask;
+    }
+
+    uint32_t position(const unsigned int index, const uint64_t hash) const {
+        uint32_t h0, h1, h2;
+        positions(hash, h0, h1, h2);
+        return index == 0 ? h0 : index == 1 ? h1 : h2;
+    }
+
+    // 按元素个数确定段长度与段数（参数取自论文的参考实现）
+    void configure(const size_t size) {
+        segmentLength = size == 0 ? 4 : 1u << static_cast<int>(std::floor(std::log(static_cast<double>(size)) / std::log(3.33) + 2.25));
+        segmentLength = std::min<uint32_t>(segmentLength, 1u << 18);
+        segmentLengthMask = segmentLength - 1;
+        const double sizeFactor = size <= 1 ? 0 : std::max(1.125, 0.875 + 0.25 * std::log(1000000.0) / std::log(static_cast<double>(size)));
+        const auto capacity = static_cast<size_t>(std::round(static_cast<double>(size) * sizeFactor));
+        const size_t initSegmentCount = (capacity + segmentLength - 1) / segmentLength;
+        segmentCount = initSegmentCount <= ARITY - 1 ? 1 : static_cast<uint32_t>(initSegmentCount - (ARITY - 1));
+        segmentCountLength = segmentCount * segmentLength;
+        fingerprints.assign(static_cast<size_t>(segmentCount + ARITY - 1) * segmentLength, 0);
+    }
+
+    // 构建：按段排序后剥离（peeling）3-超图，再按剥离的逆序写入指纹
+    void populate(const std::vector<uint64_t> &keys) {
+        const size_t size = keys.size();
+        itemNum = size;
+        if (size == 0) return;
+        const size_t capacity = fingerprints.size();
+        std::vector<uint64_t> reverseOrder(size + 1, 0);
+        std::vector<uint32_t> alone(capacity);
+        std::vector<uint8_t> t2count(capacity, 0);
+        std::vector<uint8_t> reverseH(size);
+        std::vector<uint64_t> t2hash(capacity, 0);
+
+        unsigned int blockBits = 1;
+        while ((1u << blockBits) < segmentCount) ++blockBits;
+        const size_t block = size_t{1} << blockBits;
+        std::vector<size_t> startPos(block);
+        uint32_t h012[5];
+
+        uint64_t rngCounter = 0x726b2b9d438b9d4dull;
+        seed = splitmix64(rngCounter);
+        reverseOrder[size] = 1;
+        size_t stackSize = 0;
+        for (unsigned int loop = 0;; ++loop) {
+            if (loop + 1 > MAX_ITERATIONS) throw std::runtime_error("Failed to build binary fuse filter");
+            for (size_t i = 0; i < block; ++i) startPos[i] = (i * size) >> blockBits;
+
+            // 按所在段分桶，使后续访问局部化
+            for (size_t i = 0; i < size; ++i) {
+                const uint64_t hash = mix(keys[i], seed);
+                size_t segmentIndex = hash >> (64 - blockBits);
+                while (reverseOrder[startPos[segmentIndex]] != 0) segmentIndex = (segmentIndex + 1) & (block - 1);
+                reverseOrder[startPos[segmentIndex]] = hash;
+                ++startPos[segmentIndex];
+            }
+
+            bool error = false;
+            for (size_t i = 0; i < size; ++i) {
+                const uint64_t hash = reverseOrder[i];
+                uint32_t h0, h1, h2;
+                positions(hash, h0, h1, h2);
+                t2count[h0] += 4;
+                t2hash[h0] ^= hash;
+                t2count[h1] += 4;
+                t2count[h1] ^= 1;
+                t2hash[h1] ^= hash;
+                t2count[h2] += 4;
+                t2count[h2] ^= 2;
+                t2hash[h2] ^= hash;
+                // 计数器溢出（某位置上的元素过多）时换种子重试
+                error = error || t2count[h0] < 4 || t2count[h1] < 4 || t2count[h2] < 4;
+            }
+
+            if (!error) {
+                size_t queueSize = 0;
+                for (uint32_t i = 0; i < capacity; ++i) {
+                    alone[queueSize] = i;
+                    queueSize += (t2count[i] >> 2) == 1 ? 1 : 0;
+                }
+                stackSize = 0;
+                while (queueSize > 0) {
+                    const uint32_t index = alone[--queueSize];
+                    if ((t2count[index] >> 2) != 1) continue;
+                    const uint64_t hash = t2hash[index];
+                    h012[1] = position(1, hash);
+                    h012[2] = position(2, hash);
+                    h012[3] = position(0, hash);
+                    h012[4] = h012[1];
+                    const uint8_t found = t2count[index] & 3;
+                    reverseH[stackSize] = found;
+                    reverseOrder[stackSize] = hash;
+                    ++stackSize;
+                    for (const unsigned int offset: {1u, 2u}) {
+                        const uint32_t other = h012[found + offset];
+                        alone[queueSize] = other;
+                        queueSize += (t2count[other] >> 2) == 2 ? 1 : 0;
+                        t2count[other] -= 4;
+                        t2count[other] ^= static_cast<uint8_t>((found + offset) % 3);
+                        t2hash[other] ^= hash;
+                    }
+                }
+                if (stackSize == size) break;
+            }
+
+            std::fill(reverseOrder.begin(), reverseOrder.begin() + static_cast<std::ptrdiff_t>(size), 0);
+            std::fill(t2count.begin(), t2count.end(), 0);
+            std::fill(t2hash.begin(), t2hash.end(), 0);
+            seed = splitmix64(rngCounter);
+        }
+
+        for (size_t i = stackSize; i-- > 0;) {
+            const uint64_t hash = reverseOrder[i];
+            const uint8_t found = reverseH[i];
+            positions(hash, h012[0], h012[1], h012[2]);
+            h012[3] = h012[0];
+            h012[4] = h012[1];
+            fingerprints[h012[found]] = fingerprint(hash) ^ fingerprints[h012[found + 1]] ^ fingerprints[h012[found + 2]];
+        }
+    }
+};
+
+using BinaryFuseFilter = BasicBinaryFuseFilter<uint16_t>;
+using BinaryFuse8Filter = BasicBinaryFuseFilter<uint8_t>;
+
+#endif //BINARY_FUSE_FILTER_HPP
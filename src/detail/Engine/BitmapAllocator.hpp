@@ -0,0 +1,303 @@
+#ifndef BITMAP_ALLOCATOR_HPP
+#define BITMAP_ALLOCATOR_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN // 避免引入 winsock.h 与 asio 使用的 winsock2.h 冲突
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "../Utils/ConfigReader.hpp"
+
+// 布隆过滤器位图的大页策略
+enum class HugePagePolicy {
+    Off, // 普通 4 KB 页
+    Thp, // 透明大页（madvise(MADV_HUGEPAGE)）
+    HugeTlb, // 预留大页（MAP_HUGETLB），需预先配置 vm.nr_hugepages
+    Auto // 依次尝试 HugeTlb、Thp、Off
+};
+
+struct BitmapAllocOptions {
+    HugePagePolicy hugePages = HugePagePolicy::Auto;
+    bool numaReplicas = false; // 每个 NUMA 节点保存一份位图副本，查询读本地副本，写入同时写所有副本
+    double sparseMaxFill = 0.001; // 置位比特占比不超过该值时只记录置位位置，不分配位图；0 表示始终使用位图
+};
+
+// 从配置中读取：bloom_filter_huge_pages = auto | hugetlb | thp | off，bloom_filter_numa_replicas = on | off，
+// bloom_filter_sparse_max_fill = 稀疏表示的填充率上限
+inline BitmapAllocOptions parseBitmapAllocOptions(const std::map<std::string, std::string> &config) {
+    BitmapAllocOptions options;
+    const std::string hugePages = getConfigOrDefault(config, "bloom_filter_huge_pages", "auto");
+    if (hugePages == "auto") options.hugePages = HugePagePolicy::Auto;
+    else if (hugePages == "hugetlb") options.hugePages = HugePagePolicy::HugeTlb;
+    else if (hugePages == "thp") options.hugePages = HugePagePolicy::Thp;
+    else if (hugePages == "off") options.hugePages = HugePagePolicy::Off;
+    else throw std::invalid_argument("Invalid bloom_filter_huge_pages: " + hugePages);
+
+    const std::string replicas = getConfigOrDefault(config, "bloom_filter_numa_replicas", "off");
+    if (replicas != "on" && replicas != "off") throw std::invalid_argument("Invalid bloom_filter_numa_replicas: " + replicas);
+    options.numaReplicas = replicas == "on";
+
+    options.sparseMaxFill = std::stod(getConfigOrDefault(config, "bloom_filter_sparse_max_fill", "0.001"));
+    if (options.sparseMaxFill < 0 || options.sparseMaxFill >= 1) {
+        throw std::invalid_argument("bloom_filter_sparse_max_fill must be in [0, 1)");
+    }
+    return options;
+}
+
+// NUMA 拓扑：节点数与 CPU → 节点映射（Linux 读取 sysfs，其他平台视为单节点）
+class NumaTopology {
+public:
+    static const NumaTopology &instance() {
+        static const NumaTopology topology;
+        return topology;
+    }
+
+    int nodeCount() const { return nodeNum; }
+
+    // 当前线程所在 CPU 的 NUMA 节点（线程未绑核时随调度迁移而变化）
+    int currentNode() const {
+        if (nodeNum <= 1) return 0;
+#if defined(_WIN32)
+        PROCESSOR_NUMBER processor;
+        GetCurrentProcessorNumberEx(&processor);
+        USHORT node = 0;
+        if (!GetNumaProcessorNodeEx(&processor, &node)) return 0;
+        return std::min<int>(node, nodeNum - 1);
+#else
+        const int cpu = sched_getcpu();
+        if (cpu < 0 || static_cast<size_t>(cpu) >= cpuToNode.size()) return 0;
+        return cpuToNode[cpu];
+#endif
+    }
+
+private:
+    int nodeNum = 1;
+    std::vector<int> cpuToNode;
+
+    NumaTopology() {
+#if defined(_WIN32)
+        ULONG highest = 0;
+        if (GetNumaHighestNodeNumber(&highest)) nodeNum = static_cast<int>(highest) + 1;
+#else
+        const std::vector<int> nodes = parseCpuList(readFile("/sys/devices/system/node/online"));
+        if (nodes.empty()) return;
+        nodeNum = *std::max_element(nodes.begin(), nodes.end()) + 1;
+        for (const int node: nodes) {
+            for (const int cpu: parseCpuList(readFile("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"))) {
+                if (static_cast<size_t>(cpu) >= cpuToNode.size()) cpuToNode.resize(cpu + 1, 0);
+                cpuToNode[cpu] = node;
+            }
+        }
+#endif
+    }
+
+    static std::string readFile(const std::string &path) {
+        std::ifstream file(path);
+        std::string content;
+        std::getline(file, content);
+        return content;
+    }
+
+    // 解析形如 "0-3,8,10-11" 的列表
+    static std::vector<int> parseCpuList(const std::string &list) {
+        std::vector<int> result;
+        std::istringstream iss(list);
+        for (std::string range; std::getline(iss, range, ',');) {
+            if (range.empty()) continue;
+            const auto dash = range.find('-');
+            const int first = std::stoi(range.substr(0, dash));
+            const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int i = first; i <= last; ++i) result.push_back(i);
+        }
+        return result;
+    }
+};
+
+// 位图内存块：匿名映射，按策略使用大页并可绑定到指定 NUMA 节点；内容初始为零，只可移动不可复制
+class BitmapBuffer {
+public:
+    static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    BitmapBuffer() = default;
+
+    // numaNode < 0 表示不绑定节点
+    BitmapBuffer(const size_t bytes, const HugePagePolicy policy, const int numaNode = -1) {
+        if (bytes == 0) throw std::invalid_argument("Bitmap size cannot be zero");
+        // 不足一个大页的小位图没有必要使用大页
+        if (bytes < HUGE_PAGE_SIZE) {
+            allocate(bytes, HugePagePolicy::Off, numaNode);
+        } else if (policy == HugePagePolicy::Auto) {
+            if (!allocate(bytes, HugePagePolicy::HugeTlb, numaNode) && !allocate(bytes, HugePagePolicy::Thp, numaNode)) {
+                allocate(bytes, HugePagePolicy::Off, numaNode);
+            }
+        } else {
+            allocate(bytes, policy, numaNode);
+        }
+        if (!ptr) {
+            throw std::runtime_error("Failed to allocate " + std::to_string(bytes) + " bytes for bloom filter bitmap" +
+                                     (policy == HugePagePolicy::HugeTlb ? " (no free hugetlb pages, check vm.nr_hugepages)" : ""));
+        }
+    }
+
+    BitmapBuffer(const BitmapBuffer &) = delete;
+
+    BitmapBuffer &operator=(const BitmapBuffer &) = delete;
+
+    BitmapBuffer(BitmapBuffer &&other) noexcept { swap(other); }
+
+    BitmapBuffer &operator=(BitmapBuffer &&other) noexcept {
+        if (this != &other) {
+            release();
+            swap(other);
+        }
+        return *this;
+    }
+
+    ~BitmapBuffer() { release(); }
+
+    uint64_t *data() const { return static_cast<uint64_t *>(ptr); }
+
+    size_t size() const { return length; }
+
+    // 实际使用的页类型：hugetlb / thp / 4k
+    const char *backing() const { return backingName; }
+
+private:
+    void *ptr = nullptr;
+    size_t length = 0; // 向系统申请的字节数（按页对齐）
+    const char *backingName = "4k";
+#if !defined(_WIN32)
+    void *mapBase = nullptr; // 为对齐到大页边界多映射的区域起点
+    size_t mapLength = 0;
+#endif
+
+    void swap(BitmapBuffer &other) noexcept {
+        std::swap(ptr, other.ptr);
+        std::swap(length, other.length);
+        std::swap(backingName, other.backingName);
+#if !defined(_WIN32)
+        std::swap(mapBase, other.mapBase);
+        std::swap(mapLength, other.mapLength);
+#endif
+    }
+
+    static size_t roundUp(const size_t value, const size_t align) { return (value + align - 1) / align * align; }
+
+#if defined(_WIN32)
+    bool allocate(const size_t bytes, const HugePagePolicy policy, const int numaNode) {
+        DWORD type = MEM_RESERVE | MEM_COMMIT;
+        size_t size = roundUp(bytes, 4096);
+        // Windows 没有透明大页，Thp 与 HugeTlb 均尝试大页（需要 SeLockMemoryPrivilege）
+        if (policy != HugePagePolicy::Off) {
+            const size_t largePage = GetLargePageMinimum();
+            if (largePage == 0) return false;
+            size = roundUp(bytes, largePage);
+            type |= MEM_LARGE_PAGES;
+        }
+        ptr = numaNode >= 0
+                  ? VirtualAllocExNuma(GetCurrentProcess(), nullptr, size, type, PAGE_READWRITE, numaNode)
+                  : VirtualAlloc(nullptr, size, type, PAGE_READWRITE);
+        if (!ptr) return false;
+        length = size;
+        backingName = policy == HugePagePolicy::Off ? "4k" : "large-pages";
+        return true;
+    }
+
+    void release() {
+        if (ptr) VirtualFree(ptr, 0, MEM_RELEASE);
+        ptr = nullptr;
+        length = 0;
+    }
+#else
+    bool allocate(const size_t bytes, const HugePagePolicy policy, const int numaNode) {
+        void *base = MAP_FAILED;
+        size_t size = roundUp(bytes, static_cast<size_t>(sysconf(_SC_PAGESIZE)));
+        size_t mapped = size;
+        void *aligned = nullptr;
+
+        if (policy == HugePagePolicy::HugeTlb) {
+#ifdef MAP_HUGETLB
+            size = mapped = roundUp(bytes, HUGE_PAGE_SIZE);
+            base = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            aligned = base;
+#endif
+        } else if (policy == HugePagePolicy::Thp) {
+            // 透明大页要求 2 MB 对齐：多映射一个大页后取对齐的起点
+            size = roundUp(bytes, HUGE_PAGE_SIZE);
+            mapped = size + HUGE_PAGE_SIZE;
+            base = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (base != MAP_FAILED) {
+                aligned = reinterpret_cast<void *>(roundUp(reinterpret_cast<uintptr_t>(base), HUGE_PAGE_SIZE));
+#ifdef MADV_HUGEPAGE
+                if (madvise(aligned, size, MADV_HUGEPAGE) != 0) {
+                    munmap(base, mapped);
+                    base = MAP_FAILED;
+                }
+#else
+                munmap(base, mapped);
+                base = MAP_FAILED;
+#endif
+            }
+        } else {
+            base = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            aligned = base;
+        }
+        if (base == MAP_FAILED) return false;
+
+        // 在首次访问前绑定 NUMA 节点，页面会在该节点上分配
+        if (numaNode >= 0) bindToNode(aligned, size, numaNode);
+
+        mapBase = base;
+        mapLength = mapped;
+        ptr = aligned;
+        length = size;
+        backingName = policy == HugePagePolicy::HugeTlb ? "hugetlb" : policy == HugePagePolicy::Thp ? "thp" : "4k";
+        return true;
+    }
+
+    static void bindToNode(void *addr, const size_t size, const int node) {
+#if defined(__linux__) && defined(SYS_mbind)
+        constexpr int MPOL_BIND_MODE = 2; // 与 <numaif.h> 中的 MPOL_BIND 一致，避免依赖 libnuma
+        std::vector<unsigned long> nodeMask(node / (8 * sizeof(unsigned long)) + 1, 0);
+        nodeMask[node / (8 * sizeof(unsigned long))] |= 1ul << (node % (8 * sizeof(unsigned long)));
+        // 绑定失败（如内核不支持 NUMA）时退化为默认的首次访问分配策略
+        syscall(SYS_mbind, addr, size, MPOL_BIND_MODE, nodeMask.data(), nodeMask.size() * 8 * sizeof(unsigned long) + 1, 0);
+#else
+        (void) addr;
+        (void) size;
+        (void) node;
+#endif
+    }
+
+    void release() {
+        if (mapBase) munmap(mapBase, mapLength);
+        mapBase = nullptr;
+        mapLength = 0;
+        ptr = nullptr;
+        length = 0;
+    }
+#endif
+};
+
+#endif //BITMAP_ALLOCATOR_HPP
@@ -0,0 +1,214 @@
+#ifndef CUCKOO_FILTER_HPP
+#define CUCKOO_FILTER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "BitmapAllocator.hpp"
+#include "SparseBitSet.hpp"
+#include "WindowFilter.hpp"
+#include "../Utils/BinaryIO.hpp"
+
+// 布谷鸟过滤器（Fan et al., Cuckoo Filter: Practically Better Than Bloom）：16 位指纹，每个桶 4 个槽位恰好占一个 64 位字，
+// 查询最多读取两个字（两次缓存行访问）。与布隆窗口使用相同的比特预算：m 比特对应 m / 64 个桶。
+// 写入由调用方串行化；查询无锁：空槽写入是单个字的原子存储，踢出链期间用序号（seqlock）标记，查询未命中时校验序号后重试，
+// 因此不会因为指纹正在搬移而漏报。踢出次数耗尽时，无处安放的指纹进入溢出集合，过滤器永远不会拒绝写入。
+class CuckooFilter final : public WindowFilter {
+public:
+    static constexpr unsigned int HASH_NUM = 1; // 桶下标与指纹都取自第一个原始哈希值
+    static constexpr unsigned int SLOT_NUM = 4;
+    static constexpr unsigned int FINGERPRINT_BITS = 16;
+    static constexpr unsigned int MAX_KICKS = 500;
+
+    explicit CuckooFilter(const size_t size, const BitmapAllocOptions &options = {})
+        : bucketNum(std::max<size_t>(size / 64, 1)), bucketMask(bucketNum - 1),
+          buckets(bucketNum * sizeof(uint64_t), options.hugePages), overflow(std::make_unique<SparseBitSet>()) {
+        if (size == 0) throw std::invalid_argument("The size of cuckoo filter cannot be zero");
+        if ((size & (size - 1)) != 0) throw std::invalid_argument("The size of a cuckoo filter must be a power of 2.");
+    }
+
+    void add(const BloomHashes &hashes) override {
+        const uint64_t h = hashes.data()[0];
+        const uint16_t fp = fingerprint(h);
+        const size_t i1 = h & bucketMask;
+        const size_t i2 = altIndex(i1, fp);
+        ++msgNum;
+        // 同一 token 重复撤回（或指纹与桶都相同的另一个 token）：查询已经会命中，无需再存一份
+        if (probe(i1, i2, fp)) return;
+        if (place(i1, fp) || place(i2, fp)) {
+            ++itemNum;
+            return;
+        }
+
+        // 踢出链：随机选择槽位交换指纹，被踢出的指纹移到它的另一个桶
+        const uint64_t v = version.load(std::memory_order_relaxed);
+        version.store(v + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        size_t i = nextRandom() & 1 ? i1 : i2;
+        uint16_t victim = fp;
+        bool placed = false;
+        for (unsigned int n = 0; n < MAX_KICKS && !placed; ++n) {
+            const unsigned int lane = nextRandom() % SLOT_NUM;
+            const uint64_t word = load(i);
+            const uint16_t evicted = static_cast<uint16_t>(word >> (lane * FINGERPRINT_BITS));
+            store(i, (word & ~(0xffffull << (lane * FINGERPRINT_BITS))) | static_cast<uint64_t>(victim) << (lane * FINGERPRINT_BITS));
+            victim = evicted;
+            i = altIndex(i, victim);
+            placed = place(i, victim);
+        }
+        if (!placed) {
+            overflow->insert(overflowKey(i, victim));
+            hasOverflow.store(true, std::memory_order_release);
+        }
+        version.store(v + 2, std::memory_order_release);
+        ++itemNum;
+    }
+
+    bool contains(const BloomHashes &hashes) const override {
+        const uint64_t h = hashes.data()[0];
+        const uint16_t fp = fingerprint(h);
+        const size_t i1 = h & bucketMask;
+        const size_t i2 = altIndex(i1, fp);
+        for (;;) {
+            const uint64_t v = version.load(std::memory_order_acquire);
+            if (v & 1) continue; // 踢出链进行中
+            // 命中的指纹一定在某一时刻存在于过滤器中，可以直接返回；只有未命中需要确认期间没有搬移
+            if (probe(i1, i2, fp)) return true;
+            if (hasOverflow.load(std::memory_order_acquire) && overflow->contains(overflowKey(i1, fp))) return true;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (version.load(std::memory_order_relaxed) == v) return false;
+        }
+    }
+
+    unsigned int requiredHashNum() const override { return HASH_NUM; }
+
+    void clear() override {
+        std::memset(buckets.data(), 0, bucketNum * sizeof(uint64_t));
+        overflow = std::make_unique<SparseBitSet>();
+        hasOverflow.store(false, std::memory_order_relaxed);
+        msgNum = 0;
+        itemNum = 0;
+    }
+
+    void serialize(std::string &out) const override {
+        appendPod(out, Tag::Cuckoo);
+        appendPod<uint64_t>(out, bucketNum);
+        appendPod<uint64_t>(out, msgNum);
+        appendPod<uint64_t>(out, itemNum);
+        appendBytes(out, buckets.data(), bucketNum * sizeof(uint64_t));
+        appendPod<uint64_t>(out, overflow->size());
+        overflow->forEach([&](const uint64_t key) { appendPod<uint64_t>(out, key); });
+    }
+
+    // 读取 serialize 写出的数据（不含类型标识字节）
+    static std::unique_ptr<CuckooFilter> deserialize(std::string_view &in, const BitmapAllocOptions &options) {
+        const auto num = readPod<uint64_t>(in);
+        if (num == 0 || num > (std::numeric_limits<size_t>::max() >> 6)) throw std::runtime_error("Invalid cuckoo filter size");
+        auto result = std::make_unique<CuckooFilter>(num * 64, options);
+        result->msgNum = readPod<uint64_t>(in);
+        result->itemNum = readPod<uint64_t>(in);
+        readBytes(in, result->buckets.data(), num * sizeof(uint64_t));
+        for (auto n = readPod<uint64_t>(in); n > 0; --n) {
+            result->overflow->insert(readPod<uint64_t>(in));
+            result->hasOverflow.store(true, std::memory_order_relaxed);
+        }
+        return result;
+    }
+
+    size_t getSize() const override { return bucketNum * 64; }
+
+    size_t getMemoryBytes() const override { return buckets.size() + overflow->memoryBytes(); }
+
+    unsigned long getMsgNum() const override { return msgNum; }
+
+    // 已存放的指纹数（含溢出集合）
+    size_t getSetBitNum() const override { return itemNum; }
+
+    // 装载率：已存放的指纹数 / 槽位数
+    double getFillRatio() const override {
+        return static_cast<double>(itemNum) / static_cast<double>(bucketNum * SLOT_NUM);
+    }
+
+    // 两个桶中平均有 2 * 4 * 装载率 个指纹参与比较，每个以 1 / (2^16 - 1) 的概率相同
+    double getEstimatedFpr() const override {
+        return -std::expm1(2 * SLOT_NUM * getFillRatio() * std::log1p(-1.0 / 65535));
+    }
+
+    double getEstimatedItemNum() const override { return static_cast<double>(itemNum); }
+
+    const char *getBacking() const override { return buckets.backing(); }
+
+private:
+    size_t bucketNum;
+    size_t bucketMask; // 桶数为 2 的幂
+    BitmapBuffer buckets; // 每个桶一个 64 位字，空槽为 0
+    std::unique_ptr<SparseBitSet> overflow; // 踢出失败的指纹：(较小的桶下标 << 16) | 指纹
+    std::atomic<bool> hasOverflow{false};
+    std::atomic<uint64_t> version{0}; // 奇数表示踢出链进行中
+    unsigned long msgNum = 0;
+    size_t itemNum = 0;
+    uint64_t randomState = 0x9e3779b97f4a7c15ull;
+
+    // 指纹取哈希值的高 16 位（与取自低位的桶下标相互独立），0 保留给空槽
+    static uint16_t fingerprint(const uint64_t h) {
+        const auto fp = static_cast<uint16_t>(h >> 48);
+        return fp == 0 ? 1 : fp;
+    }
+
+    // 部分键布谷鸟哈希：另一个桶只依赖当前桶与指纹，异或保证互为备选
+    size_t altIndex(const size_t index, const uint16_t fp) const { return (index ^ (fp * 0x5bd1e995ull)) & bucketMask; }
+
+    uint64_t overflowKey(const size_t index, const uint16_t fp) const {
+        return static_cast<uint64_t>(std::min(index, altIndex(index, fp))) << FINGERPRINT_BITS | fp;
+    }
+
+    uint64_t load(const size_t index) const {
+        return std::atomic_ref<uint64_t>(buckets.data()[index]).load(std::memory_order_relaxed);
+    }
+
+    void store(const size_t index, const uint64_t word) {
+        std::atomic_ref<uint64_t>(buckets.data()[index]).store(word, std::memory_order_relaxed);
+    }
+
+    // 桶中是否有等于 fp 的 16 位槽位（SWAR：异或后检测是否存在为零的 16 位段）
+    static bool hasFingerprint(const uint64_t word, const uint16_t fp) {
+        constexpr uint64_t LOW = 0x0001000100010001ull;
+        constexpr uint64_t HIGH = 0x8000800080008000ull;
+        const uint64_t x = word ^ (fp * LOW);
+        return ((x - LOW) & ~x & HIGH) != 0;
+    }
+
+    bool probe(const size_t i1, const size_t i2, const uint16_t fp) const {
+        return hasFingerprint(load(i1), fp) || hasFingerprint(load(i2), fp);
+    }
+
+    // 写入桶中的空槽
+    bool place(const size_t index, const uint16_t fp) {
+        const uint64_t word = load(index);
+        for (unsigned int lane = 0; lane < SLOT_NUM; ++lane) {
+            if (((word >> (lane * FINGERPRINT_BITS)) & 0xffff) == 0) {
+                store(index, word | static_cast<uint64_t>(fp) << (lane * FINGERPRINT_BITS));
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // xorshift64，只用于选择踢出的槽位
+    uint64_t nextRandom() {
+        randomState ^= randomState << 13;
+        randomState ^= randomState >> 7;
+        randomState ^= randomState << 17;
+        return randomState;
+    }
+};
+
+#endif //CUCKOO_FILTER_HPP
@@ -2,29 +2,97 @@
 #define BLACK_LIST_ENGINE_HPP
 
 #include <iostream>
+#include <algorithm>
 #include <vector>
 #include <cmath>
+#include <climits>
 #include <string>
 #include <chrono>
 #include <atomic>
 #include <thread>
 #include <set>
 #include <filesystem>
-#include "BaseBloomFilter.hpp"
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <fstream>
+#include <sstream>
+#include <tuple>
+#include "EngineSnapshot.hpp"
+#include "SubjectIndex.hpp"
+#include "WindowFilterFactory.hpp"
 #include "../Utils/ConfigReader.hpp"
 #include "../Utils/ThreadSafeQueue.hpp"
+#include "../Utils/EpochDomain.hpp"
+#include "../ShmExport/ShmFilterExport.hpp"
+#include "../Metrics/Metrics.hpp"
 
 
-inline std::vector<BaseBloomFilter> getNewFilters(const unsigned int &filtersNum,
-                                                  const unsigned int &bloomFilterSize,
-                                                  const unsigned int &hashFunctionNum) {
-    std::vector<BaseBloomFilter> newFilters;
+inline std::vector<std::unique_ptr<WindowFilter> > getNewFilters(const unsigned int &filtersNum,
+                                                                 const unsigned int &bloomFilterSize,
+                                                                 const unsigned int &hashFunctionNum,
+                                                                 const WindowFilterOptions &options) {
+    std::vector<std::unique_ptr<WindowFilter> > newFilters;
     newFilters.reserve(filtersNum);
-    for (unsigned int i = 0; i < filtersNum; ++i) { newFilters.emplace_back(bloomFilterSize, hashFunctionNum); }
+    for (unsigned int i = 0; i < filtersNum; ++i) {
+        newFilters.push_back(makeWindowFilter(bloomFilterSize, hashFunctionNum, options));
+    }
     return newFilters;
 }
 
-inline void printLogo(const float totalSize) {
+// 向上取整的整数除法（整数相除后再 std::ceil 不会向上取整）
+inline unsigned long ceilDiv(const unsigned long a, const unsigned long b) { return (a + b - 1) / b; }
+
+// SHA256 实现每个进程只选择一次：命名空间引擎与 C API 句柄共用同一个实现，选择不是线程安全的，
+// 不能在其他引擎计算哈希时再次切换。之后的引擎配置了不同的 sha256_backend 时报错
+inline void selectSha256Backend(const std::string &name) {
+    static std::mutex selectMtx;
+    static std::string selected;
+    std::lock_guard lock(selectMtx);
+    if (!selected.empty()) {
+        if (name != selected) {
+            throw std::invalid_argument("sha256_backend = " + name + " conflicts with " + selected +
+                                        " already selected in this process");
+        }
+        return;
+    }
+    if (!SHA256::sha256_select_backend(name.c_str())) {
+        throw std::invalid_argument("Unsupported sha256_backend on this CPU: " + name);
+    }
+    selected = name;
+}
+
+// 引擎日志的去向：为空时写到标准输出（错误写到标准错误），嵌入的库（C API）交给调用方的回调或丢弃。
+// 参数是一条完整的消息（不含末尾换行），可能从多个线程同时调用
+using EngineLogSink = std::function<void(const std::string &message)>;
+
+// 一条引擎日志：先在本地拼接，析构时整条交给 sink 或一次写到标准输出，多个线程的日志不会交错
+class EngineLogLine {
+public:
+    EngineLogLine(const EngineLogSink &_sink, const bool _error) : sink(_sink), error(_error) {}
+
+    ~EngineLogLine() {
+        if (sink) sink(stream.str());
+        else (error ? std::cerr : std::cout) << stream.str() << std::endl;
+    }
+
+    EngineLogLine(const EngineLogLine &) = delete;
+
+    EngineLogLine &operator=(const EngineLogLine &) = delete;
+
+    template<typename T>
+    EngineLogLine &operator<<(const T &value) {
+        stream << value;
+        return *this;
+    }
+
+private:
+    const EngineLogSink &sink;
+    bool error;
+    std::ostringstream stream;
+};
+
+inline void printLogo(EngineLogLine &&out, const float totalSize) {
     const auto logo = R"(
           ____  _                         ______ _ _ _
          |  _ \| |                       |  ____(_) | |
@@ -32,27 +100,78 @@ inline void printLogo(const float totalSize) {
          |  _ <| |/ _ \ / _ \| '_ ` _ \  |  __| | | | __/ _ \ '__/ __|
          | |_) | | (_) | (_) | | | | | | | |    | | | ||  __/ |  \__ \
          |____/|_|\___/ \___/|_| |_| |_| |_|    |_|_|\__\___|_|  |___/  )";
-    std::cout << logo;
-    std::cout << " Memory used: " << totalSize << " MBytes" << std::endl << std::endl;
+    out << logo << " Memory used: " << totalSize << " MBytes\n";
 }
 
 
 class Engine {
 public:
-    explicit Engine(const std::map<std::string, std::string> &_config) : config(_config) {
+    explicit Engine(const std::map<std::string, std::string> &_config, EngineLogSink _logSink = nullptr)
+        : config(_config), logSink(std::move(_logSink)) {
+        // 按签发者划分的命名空间引擎（由 EngineNamespaces 创建），指标带 namespace 标签
+        namespaceName = getConfigOrDefault(config, "engine_namespace", "");
+        logQueueMetric = namespaceName.empty()
+                             ? "revoker_log_queue_depth"
+                             : "revoker_log_queue_depth{namespace=\"" + namespaceName + "\"}";
+
+        // SHA256 实现默认按 CPU 特性自动选择（sha-ni / avx2 / scalar），可通过配置强制指定（每个进程只选择一次）
+        selectSha256Backend(getConfigOrDefault(config, "sha256_backend", "auto"));
+        log() << "[Engine] SHA256 backend: " << SHA256::sha256_backend();
+
+        // 窗口过滤器实现、位图内存（大页策略与 NUMA 副本），以及突发撤回时按需追加子过滤器（默认关闭）
+        filterOptions = parseWindowFilterOptions(config);
+        log() << "[Engine] Window filter: " << windowFilterKindName(filterOptions.kind);
+        const ScalingOptions &scalingOptions = filterOptions.scaling;
+        if (filterOptions.kind == WindowFilterKind::Bloom && scalingOptions.enabled) {
+            log() << "[Engine] Scalable bloom filters: fill threshold " << scalingOptions.fillThreshold <<
+                    ", growth " << scalingOptions.growth << ", tightening " << scalingOptions.tightening <<
+                    ", max stages " << scalingOptions.maxStages;
+        }
+
+        // 后台把窗口重建为只读的二元融合过滤器（默认关闭）
+        sealOptions = parseSealOptions(config);
+        if (sealOptions.enabled) {
+            auto line = log();
+            line << "[Engine] Window sealing: " << sealOptions.fingerprintBits << "-bit fingerprints, after each rotation";
+            if (sealOptions.interval > 0) line << " and every " << sealOptions.interval << " s";
+        }
+
+        // 同机网关直接探测的共享内存导出（默认关闭）
+        shmExportPath = getConfigOrDefault(config, "shm_export_path", "");
+
+        // 启动时使用的快照（revoker_build 离线构建或 saveSnapshot 保存），参数与 init 一致时代替完整的日志恢复
+        startupSnapshotPath = getConfigOrDefault(config, "startup_snapshot_path", "");
+
+        // 最后注册捕获 this 的指标回调：之前的步骤抛出异常时不会留下指向已销毁对象的回调
+        MetricsRegistry::instance().registerGaugeCallback(logQueueMetric, "Pending revoke log records",
+                                                          [this] { return static_cast<double>(logQueue.size()); });
     }
 
     ~Engine() {
-        // 停止周期轮换线程
+        MetricsRegistry::instance().unregisterGaugeCallback(logQueueMetric);
+
+        // 停止后台折叠线程与封存线程
+        stopFoldWorker();
+        stopSealWorker();
+
+        // 停止周期轮换线程（通知条件变量，使其立即退出等待）
         rotateFiltersRunFlag.store(false);
+        adjustFiltersCv.notify_all();
         if (rotateFiltersThread.joinable()) { rotateFiltersThread.join(); }
 
-        // 释放布隆过滤器
+        // 撤下共享内存导出，网关回退到 TCP 查询
+        if (shmExport) shmExport->remove();
+
+        // 释放布隆过滤器（此时已没有查询）
+        delete filterView.exchange(nullptr);
         filters.clear();
 
-        // 停止日志记录线程
+        // 停止日志记录线程（投递一条空消息唤醒阻塞中的日志线程）
         logRunFlag.store(false);
-        if (logThread.joinable()) { logThread.join(); }
+        if (logThread.joinable()) {
+            logQueue.enqueue({});
+            logThread.join();
+        }
     }
 
     void init(const unsigned int _maxJwtLifeTime, const unsigned int _rotationInterval, const size_t _bloomFilterSize,
@@ -67,18 +186,33 @@ public:
         hashFunctionNum = _hashFunctionNum;
 
         // 计算所需布隆过滤器的个数
-        filtersNum = std::ceil(maxJwtLifeTime / rotationInterval);
+        filtersNum = ceilDiv(maxJwtLifeTime, rotationInterval);
 
-        std::cout << "[Engine] Initializing bloom filter engine..." << std::endl;
+        log() << "[Engine] Initializing bloom filter engine...";
 
-        // 初始化过滤器
-        auto _filters = getNewFilters(filtersNum, bloomFilterSize, hashFunctionNum);
+        // 热重启：参数与旧进程交接的快照一致时直接还原；其次使用启动快照；否则从日志重建
+        if (!restoreHandoffSnapshot() && !restoreStartupSnapshot()) {
+            // 初始化过滤器
+            auto _filters = getNewFilters(filtersNum, bloomFilterSize, hashFunctionNum, filterOptions);
 
-        // 从日志中恢复记录到过滤器中
-        recoverFromLog(_filters);
+            // 从日志中恢复记录到过滤器、主体索引与共享内存导出中（此时还没有查询与写入）
+            SealKeyStore _sealKeys;
+            auto _shmExport = makeShmExport(maxJwtLifeTime, rotationInterval, bloomFilterSize, hashFunctionNum, filtersNum);
+            recoverFromLog(_filters, maxJwtLifeTime, rotationInterval, hashFunctionNum,
+                           sealOptions.enabled ? &_sealKeys : nullptr, &subjects, _shmExport.get());
 
-        filters.clear();
-        filters = _filters;
+            std::unique_lock lock(filtersMtx);
+            publishFilters(std::exchange(filters, std::move(_filters)));
+            resetSealState(std::move(_sealKeys));
+            replaceShmExport(std::move(_shmExport));
+            updateSubjectEntries();
+            lock.unlock();
+        }
+
+        // 启动横幅与窗口统计使用同一个按实际窗口占用统计的内存数字（封存线程启动前统计）
+        std::unique_lock lock(filtersMtx);
+        const float memoryUsed = static_cast<float>(printBitmapStorage()) / 1048576;
+        lock.unlock();
 
         // 启动周期轮换线程
         if (!rotateFiltersThread.joinable()) {
@@ -92,120 +226,563 @@ public:
             logThread = std::thread(&Engine::logWorker, this);
         }
 
-        printLogo(static_cast<float>(filtersNum * bloomFilterSize) / 8388608);
+        // 启动封存线程（启动后先封存一轮从日志恢复的窗口）
+        if (sealOptions.enabled && !sealThread.joinable()) {
+            sealRunFlag.store(true);
+            sealThread = std::thread(&Engine::sealWindowsWorker, this);
+        }
+
+        if (namespaceName.empty()) {
+            printLogo(log(), memoryUsed);
+        } else {
+            log() << "[Engine] Namespace " << namespaceName << " is ready, memory used: " << memoryUsed << " MBytes";
+        }
     }
 
-    // 重建布隆过滤器（布隆过滤器参数改变，需要重建）
+    // 调整布隆过滤器参数：仅缩小尺寸时在后台逐窗口折叠，否则重建并从日志重放
     void adjustFiltersParam(const unsigned int _maxJwtLifeTime, const unsigned int _rotationInterval,
                             const size_t _bloomFilterSize, const unsigned int _hashFunctionNum) {
-        maxJwtLifeTime = _maxJwtLifeTime;
-        rotationInterval = _rotationInterval;
-        bloomFilterSize = _bloomFilterSize;
-        hashFunctionNum = _hashFunctionNum;
+        // 停止尚未完成的后台折叠
+        stopFoldWorker();
 
-        // 计算所需布隆过滤器的个数
-        filtersNum = std::ceil(maxJwtLifeTime / rotationInterval);
+        log() << "[Engine] Adjust bloom filter engine...";
 
-        std::cout << "[Engine] Adjust bloom filter engine..." << std::endl;
+        // 布隆窗口的哈希函数个数、最大生存时长与轮换间隔不变，尺寸缩小为更小的 2 的幂：折叠是精确的，无需重放日志
+        const bool foldable = filterOptions.kind == WindowFilterKind::Bloom && _hashFunctionNum == hashFunctionNum && _maxJwtLifeTime == maxJwtLifeTime &&
+                              _rotationInterval == rotationInterval && _bloomFilterSize < bloomFilterSize &&
+                              _bloomFilterSize != 0 && (_bloomFilterSize & (_bloomFilterSize - 1)) == 0;
+        if (foldable) {
+            std::unique_lock lock(filtersMtx);
+            bloomFilterSize = _bloomFilterSize; // 之后轮换出的新窗口直接使用新尺寸
+            lock.unlock();
 
-        // 初始化过滤器
-        auto _filters = getNewFilters(filtersNum, bloomFilterSize, hashFunctionNum);
+            // 折叠完成后由折叠线程打印横幅
+            foldRunFlag.store(true);
+            foldThread = std::thread(&Engine::foldFiltersWorker, this);
+            return;
+        }
 
-        // 从日志中恢复记录到过滤器中
-        recoverFromLog(_filters);
+        // 初始化过滤器（新参数在替换过滤器时才生效，重放期间查询仍使用旧参数与旧过滤器）
+        const unsigned int _filtersNum = ceilDiv(_maxJwtLifeTime, _rotationInterval);
+        auto _filters = getNewFilters(_filtersNum, _bloomFilterSize, _hashFunctionNum, filterOptions);
 
-        printLogo(static_cast<float>(filtersNum * bloomFilterSize) / 8388608);
+        // 从日志中恢复记录到过滤器中（共享内存导出按新参数重建）
+        SealKeyStore _sealKeys;
+        auto _shmExport = makeShmExport(_maxJwtLifeTime, _rotationInterval, _bloomFilterSize, _hashFunctionNum, _filtersNum);
+        recoverFromLog(_filters, _maxJwtLifeTime, _rotationInterval, _hashFunctionNum,
+                       sealOptions.enabled ? &_sealKeys : nullptr, nullptr, _shmExport.get());
 
         std::unique_lock lock(filtersMtx);
-        filters.clear();
-        filters = _filters;
+        maxJwtLifeTime = _maxJwtLifeTime;
+        rotationInterval = _rotationInterval;
+        bloomFilterSize = _bloomFilterSize;
+        hashFunctionNum = _hashFunctionNum;
+        filtersNum = _filtersNum;
+        publishFilters(std::exchange(filters, std::move(_filters)));
+        resetSealState(std::move(_sealKeys));
+        replaceShmExport(std::move(_shmExport));
+        const float memoryUsed = static_cast<float>(printBitmapStorage()) / 1048576;
         lock.unlock();
         adjustFiltersCv.notify_all(); // 通知周期轮换线程，重新等待轮换计时
+        sealCv.notify_all(); // 重建后的窗口尽快封存
+        printLogo(log(), memoryUsed);
     }
 
     // 写入布隆过滤器
     void revokeJwt(const std::string &token, const time_t &expTime) {
-        // 计算这个 token 还剩多长时间过期
-        const auto now_c = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-        const time_t remainingTime = expTime - now_c;
+        static LatencyHistogram &revokeLatency = MetricsRegistry::instance().histogram(
+            "revoker_engine_revoke_seconds", "Engine::revokeJwt latency");
+        static Counter &revokeCount = MetricsRegistry::instance().counter(
+            "revoker_engine_revokes_total", "Engine::revokeJwt calls");
+        ScopedTimer timer(revokeLatency);
+        revokeCount.inc();
+
+        // 计算这个 token 还剩多长时间过期（已过期的不必哈希与加锁）
+        const time_t remainingTime = expTime - currentTime();
 
         // 防止系统时间错误（系统时间晚于过期时间，导致是负数）
         if (remainingTime <= 0) return;
 
+        // 各窗口的哈希函数个数相同，只计算一次哈希，再分别写入到多个布隆过滤器中。
+        // 哈希在加锁之前计算，个数取自已发布的视图（参数由调整在持锁时修改）；之后参数被调整时 addToFilters 按需补算
+        unsigned int hashNum = 0;
+        {
+            const EpochDomain::ReadGuard guard;
+            if (const FilterView *view = filterView.load(std::memory_order_acquire)) hashNum = view->hashNum;
+        }
+        if (hashNum == 0) return; // 尚未初始化，没有窗口
+        BloomHashes hashes;
+        BaseBloomFilter::hashKey(token, hashNum, hashes);
+        const uint64_t shmHash = shmExportPath.empty() ? 0 : shmTokenHash(token);
+        std::lock_guard lock(filtersMtx); // 与轮换、折叠、封存与参数调整互斥，避免写入落在正被替换的窗口上
+
         // 防止剩余时长超出 maxJwtLifeTime
         if (remainingTime > maxJwtLifeTime) return;
 
-        // 计算需要写入到多少个布隆过滤器中
-        const unsigned int num = std::ceil(remainingTime / rotationInterval);
-        if (num > filtersNum) return;
+        // 计算需要写入到多少个布隆过滤器中（参数在持锁期间读取，调整参数时不会越界）
+        const unsigned int num = ceilDiv(remainingTime, rotationInterval);
+        if (num > filtersNum || num > filters.size()) return;
+        addToFilters(filters, num, token, hashes);
+        if (shmExport) shmExport->add(shmHash, num);
+        if (revokeForwarder) revokeForwarder(token + "," + std::to_string(expTime));
+        if (sealOptions.enabled) {
+            // 记录精确键，供下一轮封存使用；已封存的窗口从近期键表中查到这次写入
+            const uint32_t lastWindow = firstWindowId + num - 1;
+            sealKeys.append(hashes.data()[0], lastWindow);
+            if (sealRecent) sealRecent->insert(hashes.data()[0], lastWindow);
+        }
+    }
+
+    // 按主体批量撤回：iss / sub 在 before 之前签发的全部 token（调用方需先用 isValidSubject 校验）
+    void revokeSubject(const std::string &iss, const std::string &sub, const time_t &before) {
+        static Counter &subjectRevokeCount = MetricsRegistry::instance().counter(
+            "revoker_engine_subject_revokes_total", "Engine::revokeSubject calls");
+        subjectRevokeCount.inc();
+
+        // 水位线之前签发的 token 都已自然过期
+        if (before + static_cast<time_t>(maxJwtLifeTime) <= currentTime()) return;
 
-        // 分别写入到多个布隆过滤器中
-        for (unsigned int i = 0; i < num; ++i) filters[i].add(token);
+        const uint64_t key = SubjectIndex::subjectKey(iss, sub);
+        std::lock_guard lock(filtersMtx);
+        subjects.revoke(key, before, before + static_cast<time_t>(maxJwtLifeTime));
+        updateSubjectEntries();
+        if (revokeForwarder) revokeForwarder(formatSubjectRecord(iss, sub, before));
+    }
+
+    // 签发时间为 iat 的 token 是否被按主体撤回
+    bool isSubjectRevoked(const std::string &iss, const std::string &sub, const time_t &iat) const {
+        return subjects.isRevoked(SubjectIndex::subjectKey(iss, sub), iat);
     }
 
     // 查询是否在布隆过滤器中
-    bool isRevoked(const std::string &token, const time_t &expTime) const {
+    // probedWindows 不为空时写入实际查询的窗口数（遇到第一个不包含该 token 的窗口即停止）
+    bool isRevoked(const std::string &token, const time_t &expTime, unsigned int *probedWindows = nullptr) const {
+        static LatencyHistogram &queryLatency = MetricsRegistry::instance().histogram(
+            "revoker_engine_query_seconds", "Engine::isRevoked latency");
+        static Counter &queryCount = MetricsRegistry::instance().counter(
+            "revoker_engine_queries_total", "Engine::isRevoked calls");
+        ScopedTimer timer(queryLatency);
+        queryCount.inc();
+        if (probedWindows) *probedWindows = 0;
+
+        // 查询无锁：读取已发布的窗口视图，视图与其中的窗口在离开读者临界区之前不会被释放
+        const EpochDomain::ReadGuard guard;
+        const FilterView *view = filterView.load(std::memory_order_acquire);
+        if (!view) return false;
+        const auto &filters = view->filters;
+
         // 计算这个 token 还剩多长时间过期
-        const auto now_c = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-        const time_t remainingTime = expTime - now_c;
+        const time_t remainingTime = expTime - currentTime();
 
         // 防止系统时间错误（系统时间晚于过期时间，导致是负数）
         if (remainingTime <= 0) return false;
 
         // 防止剩余时长超出 maxJwtLifeTime
-        if (remainingTime > maxJwtLifeTime) return false;
+        if (remainingTime > view->maxJwtLifeTime) return false;
 
         // 计算需要查询多少个布隆过滤器
-        const unsigned int num = std::ceil(remainingTime / rotationInterval);
-        if (num > filtersNum) return false;
+        const unsigned int num = ceilDiv(remainingTime, view->rotationInterval);
+        if (num > filters.size()) return false;
 
-        // 分别查询多个布隆过滤器中
+        // 只计算一次哈希，再分别查询多个布隆过滤器（封存的窗口只需要第一个哈希值）
+        BloomHashes hashes;
+        BaseBloomFilter::hashKey(token, filters[0]->requiredHashNum(), hashes);
         for (unsigned int i = 0; i < num; ++i) {
+            // 扩展出的子过滤器需要更多的哈希值
+            if (const unsigned int required = filters[i]->requiredHashNum(); required > hashes.size()) {
+                BaseBloomFilter::hashKey(token, required, hashes);
+            }
             // 如果任意一个布隆过滤器返回不存在，则肯定不存在于黑名单中
-            if (!filters[i].contains(token)) { return false; }
+            if (!filters[i]->contains(hashes)) {
+                if (probedWindows) *probedWindows = i + 1;
+                return false;
+            }
         }
         // 如果多个布隆过滤器都返回存在，则可能存在于黑名单中
+        if (probedWindows) *probedWindows = num;
         return true;
     }
 
+    // 模拟时钟（离线模拟器 revoker_sim 使用）：设置后撤回、查询、轮换时的清理与快照都以 now 为当前时刻，
+    // 周期轮换线程不再按真实时间轮换，由调用方在模拟时间跨过轮换间隔时调用 rotate()。应在 init 之前设置
+    void setSimulatedTime(const time_t now) { simulatedNow.store(now, std::memory_order_relaxed); }
+
+    // 执行一次周期轮换：淘汰最旧的布隆过滤器，在末尾追加一个新的
+    void rotate() {
+        std::unique_lock lock(filtersMtx);
+        rotateFilters();
+    }
+
+    // 把窗口（连同参数）与主体索引保存为快照文件（本机字节序，先写临时文件再重命名）。
+    // 封存的窗口依赖引擎内的键表，开启 window_seal 时不支持快照
+    void saveSnapshot(const std::string &path) {
+        std::string out;
+        {
+            std::lock_guard lock(filtersMtx); // 写入与轮换等待，查询不受影响
+            serializeSnapshot(out);
+        }
+        writeSnapshotFile(path, out);
+        log() << "[Engine] Saved snapshot of " << filtersNum << " windows to " << path << " (" <<
+                static_cast<double>(out.size()) / 1048576 << " MBytes)";
+    }
+
+    // 从 saveSnapshot 写出的快照还原窗口与参数，并合并其中的主体记录；
+    // 保存以来经过的每个完整轮换周期淘汰一个最旧的窗口（只会多保留，不会漏报）。
+    // 共享内存导出无法从窗口还原，配置了 shm_export_path 时不支持
+    void loadSnapshot(const std::string &path) {
+        const MappedSnapshotFile file(path);
+        installSnapshot(parseEngineSnapshot(file.data(), path, filterOptions), path);
+        std::lock_guard lock(filtersMtx);
+        printBitmapStorage();
+    }
+
+    // 热重启交接（旧进程）：在同一次持锁中取出快照，并把之后的每条撤回记录（日志格式）交给 forwarder，
+    // 新进程还原快照后依次应用这些记录，交接前后的撤回都不会遗漏。forwarder 在持锁时调用，只应入队。
+    // 开启 window_seal 或 shm_export_path 时不支持快照，snapshot 为空，新进程改为从日志恢复
+    void beginHandoff(std::string &snapshot, std::function<void(const std::string &)> forwarder) {
+        std::lock_guard lock(filtersMtx);
+        snapshot.clear();
+        if (!sealOptions.enabled && shmExportPath.empty() && !filters.empty()) serializeSnapshot(snapshot);
+        revokeForwarder = std::move(forwarder);
+    }
+
+    // 交接未完成（新进程没有收到应答）时停止转发
+    void endHandoff() {
+        std::lock_guard lock(filtersMtx);
+        revokeForwarder = nullptr;
+    }
+
+    // 热重启交接（新进程）：在 init 之前设置，init 时参数与快照一致则直接还原，不再从日志重建
+    void setHandoffSnapshot(std::string snapshot) { handoffSnapshot = std::move(snapshot); }
+
+    // 应用一条日志格式的撤回记录（<token>,<exp> 或主体记录），用于热重启时旧进程转发的记录
+    void applyLogRecord(const std::string &line) {
+        if (std::string iss, sub; line.starts_with('!')) {
+            if (time_t before; parseSubjectRecord(line, iss, sub, before)) revokeSubject(iss, sub, before);
+            return;
+        }
+        const size_t comma = line.find(',');
+        if (comma == std::string::npos || comma == 0) return;
+        try {
+            revokeJwt(line.substr(0, comma), static_cast<time_t>(std::stoll(line.substr(comma + 1))));
+        } catch (const std::exception &) {
+            logError() << "[Engine] Invalid revoke record: " << line;
+        }
+    }
+
     // 将撤回记录写入日志
     void logRevoke(const std::string &token, const time_t &expTime) {
         logQueue.enqueue(token + "," + std::to_string(expTime));
     }
 
+    void logRevokeSubject(const std::string &iss, const std::string &sub, const time_t &before) {
+        logQueue.enqueue(formatSubjectRecord(iss, sub, before));
+    }
+
     // getter方法，用于节点状态上报
     unsigned long getMaxJwtLifeTime() const { return maxJwtLifeTime; }
     unsigned long getRotationInterval() const { return rotationInterval; }
     size_t getBloomFilterSize() const { return bloomFilterSize; }
     unsigned int getHashFunctionNum() const { return hashFunctionNum; }
+    size_t getFilterMemoryBytes() const { return filterMemoryBytes.load(std::memory_order_relaxed); }
+
+    // 持锁重新统计窗口内存（getFilterMemoryBytes 只在轮换、折叠与封存后更新），供模拟器与诊断使用
+    size_t measureFilterMemory() {
+        std::lock_guard lock(filtersMtx);
+        return updateFilterMemory();
+    }
 
     std::vector<unsigned long> getBloomFilterFillingRate() const {
         std::vector<unsigned long> bloomFilterFillingRate;
         bloomFilterFillingRate.reserve(filtersNum);
-        for (const auto &baseBloomFilter: filters) { bloomFilterFillingRate.push_back(baseBloomFilter.getMsgNum()); }
+        forEachWindow([&](const WindowFilter &filter) { bloomFilterFillingRate.push_back(filter.getMsgNum()); });
         return bloomFilterFillingRate;
     }
 
+    // 每个窗口的子过滤器个数（未开启扩展时均为 1）
+    std::vector<unsigned long> getBloomFilterStageNum() const {
+        std::vector<unsigned long> stageNum;
+        stageNum.reserve(filtersNum);
+        forEachWindow([&](const WindowFilter &filter) { stageNum.push_back(filter.getStageNum()); });
+        return stageNum;
+    }
+
+    // 每个布隆过滤器的置位比特数
+    std::vector<unsigned long> getBloomFilterSetBitNum() const {
+        std::vector<unsigned long> setBitNum;
+        setBitNum.reserve(filtersNum);
+        forEachWindow([&](const WindowFilter &filter) { setBitNum.push_back(filter.getSetBitNum()); });
+        return setBitNum;
+    }
+
+    // 每个布隆过滤器的真实填充率（置位比特占比）
+    std::vector<double> getBloomFilterFillRatio() const {
+        std::vector<double> fillRatio;
+        fillRatio.reserve(filtersNum);
+        forEachWindow([&](const WindowFilter &filter) { fillRatio.push_back(filter.getFillRatio()); });
+        return fillRatio;
+    }
+
+    // 每个布隆过滤器的估计误判率
+    std::vector<double> getBloomFilterEstimatedFpr() const {
+        std::vector<double> fpr;
+        fpr.reserve(filtersNum);
+        forEachWindow([&](const WindowFilter &filter) { fpr.push_back(filter.getEstimatedFpr()); });
+        return fpr;
+    }
+
+    // 每个布隆过滤器的估计元素个数（去重后）
+    std::vector<unsigned long> getBloomFilterEstimatedItemNum() const {
+        std::vector<unsigned long> itemNum;
+        itemNum.reserve(filtersNum);
+        forEachWindow([&](const WindowFilter &filter) {
+            const double n = filter.getEstimatedItemNum();
+            itemNum.push_back(std::isfinite(n) ? static_cast<unsigned long>(std::llround(n)) : ULONG_MAX);
+        });
+        return itemNum;
+    }
+
 private:
     const std::map<std::string, std::string> &config;
-    std::vector<BaseBloomFilter> filters; // 布隆过滤器数组
+    EngineLogSink logSink;
+
+    EngineLogLine log() const { return {logSink, false}; }
+    EngineLogLine logError() const { return {logSink, true}; }
+
+    std::string namespaceName; // 命名空间引擎的名字，默认引擎为空
+    std::string logQueueMetric;
+    std::atomic<size_t> filterMemoryBytes{0}; // 最近一次统计的窗口内存
+    std::atomic<time_t> simulatedNow{0}; // 模拟时钟，0 表示使用系统时间
+
+    time_t currentTime() const {
+        const time_t simulated = simulatedNow.load(std::memory_order_relaxed);
+        return simulated != 0 ? simulated : std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    }
+    std::vector<std::unique_ptr<WindowFilter> > filters; // 过滤器数组（每个时间窗口一个，由 filtersMtx 保护）
+
+    // 查询看到的窗口与参数：不可变，整体替换后发布；旧视图与替换下来的窗口在读者离开后才释放
+    struct FilterView {
+        std::vector<const WindowFilter *> filters;
+        unsigned long maxJwtLifeTime = 0;
+        unsigned long rotationInterval = 0;
+        unsigned int hashNum = 0; // 撤回在加锁前预先计算的哈希值个数
+    };
+
+    std::atomic<const FilterView *> filterView{nullptr};
+
+    // 按当前的窗口与参数发布新视图，等待仍在读取旧视图的查询离开后，释放旧视图与 retired 中的窗口。
+    // 窗口或查询参数每次变化后都要调用（调用方需持有 filtersMtx）
+    void publishFilters(std::vector<std::unique_ptr<WindowFilter> > retired = {}) {
+        auto view = std::make_unique<FilterView>();
+        view->filters.reserve(filters.size());
+        for (const auto &filter: filters) view->filters.push_back(filter.get());
+        view->maxJwtLifeTime = maxJwtLifeTime;
+        view->rotationInterval = rotationInterval;
+        view->hashNum = baseHashNum(filterOptions, hashFunctionNum);
+        const std::unique_ptr<const FilterView> old(filterView.exchange(view.release(), std::memory_order_acq_rel));
+        EpochDomain::instance().synchronize();
+        retired.clear();
+    }
+
+    // 在读者临界区内依次访问已发布的窗口（状态上报与查询一样无锁）
+    template<typename Fn>
+    void forEachWindow(Fn &&fn) const {
+        const EpochDomain::ReadGuard guard;
+        if (const FilterView *view = filterView.load(std::memory_order_acquire)) {
+            for (const WindowFilter *filter: view->filters) fn(*filter);
+        }
+    }
     unsigned long maxJwtLifeTime = 0; // jwt最大生存时长
     unsigned long rotationInterval = 0; // 周期轮换间隔
     size_t bloomFilterSize = 0; // 每个布隆过滤器尺寸
     unsigned int hashFunctionNum = 0; // 哈希函数个数
     unsigned int filtersNum = 0; // 布隆过滤器个数
+    WindowFilterOptions filterOptions; // 窗口实现、位图内存分配策略（大页 / NUMA 副本）与扩展策略
     std::mutex filtersMtx; // 布隆过滤器读写锁（重建过程中，禁止读写）
     std::condition_variable adjustFiltersCv; // 用于调整布隆过滤器参数后的条件变量（通知周期轮换线程）
 
+    // 窗口封存（以下成员由 filtersMtx 保护）
+    SealOptions sealOptions;
+    SealKeyStore sealKeys; // 全部有效撤回记录的精确键
+    std::shared_ptr<RecentKeyTable> sealRecent; // 上一轮封存之后写入的键，封存窗口共享
+    uint32_t firstWindowId = 0; // filters[0] 的窗口编号，每次轮换加 1
+    uint64_t filtersGeneration = 0; // 每次整体重建窗口加 1，使进行中的封存作废
+    bool sealRequested = true; // 轮换或重建后置位，封存线程据此开始下一轮
+
+    // 共享内存导出：与窗口同步写入与轮换的布隆过滤器镜像（由 filtersMtx 保护）
+    std::string shmExportPath;
+    std::unique_ptr<ShmFilterExport> shmExport;
+
+    // 按给定参数创建一块尚未发布的导出区域；未配置 shm_export_path 时返回 nullptr
+    std::unique_ptr<ShmFilterExport> makeShmExport(const unsigned long _maxJwtLifeTime, const unsigned long _rotationInterval,
+                                                   const size_t _bloomFilterSize, const unsigned int _hashFunctionNum,
+                                                   const unsigned int _filtersNum) const {
+        if (shmExportPath.empty()) return nullptr;
+        return std::make_unique<ShmFilterExport>(shmExportPath, _maxJwtLifeTime, _rotationInterval, _bloomFilterSize,
+                                                 _hashFunctionNum, _filtersNum);
+    }
+
+    // 发布重建后的导出区域，再使旧区域失效：读端看到失效标记时 path 上已是新区域（调用方需持有 filtersMtx）
+    void replaceShmExport(std::unique_ptr<ShmFilterExport> _shmExport) {
+        if (!_shmExport) return;
+        _shmExport->publish();
+        if (shmExport) shmExport->retire();
+        shmExport = std::move(_shmExport);
+        log() << "[Engine] Shared-memory export: " << shmExport->getPath() << ", " <<
+                static_cast<double>(shmExport->getMappedBytes()) / 1048576 << " MBytes mapped";
+    }
+
+    SubjectIndex subjects; // 按主体批量撤回的水位线（写入由 filtersMtx 串行化，查询无锁）
+
+    void updateSubjectEntries() {
+        static Gauge &subjectEntries = MetricsRegistry::instance().gauge(
+            "revoker_engine_subject_entries", "Subjects with an active revoked-before watermark");
+        if (namespaceName.empty()) subjectEntries.set(static_cast<int64_t>(subjects.size()));
+    }
+
+    std::string handoffSnapshot; // 热重启时旧进程交接的快照，init 时使用一次
+    std::string startupSnapshotPath;
+    std::function<void(const std::string &)> revokeForwarder; // 交接后把撤回记录转发给新进程（由 filtersMtx 保护）
+
+    // 调用方需持有 filtersMtx
+    void serializeSnapshot(std::string &out) const {
+        if (sealOptions.enabled) throw std::logic_error("Snapshots are not supported with window_seal = on");
+        serializeEngineSnapshot(out, hashFunctionNum, maxJwtLifeTime, rotationInterval, bloomFilterSize, currentTime(),
+                                filters, [this](auto &&fn) { subjects.forEach(fn); });
+    }
+
+    // 保存以来经过的每个完整轮换周期淘汰一个最旧的窗口，再整体替换窗口与参数并合并主体记录
+    void installSnapshot(EngineSnapshot snapshot, const std::string &source) {
+        if (sealOptions.enabled) throw std::logic_error("Snapshots are not supported with window_seal = on");
+        if (!shmExportPath.empty()) throw std::logic_error("Snapshots cannot be loaded with shm_export_path set");
+
+        auto &_filters = snapshot.filters;
+        const size_t _filtersNum = _filters.size();
+        const auto now_c = currentTime();
+        const uint64_t rotations = now_c > snapshot.savedAt
+                                       ? std::min<uint64_t>((now_c - snapshot.savedAt) / snapshot.rotationInterval, _filtersNum)
+                                       : 0;
+        _filters.erase(_filters.begin(), _filters.begin() + static_cast<std::ptrdiff_t>(rotations));
+        while (_filters.size() < _filtersNum) {
+            _filters.push_back(makeWindowFilter(snapshot.bloomFilterSize, snapshot.hashFunctionNum, filterOptions));
+        }
+
+        std::unique_lock lock(filtersMtx);
+        maxJwtLifeTime = snapshot.maxJwtLifeTime;
+        rotationInterval = snapshot.rotationInterval;
+        bloomFilterSize = snapshot.bloomFilterSize;
+        hashFunctionNum = snapshot.hashFunctionNum;
+        filtersNum = _filtersNum;
+        publishFilters(std::exchange(filters, std::move(_filters)));
+        resetSealState({});
+        for (const auto &[key, before, expireAt]: snapshot.subjects) {
+            if (expireAt > now_c) subjects.revoke(key, before, expireAt);
+        }
+        updateSubjectEntries();
+        log() << "[Engine] Loaded snapshot from " << source << ", " << rotations << " windows expired since it was saved";
+        lock.unlock();
+        adjustFiltersCv.notify_all(); // 通知周期轮换线程，重新等待轮换计时
+    }
+
+    // 使用热重启交接的快照（只使用一次）；快照无效或参数与 init 的参数不一致时返回 false
+    bool restoreHandoffSnapshot() {
+        if (handoffSnapshot.empty()) return false;
+        const std::string data = std::move(handoffSnapshot);
+        handoffSnapshot.clear();
+        return restoreSnapshot(data, "hot restart handoff") >= 0;
+    }
+
+    // 使用启动快照：还原后只重放快照保存时刻所在小时及之后的日志文件（重复写入同一条记录不影响结果），
+    // 补上构建快照之后的撤回；快照不可用时返回 false，改为完整的日志恢复
+    bool restoreStartupSnapshot() {
+        if (startupSnapshotPath.empty()) return false;
+        time_t savedAt;
+        try {
+            const MappedSnapshotFile file(startupSnapshotPath);
+            savedAt = restoreSnapshot(file.data(), startupSnapshotPath);
+        } catch (const std::exception &e) {
+            logError() << "[Engine] Cannot read startup snapshot, recovering from log: " << e.what();
+            return false;
+        }
+        if (savedAt < 0) return false;
+
+        std::unique_lock lock(filtersMtx);
+        recoverFromLog(filters, maxJwtLifeTime, rotationInterval, hashFunctionNum, nullptr, &subjects, nullptr, savedAt);
+        updateSubjectEntries();
+        return true;
+    }
+
+    // 还原一份快照并返回它的保存时刻；快照无效、参数与 init 的参数不一致或当前配置不支持快照时返回 -1
+    time_t restoreSnapshot(const std::string_view data, const std::string &source) {
+        try {
+            EngineSnapshot snapshot = parseEngineSnapshot(data, source, filterOptions);
+            if (snapshot.maxJwtLifeTime != maxJwtLifeTime || snapshot.rotationInterval != rotationInterval ||
+                snapshot.bloomFilterSize != bloomFilterSize || snapshot.hashFunctionNum != hashFunctionNum) {
+                log() << "[Engine] Parameters of snapshot " << source << " differ from master, recovering from log";
+                return -1;
+            }
+            const time_t savedAt = snapshot.savedAt;
+            installSnapshot(std::move(snapshot), source);
+            return savedAt;
+        } catch (const std::exception &e) {
+            logError() << "[Engine] Cannot use snapshot " << source << ", recovering from log: " << e.what();
+            return -1;
+        }
+    }
+
+    // 写入前 num 个窗口；追加了子过滤器的窗口需要更多的哈希值时补算
+    static void addToFilters(std::vector<std::unique_ptr<WindowFilter> > &_filters, const unsigned int num, const std::string &token,
+                             BloomHashes &hashes) {
+        for (unsigned int i = 0; i < num; ++i) {
+            if (const unsigned int required = _filters[i]->requiredHashNum(); required > hashes.size()) {
+                BaseBloomFilter::hashKey(token, required, hashes);
+            }
+            _filters[i]->add(hashes);
+        }
+    }
+
+    // 打印窗口的存储方式与实际占用的内存，返回统计出的字节数（调用方需持有 filtersMtx）
+    size_t printBitmapStorage() {
+        if (filters.empty()) return 0;
+        const auto denseNum = std::count_if(filters.begin(), filters.end(),
+                                            [](const auto &filter) { return filter->isDense(); });
+        if (denseNum > 0) {
+            const auto dense = std::find_if(filters.begin(), filters.end(),
+                                            [](const auto &filter) { return filter->isDense(); });
+            log() << "[Engine] Bitmap storage: " << (*dense)->getBacking() << " pages, " << (*dense)->getReplicaNum() <<
+                    " NUMA replica(s)";
+        }
+        const size_t bytes = updateFilterMemory();
+        log() << "[Engine] Dense windows: " << denseNum << "/" << filters.size() << ", filter memory: " <<
+                static_cast<float>(bytes) / 1048576 << " MBytes";
+        return bytes;
+    }
+
+    // 统计各窗口实际分配的内存（位图、稀疏集合与封存用的键）并更新指标（调用方需持有 filtersMtx）
+    size_t updateFilterMemory() {
+        static Gauge &filterBytes = MetricsRegistry::instance().gauge(
+            "revoker_engine_filter_bytes", "Memory allocated by bloom filter windows (bitmaps and sparse sets)");
+        size_t bytes = 0;
+        for (const auto &filter: filters) bytes += filter->getMemoryBytes();
+        if (sealOptions.enabled) bytes += sealKeys.memoryBytes() + (sealRecent ? sealRecent->memoryBytes() : 0);
+        filterMemoryBytes.store(bytes, std::memory_order_relaxed);
+        if (namespaceName.empty()) filterBytes.set(static_cast<int64_t>(bytes)); // 命名空间由 EngineNamespaces 上报
+        return bytes;
+    }
+
     // 持久化线程
     ThreadSafeQueue<std::string> logQueue{}; // 日志队列
     std::atomic<bool> logRunFlag{false};
     std::thread logThread;
 
     void logWorker() {
+        std::vector<std::string> msgs;
         while (logRunFlag.load()) {
-            // 从队列中取出消息
-            std::string msg = logQueue.dequeue();
+            // 从队列中批量取出消息，一次唤醒写入多条记录
+            msgs.clear();
+            logQueue.dequeueBulk(msgs, QUEUE_DEFAULT_MAXSIZE);
+            // 只有退出时投递的空消息：不打开日志文件（未配置日志目录的嵌入库也不会在当前目录留下空文件）
+            if (std::all_of(msgs.begin(), msgs.end(), [](const auto &msg) { return msg.empty(); })) continue;
 
             // 计算当前时刻的整点时间戳
             const auto now_c = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
@@ -220,13 +797,24 @@ private:
 
             // 写入文件
             if (std::ofstream logFile(filePath, std::ios::app); logFile.is_open()) {
-                logFile << msg << std::endl;
+                for (const auto &msg: msgs) { if (!msg.empty()) logFile << msg << '\n'; }
+                logFile.flush();
             }
         }
     }
 
-    // 从日志中恢复
-    void recoverFromLog(std::vector<BaseBloomFilter> &_filters) const {
+    // 从日志中恢复；since 不为 0 时只读取可能含有 since 之后记录的小时文件（启动快照之后的部分）
+    void recoverFromLog(std::vector<std::unique_ptr<WindowFilter> > &_filters, const unsigned long _maxJwtLifeTime,
+                        const unsigned long _rotationInterval, const unsigned int _hashFunctionNum,
+                        SealKeyStore *_sealKeys = nullptr, SubjectIndex *_subjects = nullptr,
+                        ShmFilterExport *_shmExport = nullptr, const time_t since = 0) const {
+        static LatencyHistogram &recoveryLatency = MetricsRegistry::instance().histogram(
+            "revoker_engine_recovery_seconds", "Time spent rebuilding filters from logs");
+        ScopedTimer timer(recoveryLatency);
+
+        // 未配置日志目录（嵌入式使用）时不持久化，也无需恢复
+        if (getConfigOrDefault(config, "log_file_path", "").empty()) return;
+
         // 计算当前时刻的整点时间戳
         const std::time_t now_c = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
         std::tm *tm = std::localtime(&now_c);
@@ -236,6 +824,7 @@ private:
 
         // 文件路径列表和文件大小列表
         std::vector<std::filesystem::path> foundFiles;
+        std::vector<std::filesystem::path> replayFiles;
         size_t fileSizes = 0;
 
         // 循环检查文件是否存在，并获取文件大小
@@ -244,7 +833,10 @@ private:
             filePath /= std::to_string(hourlyTimestamp) + ".txt"; // 拼接路径
             if (exists(filePath)) {
                 foundFiles.push_back(filePath);
-                fileSizes += file_size(filePath);
+                if (hourlyTimestamp + 3600 > since) {
+                    replayFiles.push_back(filePath);
+                    fileSizes += file_size(filePath);
+                }
             }
             hourlyTimestamp -= 3600; // 减去1小时
         }
@@ -259,14 +851,25 @@ private:
 
         // 逐步导入文件内容
         size_t readBytes = 0;
-        for (const auto &it: foundFiles) {
+        BloomHashes hashes;
+        for (const auto &it: replayFiles) {
             std::ifstream file(it);
             if (!file.is_open()) {
-                std::cerr << "[Engine] Error opening file: " << it << std::endl;
+                logError() << "[Engine] Error opening file: " << it;
                 return;
             }
             std::string line;
             while (std::getline(file, line)) {
+                // 按主体撤回的记录：只在初始化时恢复（调整窗口参数不影响主体索引）
+                if (std::string issuer, subject; line.starts_with('!')) {
+                    if (time_t before; _subjects && parseSubjectRecord(line, issuer, subject, before)) {
+                        const time_t expireAt = before + static_cast<time_t>(_maxJwtLifeTime);
+                        if (expireAt > std::chrono::system_clock::to_time_t(std::chrono::system_clock::now())) {
+                            _subjects->revoke(SubjectIndex::subjectKey(issuer, subject), before, expireAt);
+                        }
+                    }
+                    continue;
+                }
                 std::istringstream iss(line);
 
                 // 解析 token 字符串
@@ -281,53 +884,231 @@ private:
                         const time_t remainingTime = expTime - std::chrono::system_clock::to_time_t(
                                                          std::chrono::system_clock::now()); // 计算这个 token 还剩多长时间过期
                         if (remainingTime <= 0) continue;
-                        if (remainingTime > maxJwtLifeTime) continue;
+                        if (remainingTime > _maxJwtLifeTime) continue;
 
                         // 计算需要写入到多少个布隆过滤器中
-                        const unsigned int num = std::ceil(remainingTime / rotationInterval);
-                        if (num > filtersNum) continue;
+                        const unsigned int num = ceilDiv(remainingTime, _rotationInterval);
+                        if (num > _filters.size()) continue;
 
                         // 分别写入到多个布隆过滤器中
-                        for (unsigned int i = 0; i < num; ++i) _filters[i].add(token);
+                        BaseBloomFilter::hashKey(token, baseHashNum(filterOptions, _hashFunctionNum), hashes);
+                        addToFilters(_filters, num, token, hashes);
+                        if (_sealKeys) _sealKeys->append(hashes.data()[0], num - 1);
+                        if (_shmExport) _shmExport->add(shmTokenHash(token), num);
 
                         // 显示进度
                         readBytes += 49; // 每行是一条记录，一条记录 49 bytes
                         if (readBytes % 4900000 == 0) {
                             float p = static_cast<float>(readBytes) / static_cast<float>(fileSizes) * 100;
-                            std::cout << "[Engine] Recover from log: " << p << "%" << std::endl;
+                            log() << "[Engine] Recover from log: " << p << "%";
                         }
                     }
                 }
             }
             file.close();
         }
-        std::cout << "[Engine] Recover from log is done, " << fileSizes / 49 << " items have been loaded." << std::endl;
+        log() << "[Engine] Recover from log is done, " << fileSizes / 49 << " items have been loaded.";
+    }
+
+    // 后台折叠线程
+    std::atomic<bool> foldRunFlag{false};
+    std::thread foldThread;
+
+    void stopFoldWorker() {
+        foldRunFlag.store(false);
+        if (foldThread.joinable()) foldThread.join();
+    }
+
+    // 逐窗口折叠到当前的 bloomFilterSize：每次只在持锁期间处理一个窗口，期间轮换与写入等待；
+    // 查询继续读取原窗口，新窗口发布后等原窗口上的查询离开再释放
+    void foldFiltersWorker() {
+        static LatencyHistogram &foldPause = MetricsRegistry::instance().histogram(
+            "revoker_engine_fold_pause_seconds", "Time the filters lock is held while folding one window");
+        const auto start = std::chrono::steady_clock::now();
+        unsigned int foldedNum = 0;
+        size_t bytes = 0;
+        while (foldRunFlag.load()) {
+            std::unique_lock lock(filtersMtx);
+            const auto it = std::find_if(filters.begin(), filters.end(), [this](const auto &filter) {
+                return !filter->isSealed() && filter->getSize() > bloomFilterSize;
+            });
+            if (it == filters.end()) {
+                bytes = updateFilterMemory();
+                break;
+            }
+            ScopedTimer timer(foldPause);
+            std::vector<std::unique_ptr<WindowFilter> > retired;
+            retired.push_back(std::move(*it));
+            *it = retired.back()->folded(bloomFilterSize);
+            publishFilters(std::move(retired));
+            bytes = updateFilterMemory();
+            ++foldedNum;
+        }
+        const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+        log() << "[Engine] Folded " << foldedNum << " bloom filters to " << bloomFilterSize << " bits in " <<
+                elapsed.count() << " ms, filter memory: " << static_cast<float>(bytes) / 1048576 << " MBytes";
+        if (foldRunFlag.load()) printLogo(log(), static_cast<float>(bytes) / 1048576);
     }
 
     // 周期轮换线程
     std::atomic<bool> rotateFiltersRunFlag{false};
     std::thread rotateFiltersThread;
 
+    // 轮换布隆过滤器（调用方需持有 filtersMtx）
+    void rotateFilters() {
+        static LatencyHistogram &rotationPause = MetricsRegistry::instance().histogram(
+            "revoker_engine_rotation_pause_seconds", "Time the filters lock is held during rotation");
+        ScopedTimer timer(rotationPause);
+        std::vector<std::unique_ptr<WindowFilter> > retired;
+        retired.push_back(std::move(filters.front()));
+        filters.erase(filters.begin());
+        filters.push_back(makeWindowFilter(bloomFilterSize, hashFunctionNum, filterOptions));
+        ++firstWindowId;
+        publishFilters(std::move(retired));
+        // 发布之前转换为位图的窗口：可能读取稀疏集合的查询均已离开，可以释放稀疏集合
+        for (const auto &filter: filters) filter->releaseSparse();
+        if (shmExport) shmExport->rotate();
+        updateFilterMemory();
+        // 清理水位线之前签发的 token 都已过期的主体
+        subjects.purge(currentTime());
+        updateSubjectEntries();
+        sealRequested = true;
+        sealCv.notify_all();
+    }
+
+    // 后台封存线程
+    std::atomic<bool> sealRunFlag{false};
+    std::thread sealThread;
+    std::condition_variable sealCv; // 轮换与重建后通知封存线程
+
+    void stopSealWorker() {
+        {
+            std::lock_guard lock(filtersMtx);
+            sealRunFlag.store(false);
+        }
+        sealCv.notify_all();
+        if (sealThread.joinable()) sealThread.join();
+    }
+
+    // 整体重建窗口后换上新的键表（调用方需持有 filtersMtx）
+    void resetSealState(SealKeyStore &&_sealKeys) {
+        sealKeys = std::move(_sealKeys);
+        sealRecent.reset();
+        firstWindowId = 0;
+        ++filtersGeneration;
+        sealRequested = true;
+    }
+
+    void sealWindowsWorker() {
+        std::unique_lock lock(filtersMtx);
+        const auto wake = [this] { return sealRequested || !sealRunFlag.load(); };
+        while (sealRunFlag.load()) {
+            if (sealOptions.interval > 0) sealCv.wait_for(lock, std::chrono::seconds(sealOptions.interval), wake);
+            else sealCv.wait(lock, wake);
+            if (!sealRunFlag.load()) break;
+            sealRequested = false;
+            sealWindows(lock);
+        }
+    }
+
+    // 近期键表超过全部键的 1/SEAL_RECENT_RATIO 时整体重新封存，换上空的近期键表
+    static constexpr size_t SEAL_RECENT_RATIO = 4;
+
+    // 封存一轮：持锁取出键的快照，释放锁后为选中的窗口构建二元融合过滤器，再持锁替换。
+    // 窗口编号为 w 的窗口恰好包含 lastWindow >= w 的键，每次撤回都会写入多个窗口，没有只读的窗口；
+    // 封存后的写入进入共享的近期键表，封存窗口本身不再变化。因此平时只封存尚未封存的窗口（轮换新建的窗口），
+    // 已封存的窗口沿用原来的融合过滤器与近期键表；近期键表增长到全部键的一定比例后才整体重新封存，
+    // 同时换上只包含快照之后写入的新近期键表。近期键表包含上一次整体封存之后的全部写入，
+    // 因此无论窗口在哪一轮封存都不会漏报。构建期间发生的轮换只改变窗口下标，按编号对应；期间新建的窗口保持可写，下一轮再封存
+    void sealWindows(std::unique_lock<std::mutex> &lock) {
+        static LatencyHistogram &sealPause = MetricsRegistry::instance().histogram(
+            "revoker_engine_seal_pause_seconds", "Time the filters lock is held while swapping in sealed windows");
+        const auto start = std::chrono::steady_clock::now();
+        sealKeys.prune(firstWindowId);
+        const uint64_t generation = filtersGeneration;
+        const uint32_t baseId = firstWindowId;
+        const size_t windowNum = filters.size();
+        const bool full = !sealRecent || sealRecent->size() * SEAL_RECENT_RATIO > sealKeys.size();
+        std::vector<char> selected(windowNum);
+        size_t firstSelected = windowNum;
+        for (size_t j = windowNum; j-- > 0;) {
+            selected[j] = full || !filters[j]->isSealed();
+            if (selected[j]) firstSelected = j;
+        }
+        if (firstSelected == windowNum) return;
+        // 快照：从最新的桶开始拼接，编号为 baseId + j 的窗口的键是前 windowEnd[j] 个（只需要拼接到最旧的选中窗口）
+        std::vector<uint64_t> keys;
+        keys.reserve(sealKeys.size());
+        std::vector<size_t> snapshotSizes(sealKeys.getBucketNum());
+        std::vector<size_t> windowEnd(windowNum, 0);
+        for (size_t b = sealKeys.getBucketNum(); b-- > firstSelected;) {
+            const auto &bucket = sealKeys.getBucket(b);
+            keys.insert(keys.end(), bucket.begin(), bucket.end());
+            snapshotSizes[b] = bucket.size();
+            if (b < windowNum) windowEnd[b] = keys.size();
+        }
+        for (size_t j = windowNum - 1; j-- > 0;) windowEnd[j] = std::max(windowEnd[j], windowEnd[j + 1]);
+        lock.unlock();
+
+        std::vector<std::unique_ptr<WindowFilter> > built(windowNum);
+        for (size_t j = 0; j < windowNum && sealRunFlag.load(); ++j) {
+            if (!selected[j]) continue;
+            built[j] = buildSealedFilter({keys.begin(), keys.begin() + static_cast<std::ptrdiff_t>(windowEnd[j])}, sealOptions);
+        }
+        const size_t snapshotSize = keys.size();
+        keys = {};
+
+        lock.lock();
+        if (!sealRunFlag.load() || generation != filtersGeneration) return;
+        std::vector<std::unique_ptr<WindowFilter> > retired;
+        size_t sealedNum = 0;
+        {
+            ScopedTimer timer(sealPause);
+            // 整体封存换上新的近期键表，只包含快照之后写入的键（期间没有 prune，桶只会在末尾追加）；
+            // 部分封存沿用当前的近期键表，它包含上一次整体封存以来的全部写入
+            auto recent = full ? std::make_shared<RecentKeyTable>() : sealRecent;
+            for (size_t b = 0; full && b < sealKeys.getBucketNum(); ++b) {
+                const auto &bucket = sealKeys.getBucket(b);
+                const uint32_t lastWindow = sealKeys.getFirstId() + static_cast<uint32_t>(b);
+                for (size_t i = b < snapshotSizes.size() ? snapshotSizes[b] : 0; i < bucket.size(); ++i) {
+                    recent->insert(bucket[i], lastWindow);
+                }
+            }
+            for (size_t i = 0; i < filters.size(); ++i) {
+                const uint32_t id = firstWindowId + static_cast<uint32_t>(i);
+                if (id < baseId || id >= baseId + windowNum || !built[id - baseId]) continue;
+                retired.push_back(std::move(filters[i]));
+                filters[i] = std::make_unique<SealedWindowFilter>(std::move(built[id - baseId]), recent, id);
+                ++sealedNum;
+            }
+            sealRecent = std::move(recent);
+        }
+
+        // 查询无锁，替换下来的窗口等进行中的查询离开后再释放
+        publishFilters(std::move(retired));
+        const size_t bytes = updateFilterMemory();
+        const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+        log() << "[Engine] Sealed " << sealedNum << (full ? " windows from " : " new windows from ") << snapshotSize <<
+                " keys in " << elapsed.count() << " ms, filter memory: " << static_cast<double>(bytes) / 1048576 << " MBytes";
+    }
+
     void rotateBloomFilterWorker() {
         while (rotateFiltersRunFlag) {
             std::unique_lock lock(filtersMtx);
 
             // 等待条件变量，但最多等待 rotationInterval 秒，期间等待 adjustBloomFilterCv 条件变量被通知
             if (adjustFiltersCv.wait_for(lock, std::chrono::seconds(rotationInterval)) == std::cv_status::no_timeout) {
+                if (!rotateFiltersRunFlag) break;
                 // 条件变量被通知，说明布隆过滤器参数已被更改，要重新计算周期轮换等待时间
-                std::cout << "[Engine] Bloom filter parameter has been changed, rotation interval is recalculated." <<
-                        std::endl;
-            } else {
+                log() << "[Engine] Bloom filter parameter has been changed, rotation interval is recalculated.";
+            } else if (simulatedNow.load(std::memory_order_relaxed) == 0) {
                 // 等待超时，执行周期轮换
-                filters.erase(filters.begin());
-                filters.emplace_back(bloomFilterSize, hashFunctionNum);
+                rotateFilters();
                 lock.unlock();
 
                 // 打印信息
                 const auto now_c = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-                std::ostringstream oss;
-                oss << "[Engine] Rotate bloom filter at time: " << now_c;
-                std::cout << oss.str() << std::endl;
+                log() << "[Engine] Rotate bloom filter at time: " << now_c;
             }
         }
     }
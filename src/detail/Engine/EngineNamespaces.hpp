@@ -0,0 +1,223 @@
+#ifndef ENGINE_NAMESPACES_HPP
+#define ENGINE_NAMESPACES_HPP
+
+#include <bit>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Engine.hpp"
+#include "../Utils/ConfigReader.hpp"
+#include "../Metrics/Metrics.hpp"
+
+// 一个命名空间的参数：签发者列表、窗口参数与在内存预算中所占的权重
+struct NamespaceOptions {
+    std::string name;
+    std::vector<std::string> issuers;
+    unsigned int maxJwtLifeTime = 0;
+    unsigned int rotationInterval = 0;
+    unsigned int hashFunctionNum = 5;
+    double memoryWeight = 1;
+    size_t bloomFilterSize = 0; // 按预算与权重计算得到的每个窗口的比特数
+    double budgetBits = 0; // 按权重分到的预算（比特），窗口尺寸向下取整到 2 的幂后可能只用到其中一部分
+};
+
+// 从配置中读取命名空间：
+//   engine_namespaces = access,refresh
+//   namespace_memory_budget_mb = 64
+//   namespace.access.issuers = https://idp-a.example.com https://idp-b.example.com
+//   namespace.access.max_jwt_life_time = 300
+//   namespace.access.rotation_interval = 60
+//   namespace.access.hash_function_num = 5
+//   namespace.access.memory_weight = 1
+// 预算按权重分给各命名空间，再平均分给它的 ceil(max_jwt_life_time / rotation_interval) 个窗口（向下取整到 2 的幂）
+inline std::vector<NamespaceOptions> parseNamespaceOptions(const std::map<std::string, std::string> &config) {
+    std::vector<NamespaceOptions> namespaces;
+    std::istringstream names(getConfigOrDefault(config, "engine_namespaces", ""));
+    for (std::string name; std::getline(names, name, ',');) {
+        name = trim(name);
+        if (name.empty()) continue;
+        const std::string prefix = "namespace." + name + ".";
+        NamespaceOptions options;
+        options.name = name;
+        std::istringstream issuers(getConfigOrDefault(config, prefix + "issuers", ""));
+        for (std::string issuer; issuers >> issuer;) options.issuers.push_back(issuer);
+        options.maxJwtLifeTime = std::stoul(getConfigOrDefault(config, prefix + "max_jwt_life_time", "0"));
+        options.rotationInterval = std::stoul(getConfigOrDefault(config, prefix + "rotation_interval", "0"));
+        options.hashFunctionNum = std::stoul(getConfigOrDefault(config, prefix + "hash_function_num", "5"));
+        options.memoryWeight = std::stod(getConfigOrDefault(config, prefix + "memory_weight", "1"));
+        if (options.issuers.empty()) throw std::invalid_argument("Namespace " + name + " has no issuers");
+        if (options.maxJwtLifeTime == 0 || options.rotationInterval == 0 || options.hashFunctionNum == 0) {
+            throw std::invalid_argument("Namespace " + name + " needs max_jwt_life_time, rotation_interval and hash_function_num");
+        }
+        if (!(options.memoryWeight > 0)) throw std::invalid_argument("Namespace " + name + " needs a positive memory_weight");
+        namespaces.push_back(std::move(options));
+    }
+    if (namespaces.empty()) return namespaces;
+
+    const double budgetMb = std::stod(getConfigOrDefault(config, "namespace_memory_budget_mb", "0"));
+    if (!(budgetMb > 0)) throw std::invalid_argument("engine_namespaces requires namespace_memory_budget_mb");
+    double weightSum = 0;
+    for (const auto &options: namespaces) weightSum += options.memoryWeight;
+    for (auto &options: namespaces) {
+        const double bits = budgetMb * 8388608 * options.memoryWeight / weightSum;
+        const unsigned long windows = ceilDiv(options.maxJwtLifeTime, options.rotationInterval);
+        options.budgetBits = bits;
+        // 布隆过滤器的位图尺寸须为 2 的幂（折叠依赖这一点），向下取整（不超出预算），实际用量在创建时打印
+        options.bloomFilterSize = std::bit_floor(static_cast<size_t>(bits / static_cast<double>(windows)));
+        if (options.bloomFilterSize < 512) {
+            throw std::invalid_argument("namespace_memory_budget_mb is too small for namespace " + options.name);
+        }
+    }
+    return namespaces;
+}
+
+// 按签发者（iss）把撤回与查询分派到各自的引擎：每个命名空间有独立的窗口参数、撤回日志（log_file_path 下的
+// ns_<名字> 子目录）与统计，共享一个内存预算；不属于任何命名空间的签发者（或不带 iss 的请求）使用默认引擎，
+// 默认引擎的参数仍由 master 下发，不计入预算。
+// 命名空间在启动时创建，之后只读，分派不加锁
+class EngineNamespaces {
+public:
+    EngineNamespaces(const std::map<std::string, std::string> &config, Engine &_defaultEngine) {
+        defaultNamespace.name = "default";
+        defaultNamespace.engine = &_defaultEngine;
+        for (const auto &options: parseNamespaceOptions(config)) {
+            auto ns = std::make_unique<Namespace>();
+            ns->name = options.name;
+            ns->options = options;
+
+            // 命名空间引擎沿用主配置（窗口实现、位图内存等），撤回日志写入独立的子目录；共享内存导出与启动快照只属于默认引擎
+            ns->config = config;
+            ns->config["engine_namespace"] = options.name;
+            ns->config["shm_export_path"] = "";
+            ns->config["startup_snapshot_path"] = "";
+            if (const std::string logDir = getConfigOrDefault(config, "log_file_path", ""); !logDir.empty()) {
+                ns->config["log_file_path"] = (std::filesystem::path(logDir) / ("ns_" + options.name)).string();
+                std::filesystem::create_directories(ns->config["log_file_path"]);
+            }
+            ns->ownedEngine = std::make_unique<Engine>(ns->config);
+            ns->engine = ns->ownedEngine.get();
+            ns->engine->init(options.maxJwtLifeTime, options.rotationInterval, options.bloomFilterSize,
+                             options.hashFunctionNum);
+
+            for (const auto &issuer: options.issuers) {
+                if (!byIssuer.emplace(issuer, ns.get()).second) {
+                    throw std::invalid_argument("Issuer " + issuer + " belongs to more than one namespace");
+                }
+            }
+            const unsigned long windows = ceilDiv(options.maxJwtLifeTime, options.rotationInterval);
+            const double usedBits = static_cast<double>(windows) * static_cast<double>(options.bloomFilterSize);
+            std::cout << "[Namespaces] " << options.name << ": " << options.issuers.size() << " issuer(s), maxJwtLifeTime " <<
+                    options.maxJwtLifeTime << ", rotationInterval " << options.rotationInterval << ", " << windows <<
+                    " windows x " << static_cast<double>(options.bloomFilterSize) / 8388608 << " MBytes = " <<
+                    usedBits / 8388608 << " of " << options.budgetBits / 8388608 << " MBytes budget share" << std::endl;
+            // 向下取整到 2 的幂最多浪费接近一半的份额：提示调整权重或预算，使份额接近窗口数乘以 2 的幂
+            if (usedBits < options.budgetBits * 0.75) {
+                std::cerr << "[Namespaces] " << options.name << " uses only " <<
+                        static_cast<int>(100 * usedBits / options.budgetBits) <<
+                        "% of its budget share (window size is rounded down to a power of 2); adjust memory_weight or "
+                        "namespace_memory_budget_mb" << std::endl;
+            }
+            namespaces.push_back(std::move(ns));
+        }
+        registerMetrics(defaultNamespace);
+        for (const auto &ns: namespaces) registerMetrics(*ns);
+    }
+
+    ~EngineNamespaces() {
+        for (const auto &name: callbackNames) MetricsRegistry::instance().unregisterGaugeCallback(name);
+    }
+
+    EngineNamespaces(const EngineNamespaces &) = delete;
+
+    EngineNamespaces &operator=(const EngineNamespaces &) = delete;
+
+    bool isRevoked(const std::string &iss, const std::string &token, const time_t &expTime) {
+        Namespace &ns = select(iss);
+        ns.queries->inc();
+        return ns.engine->isRevoked(token, expTime);
+    }
+
+    bool isSubjectRevoked(const std::string &iss, const std::string &sub, const time_t &iat) {
+        return select(iss).engine->isSubjectRevoked(iss, sub, iat);
+    }
+
+    void revokeJwt(const std::string &iss, const std::string &token, const time_t &expTime) {
+        Namespace &ns = select(iss);
+        ns.revokes->inc();
+        ns.engine->revokeJwt(token, expTime);
+    }
+
+    void revokeSubject(const std::string &iss, const std::string &sub, const time_t &before) {
+        select(iss).engine->revokeSubject(iss, sub, before);
+    }
+
+    void logRevoke(const std::string &iss, const std::string &token, const time_t &expTime) {
+        select(iss).engine->logRevoke(token, expTime);
+    }
+
+    void logRevokeSubject(const std::string &iss, const std::string &sub, const time_t &before) {
+        select(iss).engine->logRevokeSubject(iss, sub, before);
+    }
+
+    // 各命名空间的撤回日志目录与代表签发者（slave_node 把日志转发给 proxy_node 时使用）
+    std::vector<std::pair<std::string, std::string> > getLogDirs() const {
+        std::vector<std::pair<std::string, std::string> > dirs;
+        for (const auto &ns: namespaces) {
+            if (const auto it = ns->config.find("log_file_path"); it != ns->config.end()) {
+                dirs.emplace_back(it->second, ns->options.issuers.front());
+            }
+        }
+        return dirs;
+    }
+
+private:
+    struct Namespace {
+        std::string name;
+        Engine *engine = nullptr;
+        NamespaceOptions options;
+        std::map<std::string, std::string> config; // 生命周期覆盖引擎（Engine 只保存配置的引用）
+        std::unique_ptr<Engine> ownedEngine;
+        Counter *queries = nullptr;
+        Counter *revokes = nullptr;
+    };
+
+    Namespace defaultNamespace;
+    std::vector<std::unique_ptr<Namespace> > namespaces;
+    std::unordered_map<std::string, Namespace *> byIssuer;
+    std::vector<std::string> callbackNames;
+
+    Namespace &select(const std::string &iss) {
+        if (iss.empty() || byIssuer.empty()) return defaultNamespace;
+        const auto it = byIssuer.find(iss);
+        return it == byIssuer.end() ? defaultNamespace : *it->second;
+    }
+
+    // 每个命名空间的查询数、撤回数、窗口内存与最旧窗口（写入最多）的估计误判率
+    void registerMetrics(Namespace &ns) {
+        const std::string label = "{namespace=\"" + ns.name + "\"}";
+        MetricsRegistry &registry = MetricsRegistry::instance();
+        ns.queries = &registry.counter("revoker_namespace_queries_total" + label, "Queries per engine namespace");
+        ns.revokes = &registry.counter("revoker_namespace_revokes_total" + label, "Revokes per engine namespace");
+        Engine *engine = ns.engine;
+        callbackNames.push_back("revoker_namespace_filter_bytes" + label);
+        registry.registerGaugeCallback(callbackNames.back(), "Memory allocated by the windows of an engine namespace",
+                                       [engine] { return static_cast<double>(engine->getFilterMemoryBytes()); });
+        callbackNames.push_back("revoker_namespace_oldest_window_fpr" + label);
+        registry.registerGaugeCallback(callbackNames.back(),
+                                       "Estimated false positive rate of the oldest (fullest) window of an engine namespace",
+                                       [engine] {
+                                           const auto fpr = engine->getBloomFilterEstimatedFpr();
+                                           return fpr.empty() ? 0.0 : fpr.front();
+                                       });
+    }
+};
+
+#endif //ENGINE_NAMESPACES_HPP
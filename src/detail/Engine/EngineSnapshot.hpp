@@ -0,0 +1,177 @@
+#ifndef ENGINE_SNAPSHOT_HPP
+#define ENGINE_SNAPSHOT_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "WindowFilterFactory.hpp"
+#include "../Utils/BinaryIO.hpp"
+
+// 引擎快照：magic、版本、参数、保存时刻、各窗口（WindowFilter::serialize）、主体记录。
+// 由 Engine（saveSnapshot / 热重启交接）与离线构建工具 revoker_build 写出，格式只用于同一平台
+inline constexpr uint64_t SNAPSHOT_MAGIC = 0x50414e5352574a31ULL; // "1JWRSNAP"
+inline constexpr uint32_t SNAPSHOT_VERSION = 1;
+inline constexpr size_t SNAPSHOT_SUBJECT_BYTES = sizeof(uint64_t) + 2 * sizeof(int64_t); // key、水位线、记录过期时刻
+
+struct EngineSnapshot {
+    unsigned int hashFunctionNum = 0;
+    unsigned long maxJwtLifeTime = 0;
+    unsigned long rotationInterval = 0;
+    size_t bloomFilterSize = 0;
+    time_t savedAt = 0;
+    std::vector<std::unique_ptr<WindowFilter> > filters;
+    std::vector<std::tuple<uint64_t, time_t, time_t> > subjects; // key、水位线、记录过期时刻
+};
+
+// 追加到 out 末尾；forEachSubject(fn) 对每条主体记录调用 fn(key, before, expireAt)
+template<typename ForEachSubject>
+void serializeEngineSnapshot(std::string &out, const unsigned int hashFunctionNum, const unsigned long maxJwtLifeTime,
+                             const unsigned long rotationInterval, const size_t bloomFilterSize, const time_t savedAt,
+                             const std::vector<std::unique_ptr<WindowFilter> > &filters, ForEachSubject &&forEachSubject) {
+    appendPod(out, SNAPSHOT_MAGIC);
+    appendPod(out, SNAPSHOT_VERSION);
+    appendPod<uint32_t>(out, hashFunctionNum);
+    appendPod<uint64_t>(out, maxJwtLifeTime);
+    appendPod<uint64_t>(out, rotationInterval);
+    appendPod<uint64_t>(out, bloomFilterSize);
+    appendPod<int64_t>(out, savedAt);
+    appendPod<uint32_t>(out, filters.size());
+    for (const auto &filter: filters) filter->serialize(out);
+
+    // 主体记录数写在记录之前：先占位，遍历后回填
+    const size_t countOffset = out.size();
+    appendPod<uint64_t>(out, 0);
+    uint64_t subjectNum = 0;
+    forEachSubject([&out, &subjectNum](const uint64_t key, const time_t before, const time_t expireAt) {
+        appendPod<uint64_t>(out, key);
+        appendPod<int64_t>(out, before);
+        appendPod<int64_t>(out, expireAt);
+        ++subjectNum;
+    });
+    std::memcpy(out.data() + countOffset, &subjectNum, sizeof(subjectNum));
+}
+
+inline EngineSnapshot parseEngineSnapshot(const std::string_view data, const std::string &source,
+                                          const WindowFilterOptions &filterOptions) {
+    std::string_view in(data);
+    if (readPod<uint64_t>(in) != SNAPSHOT_MAGIC || readPod<uint32_t>(in) != SNAPSHOT_VERSION) {
+        throw std::runtime_error("Not an engine snapshot or unsupported version: " + source);
+    }
+    EngineSnapshot snapshot;
+    snapshot.hashFunctionNum = readPod<uint32_t>(in);
+    snapshot.maxJwtLifeTime = readPod<uint64_t>(in);
+    snapshot.rotationInterval = readPod<uint64_t>(in);
+    snapshot.bloomFilterSize = readPod<uint64_t>(in);
+    snapshot.savedAt = static_cast<time_t>(readPod<int64_t>(in));
+    const auto _filtersNum = readPod<uint32_t>(in);
+    if (snapshot.hashFunctionNum == 0 || snapshot.rotationInterval == 0 || snapshot.bloomFilterSize == 0 ||
+        _filtersNum != (snapshot.maxJwtLifeTime + snapshot.rotationInterval - 1) / snapshot.rotationInterval) {
+        throw std::runtime_error("Invalid engine snapshot parameters: " + source);
+    }
+    snapshot.filters.reserve(_filtersNum);
+    for (uint32_t i = 0; i < _filtersNum; ++i) {
+        snapshot.filters.push_back(deserializeWindowFilter(in, filterOptions));
+        if (snapshot.filters.back()->isSealed()) throw std::runtime_error("Snapshot contains sealed windows: " + source);
+    }
+    // 记录数超出剩余数据能容纳的条数时，快照被截断或损坏（先校验再分配内存）
+    const auto subjectNum = readPod<uint64_t>(in);
+    if (subjectNum > in.size() / SNAPSHOT_SUBJECT_BYTES) {
+        throw std::runtime_error("Truncated or corrupt engine snapshot (subject records): " + source);
+    }
+    snapshot.subjects.resize(subjectNum);
+    for (auto &[key, before, expireAt]: snapshot.subjects) {
+        key = readPod<uint64_t>(in);
+        before = static_cast<time_t>(readPod<int64_t>(in));
+        expireAt = static_cast<time_t>(readPod<int64_t>(in));
+    }
+    return snapshot;
+}
+
+// 先写临时文件再重命名，读端不会看到写了一半的快照
+inline void writeSnapshotFile(const std::string &path, const std::string &data) {
+    const std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) throw std::runtime_error("Cannot open snapshot file: " + tmpPath);
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!file.flush()) throw std::runtime_error("Cannot write snapshot file: " + tmpPath);
+    }
+    std::filesystem::rename(tmpPath, path);
+}
+
+// 只读映射的快照文件：窗口直接从映射的页中反序列化，不再先把整个文件读入一份缓冲区（Windows 上回退为读入内存）
+class MappedSnapshotFile {
+public:
+    explicit MappedSnapshotFile(const std::string &path) {
+#if defined(_WIN32)
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) throw std::runtime_error("Cannot open snapshot file: " + path);
+        buffer.assign(std::istreambuf_iterator(file), std::istreambuf_iterator<char>());
+        view = buffer;
+#else
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) throw std::system_error(errno, std::generic_category(), "Cannot open snapshot file " + path);
+        struct stat st{};
+        if (::fstat(fd, &st) != 0) {
+            const int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "fstat " + path);
+        }
+        mappedBytes = static_cast<size_t>(st.st_size);
+        if (mappedBytes > 0) {
+            void *addr = ::mmap(nullptr, mappedBytes, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr == MAP_FAILED) {
+                const int error = errno;
+                ::close(fd);
+                throw std::system_error(error, std::generic_category(), "mmap " + path);
+            }
+            ::madvise(addr, mappedBytes, MADV_SEQUENTIAL);
+            mapped = addr;
+            view = std::string_view(static_cast<const char *>(addr), mappedBytes);
+        }
+        ::close(fd);
+#endif
+    }
+
+    ~MappedSnapshotFile() {
+#if !defined(_WIN32)
+        if (mapped) ::munmap(mapped, mappedBytes);
+#endif
+    }
+
+    MappedSnapshotFile(const MappedSnapshotFile &) = delete;
+
+    MappedSnapshotFile &operator=(const MappedSnapshotFile &) = delete;
+
+    std::string_view data() const { return view; }
+
+private:
+    std::string_view view;
+#if defined(_WIN32)
+    std::string buffer;
+#else
+    void *mapped = nullptr;
+    size_t mappedBytes = 0;
+#endif
+};
+
+#endif //ENGINE_SNAPSHOT_HPP
@@ -1,7 +1,22 @@
 /*************************** HEADER FILES ***************************/
 #include <memory.h>
+#include <cstring>
+#include <algorithm>
+#include <string>
 #include "SHA256.h"
 
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SHA256_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define SHA256_TARGET(x)
+#else
+#include <cpuid.h>
+#define SHA256_TARGET(x) __attribute__((target(x)))
+#endif
+#endif
+
 /****************************** MACROS ******************************/
 #define ROTLEFT(a, b) (((a) << (b)) | ((a) >> (32 - (b))))
 #define ROTRIGHT(a, b) (((a) >> (b)) | ((a) << (32 - (b))))
@@ -14,7 +29,7 @@
 #define SIG1(x) (ROTRIGHT(x, 17) ^ ROTRIGHT(x, 19) ^ ((x) >> 10))
 
 /**************************** VARIABLES *****************************/
-static constexpr SHA256::WORD k[64] = {
+alignas(32) static constexpr SHA256::WORD k[64] = {
         0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
         0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
         0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
@@ -24,110 +39,386 @@ static constexpr SHA256::WORD k[64] = {
         0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
         0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
 
+static constexpr SHA256::WORD initState[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
 /*********************** FUNCTION DEFINITIONS ***********************/
-void sha256_transform(SHA256::SHA256_CTX *ctx, const SHA256::BYTE data[]) {
-    SHA256::WORD i, j, m[64];
-
-    for (i = 0, j = 0; i < 16; ++i, j += 4)
-        m[i] = (data[j] << 24) | (data[j + 1] << 16) | (data[j + 2] << 8) | (data[j + 3]);
-    for (; i < 64; ++i)
-        m[i] = SIG1(m[i - 2]) + m[i - 7] + SIG0(m[i - 15]) + m[i - 16];
-
-    SHA256::WORD a = ctx->state[0];
-    SHA256::WORD b = ctx->state[1];
-    SHA256::WORD c = ctx->state[2];
-    SHA256::WORD d = ctx->state[3];
-    SHA256::WORD e = ctx->state[4];
-    SHA256::WORD f = ctx->state[5];
-    SHA256::WORD g = ctx->state[6];
-    SHA256::WORD h = ctx->state[7];
-
-    for (i = 0; i < 64; ++i) {
-        const SHA256::WORD t1 = h + EP1(e) + CH(e, f, g) + k[i] + m[i];
-        const SHA256::WORD t2 = EP0(a) + MAJ(a, b, c);
+// 压缩函数：state 为 8 个工作变量，data 指向 blocks 个连续的 64 字节分组
+static void sha256_transform_scalar(SHA256::WORD state[8], const SHA256::BYTE *data, size_t blocks) {
+    for (; blocks > 0; --blocks, data += 64) {
+        SHA256::WORD i, j, m[64];
+
+        for (i = 0, j = 0; i < 16; ++i, j += 4)
+            m[i] = (data[j] << 24) | (data[j + 1] << 16) | (data[j + 2] << 8) | (data[j + 3]);
+        for (; i < 64; ++i)
+            m[i] = SIG1(m[i - 2]) + m[i - 7] + SIG0(m[i - 15]) + m[i - 16];
+
+        SHA256::WORD a = state[0];
+        SHA256::WORD b = state[1];
+        SHA256::WORD c = state[2];
+        SHA256::WORD d = state[3];
+        SHA256::WORD e = state[4];
+        SHA256::WORD f = state[5];
+        SHA256::WORD g = state[6];
+        SHA256::WORD h = state[7];
+
+        for (i = 0; i < 64; ++i) {
+            const SHA256::WORD t1 = h + EP1(e) + CH(e, f, g) + k[i] + m[i];
+            const SHA256::WORD t2 = EP0(a) + MAJ(a, b, c);
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+}
+
+// 将末尾不足一个分组的数据与填充（0x80、补零、64 位大端比特长度）写入 tail，返回填充后的分组数（1 或 2）
+static size_t sha256_pad_tail(const SHA256::BYTE *rest, const size_t restLen, const unsigned long long bitlen,
+                              SHA256::BYTE tail[128]) {
+    const size_t blocks = restLen < 56 ? 1 : 2;
+    memcpy(tail, rest, restLen);
+    tail[restLen] = 0x80;
+    memset(tail + restLen + 1, 0, blocks * 64 - restLen - 1);
+    for (int i = 0; i < 8; ++i) tail[blocks * 64 - 1 - i] = static_cast<SHA256::BYTE>(bitlen >> (i * 8));
+    return blocks;
+}
+
+// 大端输出摘要
+static void sha256_store_digest(const SHA256::WORD state[8], SHA256::BYTE hash[]) {
+    for (int i = 0; i < 4; ++i) {
+        for (int w = 0; w < 8; ++w) hash[i + w * 4] = (state[w] >> (24 - i * 8)) & 0x000000ff;
+    }
+}
+
+#ifdef SHA256_X86
+/************************* x86 SHA EXTENSIONS ***********************/
+// 一组 4 轮：cur 为本组消息字，prev / next 为前后相邻的消息字，g 为组号（0~15）
+#define SHA_NI_QUAD(g, cur, prev, next)                                                             \
+    do {                                                                                           \
+        __m128i msg = _mm_add_epi32(cur, _mm_load_si128(reinterpret_cast<const __m128i *>(&k[(g) * 4]))); \
+        state1 = _mm_sha256rnds2_epu32(state1, state0, msg);                                       \
+        if ((g) >= 3 && (g) <= 14) {                                                               \
+            next = _mm_add_epi32(next, _mm_alignr_epi8(cur, prev, 4));                             \
+            next = _mm_sha256msg2_epu32(next, cur);                                                \
+        }                                                                                          \
+        msg = _mm_shuffle_epi32(msg, 0x0E);                                                        \
+        state0 = _mm_sha256rnds2_epu32(state0, state1, msg);                                       \
+        if ((g) >= 1 && (g) <= 12) prev = _mm_sha256msg1_epu32(prev, cur);                         \
+    } while (0)
+
+SHA256_TARGET("sha,sse4.1,ssse3")
+static void sha256_transform_shani(SHA256::WORD state[8], const SHA256::BYTE *data, size_t blocks) {
+    const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    // 将 a~h 重排为指令要求的 ABEF / CDGH 布局
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(&state[0])), 0xB1);
+    __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(&state[4])), 0x1B);
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+    for (; blocks > 0; --blocks, data += 64) {
+        const __m128i abefSave = state0;
+        const __m128i cdghSave = state1;
+
+        __m128i msg0 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0)), byteSwap);
+        __m128i msg1 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 16)), byteSwap);
+        __m128i msg2 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 32)), byteSwap);
+        __m128i msg3 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 48)), byteSwap);
+
+        SHA_NI_QUAD(0, msg0, msg3, msg1);
+        SHA_NI_QUAD(1, msg1, msg0, msg2);
+        SHA_NI_QUAD(2, msg2, msg1, msg3);
+        SHA_NI_QUAD(3, msg3, msg2, msg0);
+        SHA_NI_QUAD(4, msg0, msg3, msg1);
+        SHA_NI_QUAD(5, msg1, msg0, msg2);
+        SHA_NI_QUAD(6, msg2, msg1, msg3);
+        SHA_NI_QUAD(7, msg3, msg2, msg0);
+        SHA_NI_QUAD(8, msg0, msg3, msg1);
+        SHA_NI_QUAD(9, msg1, msg0, msg2);
+        SHA_NI_QUAD(10, msg2, msg1, msg3);
+        SHA_NI_QUAD(11, msg3, msg2, msg0);
+        SHA_NI_QUAD(12, msg0, msg3, msg1);
+        SHA_NI_QUAD(13, msg1, msg0, msg2);
+        SHA_NI_QUAD(14, msg2, msg1, msg3);
+        SHA_NI_QUAD(15, msg3, msg2, msg0);
+
+        state0 = _mm_add_epi32(state0, abefSave);
+        state1 = _mm_add_epi32(state1, cdghSave);
+    }
+
+    // 还原为 a~h 顺序
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(&state[0]), state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(&state[4]), state1);
+}
+
+#undef SHA_NI_QUAD
+
+/************************ AVX2 MULTI-BUFFER ************************/
+#define rotr(x, n) _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - (n)))
+
+// 8 条消息各占一个 32 位通道，同时完成一个分组的压缩；active 为通道掩码，未激活的通道状态保持不变
+SHA256_TARGET("avx2")
+static void sha256_transform_x8_avx2(__m256i state[8], const SHA256::BYTE *const data[8], const __m256i active) {
+    const __m256i byteSwap = _mm256_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+                                             12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+    __m256i m[16];
+    for (int i = 0; i < 16; ++i) {
+        SHA256::WORD w[8];
+        for (int lane = 0; lane < 8; ++lane) memcpy(&w[lane], data[lane] + i * 4, 4);
+        m[i] = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(w)), byteSwap);
+    }
+
+    __m256i a = state[0], b = state[1], c = state[2], d = state[3];
+    __m256i e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; ++i) {
+        if (i >= 16) {
+            const __m256i w15 = m[(i - 15) & 15];
+            const __m256i w2 = m[(i - 2) & 15];
+            const __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(rotr(w15, 7), rotr(w15, 18)),
+                                                _mm256_srli_epi32(w15, 3));
+            const __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(rotr(w2, 17), rotr(w2, 19)),
+                                                _mm256_srli_epi32(w2, 10));
+            m[i & 15] = _mm256_add_epi32(_mm256_add_epi32(m[i & 15], s0),
+                                         _mm256_add_epi32(m[(i - 7) & 15], s1));
+        }
+        const __m256i ep1 = _mm256_xor_si256(_mm256_xor_si256(rotr(e, 6), rotr(e, 11)), rotr(e, 25));
+        const __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+        const __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(_mm256_add_epi32(h, ep1), ch),
+                                            _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(k[i])), m[i & 15]));
+        const __m256i ep0 = _mm256_xor_si256(_mm256_xor_si256(rotr(a, 2), rotr(a, 13)), rotr(a, 22));
+        const __m256i maj = _mm256_xor_si256(_mm256_and_si256(a, b),
+                                             _mm256_and_si256(c, _mm256_xor_si256(a, b)));
+        const __m256i t2 = _mm256_add_epi32(ep0, maj);
         h = g;
         g = f;
         f = e;
-        e = d + t1;
+        e = _mm256_add_epi32(d, t1);
         d = c;
         c = b;
         b = a;
-        a = t1 + t2;
+        a = _mm256_add_epi32(t1, t2);
     }
 
-    ctx->state[0] += a;
-    ctx->state[1] += b;
-    ctx->state[2] += c;
-    ctx->state[3] += d;
-    ctx->state[4] += e;
-    ctx->state[5] += f;
-    ctx->state[6] += g;
-    ctx->state[7] += h;
+    const __m256i out[8] = {a, b, c, d, e, f, g, h};
+    for (int i = 0; i < 8; ++i) {
+        state[i] = _mm256_blendv_epi8(state[i], _mm256_add_epi32(state[i], out[i]), active);
+    }
 }
 
-void SHA256::sha256_init(SHA256_CTX *ctx) {
-    ctx->datalen = 0;
-    ctx->bitlen = 0;
-    ctx->state[0] = 0x6a09e667;
-    ctx->state[1] = 0xbb67ae85;
-    ctx->state[2] = 0x3c6ef372;
-    ctx->state[3] = 0xa54ff53a;
-    ctx->state[4] = 0x510e527f;
-    ctx->state[5] = 0x9b05688c;
-    ctx->state[6] = 0x1f83d9ab;
-    ctx->state[7] = 0x5be0cd19;
-}
-
-void SHA256::sha256_update(SHA256_CTX *ctx, const BYTE data[], const size_t len) {
-    for (WORD i = 0; i < len; ++i) {
-        ctx->data[ctx->datalen] = data[i];
-        ctx->datalen++;
-        if (ctx->datalen == 64) {
-            sha256_transform(ctx, ctx->data);
-            ctx->bitlen += 512;
-            ctx->datalen = 0;
+// 最多 8 条长度各异的消息：逐分组推进，已结束的通道被掩码屏蔽
+SHA256_TARGET("avx2")
+static void sha256_x8_avx2(const SHA256::BYTE *const data[], const size_t len[], const size_t n,
+                           SHA256::BYTE hash[][SHA256_BLOCK_SIZE]) {
+    alignas(64) static constexpr SHA256::BYTE zeroBlock[64] = {};
+    SHA256::BYTE tail[8][128];
+    size_t fullBlocks[8] = {}, totalBlocks[8] = {}, maxBlocks = 0;
+    for (size_t lane = 0; lane < n; ++lane) {
+        fullBlocks[lane] = len[lane] / 64;
+        totalBlocks[lane] = fullBlocks[lane] + sha256_pad_tail(data[lane] + fullBlocks[lane] * 64, len[lane] % 64,
+                                                               static_cast<unsigned long long>(len[lane]) * 8,
+                                                               tail[lane]);
+        maxBlocks = std::max(maxBlocks, totalBlocks[lane]);
+    }
+
+    __m256i state[8];
+    for (int i = 0; i < 8; ++i) state[i] = _mm256_set1_epi32(static_cast<int>(initState[i]));
+
+    for (size_t block = 0; block < maxBlocks; ++block) {
+        const SHA256::BYTE *ptr[8];
+        alignas(32) int mask[8];
+        for (size_t lane = 0; lane < 8; ++lane) {
+            const bool live = lane < n && block < totalBlocks[lane];
+            mask[lane] = live ? -1 : 0;
+            if (!live) ptr[lane] = zeroBlock;
+            else if (block < fullBlocks[lane]) ptr[lane] = data[lane] + block * 64;
+            else ptr[lane] = tail[lane] + (block - fullBlocks[lane]) * 64;
         }
+        sha256_transform_x8_avx2(state, ptr, _mm256_load_si256(reinterpret_cast<const __m256i *>(mask)));
+    }
+
+    alignas(32) SHA256::WORD words[8][8];
+    for (int i = 0; i < 8; ++i) _mm256_store_si256(reinterpret_cast<__m256i *>(words[i]), state[i]);
+    for (size_t lane = 0; lane < n; ++lane) {
+        SHA256::WORD laneState[8];
+        for (int i = 0; i < 8; ++i) laneState[i] = words[i][lane];
+        sha256_store_digest(laneState, hash[lane]);
     }
 }
 
-void SHA256::sha256_final(SHA256_CTX *ctx, BYTE hash[]) {
-    WORD i = ctx->datalen;
+#undef rotr
+
+/************************* CPU FEATURE DETECTION *********************/
+static void cpuidCount(const unsigned int leaf, const unsigned int subleaf, unsigned int regs[4]) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int r[4];
+    __cpuidex(r, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; ++i) regs[i] = static_cast<unsigned int>(r[i]);
+#else
+    if (!__get_cpuid_count(leaf, subleaf, &regs[0], &regs[1], &regs[2], &regs[3])) regs[0] = regs[1] = regs[2] = regs[3] = 0;
+#endif
+}
+
+static bool cpuHasShaNi() {
+    unsigned int leaf1[4], leaf7[4];
+    cpuidCount(1, 0, leaf1);
+    cpuidCount(7, 0, leaf7);
+    const bool ssse3 = leaf1[2] & (1u << 9);
+    const bool sse41 = leaf1[2] & (1u << 19);
+    const bool sha = leaf7[1] & (1u << 29);
+    return ssse3 && sse41 && sha;
+}
+
+static bool cpuHasAvx2() {
+    unsigned int leaf1[4], leaf7[4];
+    cpuidCount(1, 0, leaf1);
+    cpuidCount(7, 0, leaf7);
+    const bool osxsave = leaf1[2] & (1u << 27);
+    const bool avx = leaf1[2] & (1u << 28);
+    const bool avx2 = leaf7[1] & (1u << 5);
+    if (!(osxsave && avx && avx2)) return false;
+    // 操作系统需在上下文切换时保存 XMM / YMM 寄存器
+#if defined(_MSC_VER) && !defined(__clang__)
+    const unsigned long long xcr0 = _xgetbv(0);
+#else
+    unsigned int eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    const unsigned long long xcr0 = (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+    return (xcr0 & 0x6) == 0x6;
+}
+#endif // SHA256_X86
+
+/**************************** DISPATCH ******************************/
+using TransformFn = void (*)(SHA256::WORD state[8], const SHA256::BYTE *data, size_t blocks);
+using BatchFn = void (*)(const SHA256::BYTE *const data[], const size_t len[], size_t n,
+                         SHA256::BYTE hash[][SHA256_BLOCK_SIZE]);
+
+// 单条消息的批量回退实现：逐条调用单缓冲压缩函数
+static void sha256_batch_serial(const SHA256::BYTE *const data[], const size_t len[], const size_t n,
+                                SHA256::BYTE hash[][SHA256_BLOCK_SIZE]) {
+    for (size_t i = 0; i < n; ++i) SHA256::sha256(data[i], len[i], hash[i]);
+}
+
+struct Backend {
+    TransformFn transform = sha256_transform_scalar;
+    BatchFn batch8 = sha256_batch_serial;
+    const char *name = "scalar";
+};
+
+static Backend detectBackend() {
+    Backend backend;
+#ifdef SHA256_X86
+    const bool shaNi = cpuHasShaNi();
+    const bool avx2 = cpuHasAvx2();
+    if (shaNi) backend.transform = sha256_transform_shani;
+    // 有 SHA 指令时单条压缩已足够快，多缓冲只在缺少 SHA 指令的机器上使用
+    if (avx2 && !shaNi) backend.batch8 = sha256_x8_avx2;
+    backend.name = shaNi ? "sha-ni" : avx2 ? "avx2" : "scalar";
+#endif
+    return backend;
+}
+
+static Backend &currentBackend() {
+    static Backend backend = detectBackend();
+    return backend;
+}
+
+const char *SHA256::sha256_backend() { return currentBackend().name; }
 
-    // Pad whatever data is left in the buffer.
-    if (ctx->datalen < 56) {
-        ctx->data[i++] = 0x80;
-        while (i < 56)
-            ctx->data[i++] = 0x00;
+bool SHA256::sha256_select_backend(const char *name) {
+    const std::string want = name;
+    Backend backend;
+    if (want == "auto") {
+        backend = detectBackend();
+    } else if (want == "scalar") {
+        backend = Backend();
+#ifdef SHA256_X86
+    } else if (want == "sha-ni") {
+        if (!cpuHasShaNi()) return false;
+        backend.transform = sha256_transform_shani;
+        backend.name = "sha-ni";
+    } else if (want == "avx2") {
+        if (!cpuHasAvx2()) return false;
+        backend.batch8 = sha256_x8_avx2;
+        backend.name = "avx2";
+#endif
     } else {
-        ctx->data[i++] = 0x80;
-        while (i < 64)
-            ctx->data[i++] = 0x00;
-        sha256_transform(ctx, ctx->data);
-        memset(ctx->data, 0, 56);
+        return false;
+    }
+    currentBackend() = backend;
+    return true;
+}
+
+void SHA256::sha256_init(SHA256_CTX *ctx) {
+    ctx->datalen = 0;
+    ctx->bitlen = 0;
+    memcpy(ctx->state, initState, sizeof(initState));
+}
+
+void SHA256::sha256_update(SHA256_CTX *ctx, const BYTE data[], size_t len) {
+    const TransformFn transform = currentBackend().transform;
+
+    // 先补满缓冲区中的残留分组
+    if (ctx->datalen > 0) {
+        const size_t take = std::min<size_t>(64 - ctx->datalen, len);
+        memcpy(ctx->data + ctx->datalen, data, take);
+        ctx->datalen += static_cast<WORD>(take);
+        data += take;
+        len -= take;
+        if (ctx->datalen < 64) return;
+        transform(ctx->state, ctx->data, 1);
+        ctx->bitlen += 512;
+        ctx->datalen = 0;
     }
 
-    // Append to the padding the total message's length in bits and transform.
-    ctx->bitlen += ctx->datalen * 8;
-    ctx->data[63] = ctx->bitlen;
-    ctx->data[62] = ctx->bitlen >> 8;
-    ctx->data[61] = ctx->bitlen >> 16;
-    ctx->data[60] = ctx->bitlen >> 24;
-    ctx->data[59] = ctx->bitlen >> 32;
-    ctx->data[58] = ctx->bitlen >> 40;
-    ctx->data[57] = ctx->bitlen >> 48;
-    ctx->data[56] = ctx->bitlen >> 56;
-    sha256_transform(ctx, ctx->data);
-
-    // Since this implementation uses little endian byte ordering and SHA uses big endian,
-    // reverse all the bytes when copying the final state to the output hash.
-    for (i = 0; i < 4; ++i) {
-        hash[i] = (ctx->state[0] >> (24 - i * 8)) & 0x000000ff;
-        hash[i + 4] = (ctx->state[1] >> (24 - i * 8)) & 0x000000ff;
-        hash[i + 8] = (ctx->state[2] >> (24 - i * 8)) & 0x000000ff;
-        hash[i + 12] = (ctx->state[3] >> (24 - i * 8)) & 0x000000ff;
-        hash[i + 16] = (ctx->state[4] >> (24 - i * 8)) & 0x000000ff;
-        hash[i + 20] = (ctx->state[5] >> (24 - i * 8)) & 0x000000ff;
-        hash[i + 24] = (ctx->state[6] >> (24 - i * 8)) & 0x000000ff;
-        hash[i + 28] = (ctx->state[7] >> (24 - i * 8)) & 0x000000ff;
+    // 完整分组直接从输入压缩，不经过缓冲区
+    if (const size_t blocks = len / 64; blocks > 0) {
+        transform(ctx->state, data, blocks);
+        ctx->bitlen += 512ull * blocks;
+        data += blocks * 64;
+        len -= blocks * 64;
     }
-}
\ No newline at end of file
+
+    memcpy(ctx->data, data, len);
+    ctx->datalen = static_cast<WORD>(len);
+}
+
+void SHA256::sha256_final(SHA256_CTX *ctx, BYTE hash[]) {
+    BYTE tail[128];
+    const size_t blocks = sha256_pad_tail(ctx->data, ctx->datalen, ctx->bitlen + ctx->datalen * 8ull, tail);
+    currentBackend().transform(ctx->state, tail, blocks);
+    sha256_store_digest(ctx->state, hash);
+}
+
+void SHA256::sha256(const BYTE data[], const size_t len, BYTE hash[]) {
+    SHA256_CTX ctx;
+    sha256_init(&ctx);
+    sha256_update(&ctx, data, len);
+    sha256_final(&ctx, hash);
+}
+
+void SHA256::sha256_batch(const BYTE *const data[], const size_t len[], const size_t n, BYTE hash[][SHA256_BLOCK_SIZE]) {
+    const BatchFn batch8 = currentBackend().batch8;
+    size_t i = 0;
+    for (; i + SHA256_MULTI_BUFFER_LANES <= n; i += SHA256_MULTI_BUFFER_LANES) batch8(data + i, len + i, SHA256_MULTI_BUFFER_LANES, hash + i);
+    // 不足 8 条的尾部：多缓冲实现按掩码处理，单条回退实现逐条处理
+    if (i < n) batch8(data + i, len + i, n - i, hash + i);
+}
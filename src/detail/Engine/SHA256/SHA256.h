@@ -1,9 +1,12 @@
 #ifndef SHA256_H
 #define SHA256_H
 
+#include <cstddef>
+
 namespace SHA256 {
 
 #define SHA256_BLOCK_SIZE 32 // SHA256 outputs a 32 byte digest
+#define SHA256_MULTI_BUFFER_LANES 8 // AVX2 multi-buffer hashes 8 independent messages at once
 
     typedef unsigned char BYTE; // 8-bit byte
     typedef unsigned int WORD;    // 32-bit word, change to "long" for 16-bit machines
@@ -21,6 +24,19 @@ namespace SHA256 {
     void sha256_update(SHA256_CTX *ctx, const BYTE data[], size_t len);
 
     void sha256_final(SHA256_CTX *ctx, BYTE hash[]);
+
+    // One-shot digest of a single message.
+    void sha256(const BYTE data[], size_t len, BYTE hash[]);
+
+    // Digests of n independent messages; uses the multi-buffer backend when available.
+    void sha256_batch(const BYTE *const data[], const size_t len[], size_t n, BYTE hash[][SHA256_BLOCK_SIZE]);
+
+    // Backend picked at startup from CPUID: "sha-ni", "avx2" or "scalar".
+    const char *sha256_backend();
+
+    // Force a backend ("auto", "scalar", "sha-ni", "avx2"); returns false if the CPU lacks it.
+    // Not thread-safe: call before any hashing starts.
+    bool sha256_select_backend(const char *name);
 }
 
 #endif // SHA256_H
\ No newline at end of file
@@ -0,0 +1,211 @@
+#ifndef SCALABLE_BLOOM_FILTER_HPP
+#define SCALABLE_BLOOM_FILTER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "BaseBloomFilter.hpp"
+#include "WindowFilter.hpp"
+#include "../Utils/ConfigReader.hpp"
+
+// 可扩展布隆过滤器参数（Almeida et al., Scalable Bloom Filters）
+struct ScalingOptions {
+    bool enabled = false; // 关闭时每个窗口只有一个子过滤器，与固定尺寸的布隆过滤器完全一致
+    double fillThreshold = 0.5; // 当前子过滤器的填充率达到该值时追加新的子过滤器
+    unsigned int growth = 2; // 新子过滤器的尺寸倍数（2 的幂，保证尺寸仍为 2 的幂）
+    double tightening = 0.5; // 误判率收紧系数 r：第 i 个子过滤器的目标误判率为 P0 * r^i
+    unsigned int maxStages = 4; // 每个窗口最多的子过滤器个数（限制突发时的内存上限）
+};
+
+// 从配置中读取：bloom_filter_scalable = on | off，以及 bloom_filter_scale_* 参数
+inline ScalingOptions parseScalingOptions(const std::map<std::string, std::string> &config) {
+    ScalingOptions options;
+    const std::string scalable = getConfigOrDefault(config, "bloom_filter_scalable", "off");
+    if (scalable != "on" && scalable != "off") throw std::invalid_argument("Invalid bloom_filter_scalable: " + scalable);
+    options.enabled = scalable == "on";
+    options.fillThreshold = std::stod(getConfigOrDefault(config, "bloom_filter_scale_fill_threshold", "0.5"));
+    options.growth = std::stoul(getConfigOrDefault(config, "bloom_filter_scale_growth", "2"));
+    options.tightening = std::stod(getConfigOrDefault(config, "bloom_filter_scale_tightening", "0.5"));
+    options.maxStages = std::stoul(getConfigOrDefault(config, "bloom_filter_scale_max_stages", "4"));
+    if (options.fillThreshold <= 0 || options.fillThreshold >= 1) {
+        throw std::invalid_argument("bloom_filter_scale_fill_threshold must be in (0, 1)");
+    }
+    if (options.growth < 2 || (options.growth & (options.growth - 1)) != 0) {
+        throw std::invalid_argument("bloom_filter_scale_growth must be a power of 2 not less than 2");
+    }
+    if (options.tightening <= 0 || options.tightening >= 1) {
+        throw std::invalid_argument("bloom_filter_scale_tightening must be in (0, 1)");
+    }
+    if (options.maxStages == 0) throw std::invalid_argument("bloom_filter_scale_max_stages cannot be 0");
+    return options;
+}
+
+// 一个时间窗口：由若干子过滤器组成，写入只进入最后一个子过滤器，查询依次检查所有子过滤器。
+// 第 i 个子过滤器尺寸为 m0 * growth^i，哈希函数个数为 k0 + ceil(i * log2(1 / r))；
+// 各子过滤器的探测消息是 key_0 … key_{k-1} 的前缀，因此一次计算 requiredHashNum() 个哈希即可覆盖所有子过滤器。
+class ScalableBloomFilter final : public WindowFilter {
+public:
+    ScalableBloomFilter(const size_t size, const unsigned int hashFunctionNum, const BitmapAllocOptions &bitmapOptions = {},
+                        const ScalingOptions &scalingOptions = {})
+        : allocOptions(bitmapOptions), scaling(scalingOptions) {
+        // 预留全部子过滤器的位置，追加时不会重新分配数组，无锁查询可安全读取已发布的子过滤器
+        stages.reserve(scaling.enabled ? scaling.maxStages : 1);
+        stages.emplace_back(size, hashFunctionNum, allocOptions);
+        stageNum.store(1, std::memory_order_release);
+    }
+
+    ScalableBloomFilter(ScalableBloomFilter &&other) noexcept
+        : stages(std::move(other.stages)), allocOptions(other.allocOptions), scaling(other.scaling) {
+        stageNum.store(other.stageNum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    ScalableBloomFilter &operator=(ScalableBloomFilter &&other) noexcept {
+        stages = std::move(other.stages);
+        allocOptions = other.allocOptions;
+        scaling = other.scaling;
+        stageNum.store(other.stageNum.load(std::memory_order_relaxed), std::memory_order_release);
+        return *this;
+    }
+
+    // 写入当前子过滤器；填充率越过阈值时追加一个更大、误判率更低的子过滤器（调用方需串行化写入）
+    void add(const BloomHashes &hashes) override {
+        BaseBloomFilter &active = stages[stageNum.load(std::memory_order_relaxed) - 1];
+        active.add(hashes);
+        if (scaling.enabled && stages.size() < scaling.maxStages && active.getFillRatio() >= scaling.fillThreshold) {
+            const size_t stage = stages.size();
+            stages.emplace_back(active.getSize() * scaling.growth, stageHashFunctionNum(stage), allocOptions);
+            stageNum.store(stages.size(), std::memory_order_release);
+        }
+    }
+
+    // hashes 包含调用方读取 requiredHashNum() 时所需的哈希值个数。
+    // 之后并发追加的子过滤器需要更多哈希值，只检查 hashes 能覆盖的子过滤器（哈希函数个数随级数不减，遇到第一个覆盖不了的即停止）；
+    // 新子过滤器只包含追加之后的写入，与这次查询并发，不检查它不影响结果
+    bool contains(const BloomHashes &hashes) const override {
+        const size_t num = stageNum.load(std::memory_order_acquire);
+        for (size_t i = 0; i < num && stages[i].getHashFunctionNum() <= hashes.size(); ++i) {
+            if (stages[i].contains(hashes)) return true;
+        }
+        return false;
+    }
+
+    // 覆盖所有子过滤器所需的哈希值个数（最后一个子过滤器的哈希函数个数最多）
+    unsigned int requiredHashNum() const override {
+        return stages[stageNum.load(std::memory_order_acquire) - 1].getHashFunctionNum();
+    }
+
+    // 只保留第一个子过滤器并清空
+    void clear() override {
+        BaseBloomFilter first(stages.front().getSize(), stages.front().getHashFunctionNum(), allocOptions);
+        stages.clear();
+        stages.push_back(std::move(first));
+        stageNum.store(1, std::memory_order_release);
+    }
+
+    void serialize(std::string &out) const override {
+        appendPod(out, Tag::ScalableBloom);
+        appendPod<uint32_t>(out, static_cast<uint32_t>(getStageNum()));
+        for (size_t i = 0; i < getStageNum(); ++i) stages[i].serialize(out);
+    }
+
+    // 读取 serialize 写出的数据（不含类型标识字节）
+    static std::unique_ptr<ScalableBloomFilter> deserialize(std::string_view &in, const BitmapAllocOptions &bitmapOptions,
+                                                            const ScalingOptions &scalingOptions) {
+        const auto num = readPod<uint32_t>(in);
+        if (num == 0 || num > std::max(scalingOptions.maxStages, 1u)) {
+            throw std::runtime_error("Invalid number of bloom filter stages: " + std::to_string(num));
+        }
+        std::unique_ptr<ScalableBloomFilter> result(
+            new ScalableBloomFilter(BaseBloomFilter::deserialize(in, bitmapOptions), bitmapOptions, scalingOptions));
+        for (uint32_t i = 1; i < num; ++i) result->stages.push_back(BaseBloomFilter::deserialize(in, bitmapOptions));
+        result->stageNum.store(result->stages.size(), std::memory_order_release);
+        return result;
+    }
+
+    // 按第一个子过滤器的新尺寸折叠整个窗口，各子过滤器保持原有的尺寸倍数
+    std::unique_ptr<WindowFilter> folded(const size_t newSize) const override {
+        std::unique_ptr<ScalableBloomFilter> result(
+            new ScalableBloomFilter(stages.front().folded(newSize, allocOptions), allocOptions, scaling));
+        for (size_t i = 1; i < stages.size(); ++i) {
+            result->stages.push_back(stages[i].folded(newSize * (stages[i].getSize() / stages.front().getSize()), allocOptions));
+        }
+        result->stageNum.store(result->stages.size(), std::memory_order_release);
+        return result;
+    }
+
+    // 第一个子过滤器的尺寸（窗口的设计尺寸）
+    size_t getSize() const override { return stages.front().getSize(); }
+
+    size_t getStageNum() const override { return stageNum.load(std::memory_order_acquire); }
+
+    const char *getBacking() const override { return stages.front().getBacking(); }
+    size_t getReplicaNum() const override { return stages.front().getReplicaNum(); }
+
+    // 窗口是否已有子过滤器从稀疏形式转换为位图
+    bool isDense() const override { return stages.front().isDense(); }
+
+    void releaseSparse() override {
+        for (size_t i = 0; i < getStageNum(); ++i) stages[i].releaseSparse();
+    }
+
+    size_t getMemoryBytes() const override { return sum([](const BaseBloomFilter &f) { return f.getMemoryBytes(); }); }
+
+    unsigned long getMsgNum() const override { return sum([](const BaseBloomFilter &f) { return f.getMsgNum(); }); }
+
+    size_t getSetBitNum() const override { return sum([](const BaseBloomFilter &f) { return f.getSetBitNum(); }); }
+
+    // 所有子过滤器合计的置位比特占比
+    double getFillRatio() const override {
+        const auto bits = static_cast<double>(sum([](const BaseBloomFilter &f) { return f.getSize(); }));
+        return static_cast<double>(getSetBitNum()) / bits;
+    }
+
+    // 任一子过滤器误判即整体误判：1 - Π(1 - P_i)
+    double getEstimatedFpr() const override {
+        double pass = 1;
+        for (size_t i = 0; i < getStageNum(); ++i) pass *= 1 - stages[i].getEstimatedFpr();
+        return 1 - pass;
+    }
+
+    double getEstimatedItemNum() const override {
+        double n = 0;
+        for (size_t i = 0; i < getStageNum(); ++i) n += stages[i].getEstimatedItemNum();
+        return n;
+    }
+
+private:
+    std::vector<BaseBloomFilter> stages;
+    std::atomic<size_t> stageNum{0}; // 已发布给查询的子过滤器个数
+    BitmapAllocOptions allocOptions;
+    ScalingOptions scaling;
+
+    ScalableBloomFilter(BaseBloomFilter &&first, const BitmapAllocOptions &bitmapOptions, const ScalingOptions &scalingOptions)
+        : allocOptions(bitmapOptions), scaling(scalingOptions) {
+        stages.reserve(scaling.enabled ? scaling.maxStages : 1);
+        stages.push_back(std::move(first));
+        stageNum.store(1, std::memory_order_release);
+    }
+
+    // 第 stage 个子过滤器的哈希函数个数：每级误判率乘以 r，需要多 log2(1 / r) 个哈希函数
+    unsigned int stageHashFunctionNum(const size_t stage) const {
+        const double extra = std::ceil(static_cast<double>(stage) * std::log2(1 / scaling.tightening) - 1e-9);
+        return stages.front().getHashFunctionNum() + static_cast<unsigned int>(extra);
+    }
+
+    template<typename Fn>
+    std::invoke_result_t<Fn, const BaseBloomFilter &> sum(Fn fn) const {
+        std::invoke_result_t<Fn, const BaseBloomFilter &> total = 0;
+        for (size_t i = 0; i < getStageNum(); ++i) total += fn(stages[i]);
+        return total;
+    }
+};
+
+#endif //SCALABLE_BLOOM_FILTER_HPP
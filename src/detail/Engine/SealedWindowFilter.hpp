@@ -0,0 +1,264 @@
+#ifndef SEALED_WINDOW_FILTER_HPP
+#define SEALED_WINDOW_FILTER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "BinaryFuseFilter.hpp"
+#include "WindowFilter.hpp"
+#include "../Utils/BinaryIO.hpp"
+#include "../Utils/ConfigReader.hpp"
+
+// 窗口封存参数：后台把窗口重建为只读的二元融合过滤器
+struct SealOptions {
+    bool enabled = false;
+    unsigned long interval = 0; // 除每次轮换后封存一轮外，额外每隔多少秒封存一轮；0 表示只在轮换后封存
+    unsigned int fingerprintBits = 8; // 8 或 16
+};
+
+// 从配置中读取：window_seal = on | off，window_seal_interval = 秒，window_seal_fingerprint_bits = 8 | 16
+inline SealOptions parseSealOptions(const std::map<std::string, std::string> &config) {
+    SealOptions options;
+    const std::string seal = getConfigOrDefault(config, "window_seal", "off");
+    if (seal != "on" && seal != "off") throw std::invalid_argument("Invalid window_seal: " + seal);
+    options.enabled = seal == "on";
+    options.interval = std::stoul(getConfigOrDefault(config, "window_seal_interval", "0"));
+    options.fingerprintBits = std::stoul(getConfigOrDefault(config, "window_seal_fingerprint_bits", "8"));
+    if (options.fingerprintBits != 8 && options.fingerprintBits != 16) {
+        throw std::invalid_argument("window_seal_fingerprint_bits must be 8 or 16");
+    }
+    return options;
+}
+
+// 由一个窗口的全部键构建只读的二元融合过滤器
+inline std::unique_ptr<WindowFilter> buildSealedFilter(std::vector<uint64_t> keys, const SealOptions &options) {
+    if (options.fingerprintBits == 16) return std::make_unique<BinaryFuseFilter>(std::move(keys));
+    return std::make_unique<BinaryFuse8Filter>(std::move(keys));
+}
+
+// 封存所需的精确键：每个撤回 token 的第一个原始哈希值，按写入的最后一个窗口的编号（随轮换递增）分桶存放。
+// 窗口是嵌套的：编号为 w 的窗口恰好包含编号 >= w 的桶中的键，因此一份键表即可重建所有窗口
+class SealKeyStore {
+public:
+    void append(const uint64_t hash, const uint32_t lastWindow) {
+        const size_t index = lastWindow - firstId;
+        if (index >= buckets.size()) buckets.resize(index + 1);
+        buckets[index].push_back(hash);
+    }
+
+    // 丢弃所在窗口都已淘汰的桶
+    void prune(const uint32_t firstWindow) {
+        while (firstId < firstWindow && !buckets.empty()) {
+            buckets.pop_front();
+            ++firstId;
+        }
+        firstId = std::max(firstId, firstWindow);
+    }
+
+    uint32_t getFirstId() const { return firstId; }
+
+    size_t getBucketNum() const { return buckets.size(); }
+
+    const std::vector<uint64_t> &getBucket(const size_t index) const { return buckets[index]; }
+
+    size_t size() const {
+        size_t num = 0;
+        for (const auto &bucket: buckets) num += bucket.size();
+        return num;
+    }
+
+    size_t memoryBytes() const {
+        size_t bytes = 0;
+        for (const auto &bucket: buckets) bytes += bucket.capacity() * sizeof(uint64_t);
+        return bytes;
+    }
+
+private:
+    uint32_t firstId = 0; // buckets[0] 对应的窗口编号
+    std::deque<std::vector<uint64_t> > buckets;
+};
+
+// 上一轮封存之后写入的键：哈希值 → 写入的最后一个窗口编号。所有封存窗口共享一份。
+// 与 SparseBitSet 相同：开放寻址、只插入，扩容后旧表保留到对象销毁，查询无锁
+class RecentKeyTable {
+public:
+    RecentKeyTable() { grow(INITIAL_CAPACITY); }
+
+    // 写入由调用方串行化；同一键再次写入时保留更大的窗口编号
+    void insert(uint64_t hash, const uint32_t lastWindow) {
+        if (hash == 0) hash = 1; // 0 表示空槽
+        Table *table = current.load(std::memory_order_relaxed);
+        if (Slot *slot = find(*table, hash)) {
+            if (slot->lastWindow.load(std::memory_order_relaxed) < lastWindow) {
+                slot->lastWindow.store(lastWindow, std::memory_order_relaxed);
+            }
+            return;
+        }
+        if ((count + 1) * 2 > table->capacity()) {
+            grow(table->capacity() * 2);
+            table = current.load(std::memory_order_relaxed);
+        }
+        place(*table, hash, lastWindow);
+        ++count;
+    }
+
+    // 键是否写入过编号不小于 window 的窗口
+    bool contains(uint64_t hash, const uint32_t window) const {
+        if (hash == 0) hash = 1;
+        const Slot *slot = find(*current.load(std::memory_order_acquire), hash);
+        return slot && slot->lastWindow.load(std::memory_order_relaxed) >= window;
+    }
+
+    size_t size() const { return count; }
+
+    template<typename Fn>
+    void forEach(Fn &&fn) const {
+        const Table *table = current.load(std::memory_order_acquire);
+        for (size_t i = 0; i <= table->mask; ++i) {
+            if (const uint64_t hash = table->slots[i].hash.load(std::memory_order_acquire); hash != 0) {
+                fn(hash, table->slots[i].lastWindow.load(std::memory_order_relaxed));
+            }
+        }
+    }
+
+    size_t memoryBytes() const {
+        size_t bytes = 0;
+        for (const auto &table: tables) bytes += table->capacity() * sizeof(Slot);
+        return bytes;
+    }
+
+private:
+    static constexpr size_t INITIAL_CAPACITY = 16;
+
+    struct Slot {
+        std::atomic<uint64_t> hash{0};
+        std::atomic<uint32_t> lastWindow{0};
+    };
+
+    struct Table {
+        size_t mask;
+        std::unique_ptr<Slot[]> slots;
+
+        explicit Table(const size_t capacity) : mask(capacity - 1), slots(new Slot[capacity]) {}
+
+        size_t capacity() const { return mask + 1; }
+    };
+
+    std::atomic<Table *> current{nullptr};
+    std::vector<std::unique_ptr<Table> > tables;
+    size_t count = 0;
+
+    static Slot *find(const Table &table, const uint64_t hash) {
+        for (size_t i = hash & table.mask;; i = (i + 1) & table.mask) {
+            const uint64_t value = table.slots[i].hash.load(std::memory_order_acquire);
+            if (value == 0) return nullptr;
+            if (value == hash) return &table.slots[i];
+        }
+    }
+
+    // 先写窗口编号再发布键，查询看到键时编号已可见
+    static void place(Table &table, const uint64_t hash, const uint32_t lastWindow) {
+        size_t i = hash & table.mask;
+        while (table.slots[i].hash.load(std::memory_order_relaxed) != 0) i = (i + 1) & table.mask;
+        table.slots[i].lastWindow.store(lastWindow, std::memory_order_relaxed);
+        table.slots[i].hash.store(hash, std::memory_order_release);
+    }
+
+    void grow(const size_t capacity) {
+        auto table = std::make_unique<Table>(capacity);
+        if (const Table *old = current.load(std::memory_order_relaxed)) {
+            for (size_t i = 0; i <= old->mask; ++i) {
+                if (const uint64_t hash = old->slots[i].hash.load(std::memory_order_relaxed); hash != 0) {
+                    place(*table, hash, old->slots[i].lastWindow.load(std::memory_order_relaxed));
+                }
+            }
+        }
+        current.store(table.get(), std::memory_order_release);
+        tables.push_back(std::move(table));
+    }
+};
+
+// 封存的窗口：封存时刻的全部键构建的二元融合过滤器，加上之后写入的近期键（精确匹配）。
+// 写入只记录到共享的近期键表（由 Engine 完成），窗口本身不可变
+class SealedWindowFilter final : public WindowFilter {
+public:
+    SealedWindowFilter(std::unique_ptr<WindowFilter> _sealed, std::shared_ptr<const RecentKeyTable> _recent,
+                       const uint32_t _windowId)
+        : sealed(std::move(_sealed)), recent(std::move(_recent)), windowId(_windowId) {}
+
+    void add(const BloomHashes &hashes) override {
+        (void) hashes;
+        ++addNum;
+    }
+
+    bool contains(const BloomHashes &hashes) const override {
+        return sealed->contains(hashes) || (recent && recent->contains(hashes.data()[0], windowId));
+    }
+
+    unsigned int requiredHashNum() const override { return sealed->requiredHashNum(); }
+
+    void clear() override {
+        sealed->clear();
+        recent.reset();
+        addNum = 0;
+    }
+
+    // 序列化为独立的窗口：融合过滤器加上属于本窗口的近期键
+    void serialize(std::string &out) const override {
+        appendPod(out, Tag::Sealed);
+        sealed->serialize(out);
+        appendPod<uint64_t>(out, addNum);
+        std::vector<uint64_t> recentKeys;
+        if (recent) recent->forEach([&](const uint64_t hash, const uint32_t lastWindow) {
+            if (lastWindow >= windowId) recentKeys.push_back(hash);
+        });
+        appendPod<uint64_t>(out, recentKeys.size());
+        appendBytes(out, recentKeys.data(), recentKeys.size() * sizeof(uint64_t));
+    }
+
+    // 读取 serialize 写出的数据中融合过滤器之后的部分（融合过滤器由 deserializeWindowFilter 读出）
+    static std::unique_ptr<SealedWindowFilter> deserialize(std::string_view &in, std::unique_ptr<WindowFilter> sealed) {
+        const auto adds = readPod<uint64_t>(in);
+        auto table = std::make_shared<RecentKeyTable>();
+        for (auto n = readPod<uint64_t>(in); n > 0; --n) table->insert(readPod<uint64_t>(in), 0);
+        auto result = std::make_unique<SealedWindowFilter>(std::move(sealed), std::move(table), 0);
+        result->addNum = adds;
+        return result;
+    }
+
+    bool isSealed() const override { return true; }
+
+    size_t getSize() const override { return sealed->getSize(); }
+
+    // 近期键表由所有封存窗口共享，单独统计
+    size_t getMemoryBytes() const override { return sealed->getMemoryBytes(); }
+
+    unsigned long getMsgNum() const override { return sealed->getMsgNum() + addNum; }
+
+    size_t getSetBitNum() const override { return sealed->getSetBitNum(); }
+
+    double getFillRatio() const override { return sealed->getFillRatio(); }
+
+    double getEstimatedFpr() const override { return sealed->getEstimatedFpr(); }
+
+    double getEstimatedItemNum() const override { return sealed->getEstimatedItemNum() + static_cast<double>(addNum); }
+
+    const char *getBacking() const override { return "sealed"; }
+
+private:
+    std::unique_ptr<WindowFilter> sealed; // 二元融合过滤器
+    std::shared_ptr<const RecentKeyTable> recent;
+    uint32_t windowId;
+    unsigned long addNum = 0; // 封存后的写入次数
+};
+
+#endif //SEALED_WINDOW_FILTER_HPP
@@ -0,0 +1,93 @@
+#ifndef SPARSE_BIT_SET_HPP
+#define SPARSE_BIT_SET_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// 稀疏位集合：只记录已置位的比特位置，用于几乎为空的布隆过滤器窗口。
+// 开放寻址、只插入不删除，槽位一经写入永不移动，因此无锁查询不会漏掉已完成的插入；
+// 扩容时写入新表再发布指针，旧表保留到集合销毁，正在旧表上探测的查询仍然安全。
+class SparseBitSet {
+public:
+    SparseBitSet() { grow(INITIAL_CAPACITY); }
+
+    // 插入比特位置，返回是否为新置位（写入由调用方串行化）
+    bool insert(const uint64_t pos) {
+        if (contains(pos)) return false;
+        if ((count + 1) * 2 > current.load(std::memory_order_relaxed)->capacity()) {
+            grow(current.load(std::memory_order_relaxed)->capacity() * 2);
+        }
+        place(*current.load(std::memory_order_relaxed), pos);
+        ++count;
+        return true;
+    }
+
+    bool contains(const uint64_t pos) const {
+        const Table *table = current.load(std::memory_order_acquire);
+        for (size_t i = slotOf(pos, table->mask);; i = (i + 1) & table->mask) {
+            const uint64_t value = table->slots[i].load(std::memory_order_relaxed);
+            if (value == 0) return false;
+            if (value == pos + 1) return true;
+        }
+    }
+
+    // 遍历所有已置位的比特位置（写入方调用）
+    template<typename Fn>
+    void forEach(Fn fn) const {
+        const Table *table = current.load(std::memory_order_relaxed);
+        for (size_t i = 0; i <= table->mask; ++i) {
+            if (const uint64_t value = table->slots[i].load(std::memory_order_relaxed); value != 0) fn(value - 1);
+        }
+    }
+
+    size_t size() const { return count; }
+
+    // 占用的内存（包括扩容后保留的旧表）
+    size_t memoryBytes() const {
+        size_t bytes = 0;
+        for (const auto &table: tables) bytes += table->capacity() * sizeof(uint64_t);
+        return bytes;
+    }
+
+private:
+    static constexpr size_t INITIAL_CAPACITY = 16;
+
+    struct Table {
+        size_t mask;
+        std::unique_ptr<std::atomic<uint64_t>[]> slots; // 存放 pos + 1，0 表示空槽
+
+        explicit Table(const size_t capacity) : mask(capacity - 1), slots(new std::atomic<uint64_t>[capacity]) {
+            for (size_t i = 0; i < capacity; ++i) slots[i].store(0, std::memory_order_relaxed);
+        }
+
+        size_t capacity() const { return mask + 1; }
+    };
+
+    std::atomic<Table *> current{nullptr};
+    std::vector<std::unique_ptr<Table> > tables;
+    size_t count = 0;
+
+    // 比特位置来自哈希值，低位已足够均匀
+    static size_t slotOf(const uint64_t pos, const size_t mask) { return static_cast<size_t>(pos) & mask; }
+
+    static void place(Table &table, const uint64_t pos) {
+        size_t i = slotOf(pos, table.mask);
+        while (table.slots[i].load(std::memory_order_relaxed) != 0) i = (i + 1) & table.mask;
+        table.slots[i].store(pos + 1, std::memory_order_release);
+    }
+
+    void grow(const size_t capacity) {
+        auto table = std::make_unique<Table>(capacity);
+        if (const Table *old = current.load(std::memory_order_relaxed)) {
+            for (size_t i = 0; i <= old->mask; ++i) {
+                if (const uint64_t value = old->slots[i].load(std::memory_order_relaxed); value != 0) place(*table, value - 1);
+            }
+        }
+        current.store(table.get(), std::memory_order_release);
+        tables.push_back(std::move(table));
+    }
+};
+
+#endif //SPARSE_BIT_SET_HPP
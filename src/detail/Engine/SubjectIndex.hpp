@@ -0,0 +1,181 @@
+#ifndef SUBJECT_INDEX_HPP
+#define SUBJECT_INDEX_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "BaseBloomFilter.hpp"
+#include "../Utils/EpochDomain.hpp"
+
+// 按主体批量撤回的索引：(iss, sub) → 撤回水位线，签发时间早于水位线的 token 全部视为已撤回。
+// 一条记录代替该主体名下的所有 token 撤回，不占用窗口过滤器；水位线之前签发的 token 最迟在
+// 水位线 + maxJwtLifeTime 时过期，此后记录即可删除。
+// 开放寻址、写入由调用方串行化、查询无锁；扩容与清理过期记录时重建新表再发布，
+// 被替换的旧表在 EpochDomain::synchronize() 之后（之前进入的查询均已离开）释放
+class SubjectIndex {
+public:
+    SubjectIndex() { publish(std::make_unique<Table>(INITIAL_CAPACITY)); }
+
+    ~SubjectIndex() { delete current.load(std::memory_order_relaxed); }
+
+    SubjectIndex(const SubjectIndex &) = delete;
+
+    SubjectIndex &operator=(const SubjectIndex &) = delete;
+
+    // 主体的 64 位键：与窗口过滤器相同的 SHA256 哈希，iss 与 sub 之间以换行分隔
+    static uint64_t subjectKey(const std::string &iss, const std::string &sub) {
+        BloomHashes hashes;
+        BaseBloomFilter::hashKey(iss + '\n' + sub, 1, hashes);
+        const uint64_t key = hashes.data()[0];
+        return key == 0 ? 1 : key; // 0 表示空槽
+    }
+
+    // 撤回 before 之前签发的 token，记录保留到 expireAt；同一主体再次撤回时取更大的水位线
+    void revoke(const uint64_t key, const time_t before, const time_t expireAt) {
+        Table *table = current.load(std::memory_order_relaxed);
+        if (Slot *slot = find(*table, key)) {
+            if (slot->before.load(std::memory_order_relaxed) < before) slot->before.store(before, std::memory_order_relaxed);
+            if (slot->expireAt.load(std::memory_order_relaxed) < expireAt) slot->expireAt.store(expireAt, std::memory_order_relaxed);
+            return;
+        }
+        if ((count + 1) * 2 > table->capacity()) {
+            publish(rebuild(*table, table->capacity() * 2, 0));
+            table = current.load(std::memory_order_relaxed);
+        }
+        place(*table, key, before, expireAt);
+        ++count;
+    }
+
+    // 签发时间 iat 早于该主体的水位线时返回 true
+    bool isRevoked(const uint64_t key, const time_t iat) const {
+        const EpochDomain::ReadGuard guard;
+        const Slot *slot = find(*current.load(std::memory_order_acquire), key);
+        return slot && iat < slot->before.load(std::memory_order_relaxed);
+    }
+
+    // 删除 expireAt <= now 的记录，返回删除的条数
+    size_t purge(const time_t now) {
+        const Table *table = current.load(std::memory_order_relaxed);
+        size_t live = 0;
+        for (size_t i = 0; i <= table->mask; ++i) {
+            if (table->slots[i].key.load(std::memory_order_relaxed) != 0 &&
+                table->slots[i].expireAt.load(std::memory_order_relaxed) > now) ++live;
+        }
+        const size_t removed = count - live;
+        if (removed > 0) {
+            size_t capacity = INITIAL_CAPACITY;
+            while (live * 2 >= capacity) capacity *= 2;
+            publish(rebuild(*table, capacity, now));
+            count = live;
+        }
+        return removed;
+    }
+
+    size_t size() const { return count; }
+
+    // 遍历当前表中的记录：fn(key, before, expireAt)
+    template<typename Fn>
+    void forEach(Fn &&fn) const {
+        const EpochDomain::ReadGuard guard;
+        const Table *table = current.load(std::memory_order_acquire);
+        for (size_t i = 0; i <= table->mask; ++i) {
+            if (const uint64_t key = table->slots[i].key.load(std::memory_order_acquire); key != 0) {
+                fn(key, static_cast<time_t>(table->slots[i].before.load(std::memory_order_relaxed)),
+                   static_cast<time_t>(table->slots[i].expireAt.load(std::memory_order_relaxed)));
+            }
+        }
+    }
+
+    size_t memoryBytes() const { return current.load(std::memory_order_acquire)->capacity() * sizeof(Slot); }
+
+private:
+    static constexpr size_t INITIAL_CAPACITY = 16;
+
+    struct Slot {
+        std::atomic<uint64_t> key{0};
+        std::atomic<int64_t> before{0};
+        std::atomic<int64_t> expireAt{0};
+    };
+
+    struct Table {
+        size_t mask;
+        std::unique_ptr<Slot[]> slots;
+
+        explicit Table(const size_t capacity) : mask(capacity - 1), slots(new Slot[capacity]) {}
+
+        size_t capacity() const { return mask + 1; }
+    };
+
+    std::atomic<Table *> current{nullptr}; // 当前表（由本对象持有）
+    size_t count = 0;
+
+    static Slot *find(const Table &table, const uint64_t key) {
+        for (size_t i = key & table.mask;; i = (i + 1) & table.mask) {
+            const uint64_t value = table.slots[i].key.load(std::memory_order_acquire);
+            if (value == 0) return nullptr;
+            if (value == key) return &table.slots[i];
+        }
+    }
+
+    // 先写水位线再发布键，查询看到键时水位线已可见
+    static void place(Table &table, const uint64_t key, const time_t before, const time_t expireAt) {
+        size_t i = key & table.mask;
+        while (table.slots[i].key.load(std::memory_order_relaxed) != 0) i = (i + 1) & table.mask;
+        table.slots[i].before.store(before, std::memory_order_relaxed);
+        table.slots[i].expireAt.store(expireAt, std::memory_order_relaxed);
+        table.slots[i].key.store(key, std::memory_order_release);
+    }
+
+    // 复制 expireAt > now 的记录到新表
+    static std::unique_ptr<Table> rebuild(const Table &old, const size_t capacity, const time_t now) {
+        auto table = std::make_unique<Table>(capacity);
+        for (size_t i = 0; i <= old.mask; ++i) {
+            const Slot &slot = old.slots[i];
+            const uint64_t key = slot.key.load(std::memory_order_relaxed);
+            if (key == 0 || slot.expireAt.load(std::memory_order_relaxed) <= now) continue;
+            place(*table, key, slot.before.load(std::memory_order_relaxed), slot.expireAt.load(std::memory_order_relaxed));
+        }
+        return table;
+    }
+
+    // 发布新表，等待可能仍在读取旧表的查询离开后释放旧表（调用方不能处于 ReadGuard 之内）
+    void publish(std::unique_ptr<Table> table) {
+        const std::unique_ptr<Table> old(current.exchange(table.release(), std::memory_order_acq_rel));
+        if (old) EpochDomain::instance().synchronize();
+    }
+};
+
+// iss 与 sub 不能包含换行（日志按行存储，键以换行分隔 iss 与 sub）；sub 不能为空
+inline bool isValidSubject(const std::string &iss, const std::string &sub) {
+    return !sub.empty() && iss.find_first_of("\r\n") == std::string::npos && sub.find_first_of("\r\n") == std::string::npos;
+}
+
+// 撤回日志中的主体记录：!<before>,<iss 长度>,<iss><sub>（token 记录为 <token>,<exp>，JWT 不含 '!'）
+inline std::string formatSubjectRecord(const std::string &iss, const std::string &sub, const time_t before) {
+    return "!" + std::to_string(before) + "," + std::to_string(iss.size()) + "," + iss + sub;
+}
+
+inline bool parseSubjectRecord(const std::string_view line, std::string &iss, std::string &sub, time_t &before) {
+    if (line.empty() || line.front() != '!') return false;
+    const size_t first = line.find(',', 1);
+    if (first == std::string_view::npos) return false;
+    const size_t second = line.find(',', first + 1);
+    if (second == std::string_view::npos) return false;
+    try {
+        before = static_cast<time_t>(std::stoll(std::string(line.substr(1, first - 1))));
+        const size_t issLength = std::stoull(std::string(line.substr(first + 1, second - first - 1)));
+        if (issLength > line.size() - second - 1) return false;
+        iss = line.substr(second + 1, issLength);
+        sub = line.substr(second + 1 + issLength);
+    } catch (const std::exception &) {
+        return false;
+    }
+    return !sub.empty();
+}
+
+#endif //SUBJECT_INDEX_HPP
@@ -0,0 +1,69 @@
+#ifndef WINDOW_FILTER_HPP
+#define WINDOW_FILTER_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "BaseBloomFilter.hpp"
+
+// 时间窗口过滤器接口：Engine 的每个时间窗口由一种实现承担（布隆 / 布谷鸟 / 只读的二元融合过滤器 / 封存窗口）。
+// 写入由调用方串行化（持有 filtersMtx），查询无锁；任何实现都不允许漏报。
+class WindowFilter {
+public:
+    // 序列化数据的第一个字节，标识实现类型
+    enum class Tag : uint8_t { ScalableBloom = 1, Cuckoo = 2, BinaryFuse = 3, Sealed = 4, BinaryFuse8 = 5 };
+
+    virtual ~WindowFilter() = default;
+
+    // hashes 至少包含 requiredHashNum() 个原始哈希值（BaseBloomFilter::hashKey）
+    virtual void add(const BloomHashes &hashes) = 0;
+
+    virtual bool contains(const BloomHashes &hashes) const = 0;
+
+    virtual unsigned int requiredHashNum() const = 0;
+
+    // 清空为初始状态（只能用于尚未发布给查询的窗口）
+    virtual void clear() = 0;
+
+    // 追加到 out 末尾（本机字节序），由 deserializeWindowFilter 还原
+    virtual void serialize(std::string &out) const = 0;
+
+    // 按更小的 2 的幂尺寸折叠；不支持折叠的实现返回 nullptr
+    virtual std::unique_ptr<WindowFilter> folded(size_t newSize) const {
+        (void) newSize;
+        return nullptr;
+    }
+
+    // 设计尺寸（比特）与实际分配的内存
+    virtual size_t getSize() const = 0;
+
+    virtual size_t getMemoryBytes() const = 0;
+
+    virtual unsigned long getMsgNum() const = 0;
+
+    // 布隆过滤器为置位比特数，其他实现为已存放的指纹数
+    virtual size_t getSetBitNum() const = 0;
+
+    virtual double getFillRatio() const = 0;
+
+    virtual double getEstimatedFpr() const = 0;
+
+    virtual double getEstimatedItemNum() const = 0;
+
+    virtual size_t getStageNum() const { return 1; }
+
+    // 存储：页类型、NUMA 副本数、是否已从稀疏形式转换
+    virtual const char *getBacking() const = 0;
+
+    virtual size_t getReplicaNum() const { return 1; }
+
+    virtual bool isDense() const { return true; }
+
+    virtual void releaseSparse() {}
+
+    // 是否已由后台封存为只读结构（不再折叠）
+    virtual bool isSealed() const { return false; }
+};
+
+#endif //WINDOW_FILTER_HPP
@@ -0,0 +1,74 @@
+#ifndef WINDOW_FILTER_FACTORY_HPP
+#define WINDOW_FILTER_FACTORY_HPP
+
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "BinaryFuseFilter.hpp"
+#include "BitmapAllocator.hpp"
+#include "CuckooFilter.hpp"
+#include "ScalableBloomFilter.hpp"
+#include "SealedWindowFilter.hpp"
+#include "WindowFilter.hpp"
+#include "../Utils/ConfigReader.hpp"
+
+// 可写窗口的实现：布隆过滤器（可扩展、可折叠）或布谷鸟过滤器（每个元素比特数更少，查询最多两次缓存行访问）
+enum class WindowFilterKind { Bloom, Cuckoo };
+
+struct WindowFilterOptions {
+    WindowFilterKind kind = WindowFilterKind::Bloom;
+    BitmapAllocOptions bitmap; // 位图 / 桶数组的内存分配策略
+    ScalingOptions scaling; // 仅布隆过滤器使用
+};
+
+// 从配置中读取：window_filter = bloom | cuckoo，以及位图与扩展参数
+inline WindowFilterOptions parseWindowFilterOptions(const std::map<std::string, std::string> &config) {
+    WindowFilterOptions options;
+    const std::string kind = getConfigOrDefault(config, "window_filter", "bloom");
+    if (kind == "bloom") options.kind = WindowFilterKind::Bloom;
+    else if (kind == "cuckoo") options.kind = WindowFilterKind::Cuckoo;
+    else throw std::invalid_argument("Invalid window_filter: " + kind);
+    options.bitmap = parseBitmapAllocOptions(config);
+    options.scaling = parseScalingOptions(config);
+    return options;
+}
+
+inline const char *windowFilterKindName(const WindowFilterKind kind) {
+    return kind == WindowFilterKind::Cuckoo ? "cuckoo" : "bloom";
+}
+
+// 新窗口写入与查询至少需要的原始哈希值个数（布隆过滤器为 k，其他实现只用第一个哈希值）
+inline unsigned int baseHashNum(const WindowFilterOptions &options, const unsigned int hashFunctionNum) {
+    return options.kind == WindowFilterKind::Cuckoo ? CuckooFilter::HASH_NUM : hashFunctionNum;
+}
+
+// 创建尺寸为 size 比特的空窗口；布谷鸟过滤器忽略 hashFunctionNum
+inline std::unique_ptr<WindowFilter> makeWindowFilter(const size_t size, const unsigned int hashFunctionNum,
+                                                      const WindowFilterOptions &options) {
+    if (options.kind == WindowFilterKind::Cuckoo) return std::make_unique<CuckooFilter>(size, options.bitmap);
+    return std::make_unique<ScalableBloomFilter>(size, hashFunctionNum, options.bitmap, options.scaling);
+}
+
+// 读取 WindowFilter::serialize 写出的一个窗口并前移 in
+inline std::unique_ptr<WindowFilter> deserializeWindowFilter(std::string_view &in, const WindowFilterOptions &options) {
+    switch (readPod<WindowFilter::Tag>(in)) {
+        case WindowFilter::Tag::ScalableBloom:
+            return ScalableBloomFilter::deserialize(in, options.bitmap, options.scaling);
+        case WindowFilter::Tag::Cuckoo:
+            return CuckooFilter::deserialize(in, options.bitmap);
+        case WindowFilter::Tag::BinaryFuse:
+            return BinaryFuseFilter::deserialize(in);
+        case WindowFilter::Tag::BinaryFuse8:
+            return BinaryFuse8Filter::deserialize(in);
+        case WindowFilter::Tag::Sealed: {
+            auto sealed = deserializeWindowFilter(in, options);
+            return SealedWindowFilter::deserialize(in, std::move(sealed));
+        }
+    }
+    throw std::runtime_error("Unknown window filter type");
+}
+
+#endif //WINDOW_FILTER_FACTORY_HPP
@@ -0,0 +1,464 @@
+#ifndef HOT_RESTART_HPP
+#define HOT_RESTART_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "../Engine/Engine.hpp"
+#include "../Utils/ConfigReader.hpp"
+
+// 热重启（仅 POSIX）：新进程启动时通过 Unix 域套接字（hot_restart_socket）向正在运行的旧进程请求交接，
+// 旧进程用 SCM_RIGHTS 传来监听套接字与一个装有引擎快照的内存文件（memfd），随后停止接受新连接、
+// 在 hot_restart_drain_seconds 内处理完已有连接后退出。
+// 窗口是多态的堆对象，无法直接共享内存，因此引擎状态以快照交接：快照与"开始转发"在旧进程的同一次持锁中完成，
+// 之后旧进程收到的每条撤回记录（日志格式）都经同一个套接字转发给新进程，新进程还原快照后依次应用，不会遗漏。
+// 交接完成后新进程重新绑定 hot_restart_socket，供下一次重启使用。
+//
+// 新进程：takeover() -> Engine::setHandoffSnapshot(takeSnapshot()) -> Engine::init -> attachEngine()
+//         -> Server 使用 takeListenFd() 监听 -> serve()
+// 旧进程：serve() 收到交接请求后调用 onHandoff（Server 关闭监听并开始排空连接）
+class HotRestart {
+public:
+    explicit HotRestart(const std::map<std::string, std::string> &config) {
+        socketPath = getConfigOrDefault(config, "hot_restart_socket", "");
+        drainSeconds = std::stoul(getConfigOrDefault(config, "hot_restart_drain_seconds", "10"));
+#if defined(_WIN32)
+        if (!socketPath.empty()) throw std::runtime_error("hot_restart_socket is only supported on POSIX systems");
+#else
+        if (socketPath.size() >= sizeof(sockaddr_un::sun_path)) {
+            throw std::invalid_argument("hot_restart_socket is too long: " + socketPath);
+        }
+#endif
+    }
+
+    ~HotRestart() { stop(); }
+
+    HotRestart(const HotRestart &) = delete;
+
+    HotRestart &operator=(const HotRestart &) = delete;
+
+    bool enabled() const { return !socketPath.empty(); }
+
+    unsigned long getDrainSeconds() const { return drainSeconds; }
+
+    // 新进程：向旧进程请求交接；没有旧进程在运行时返回 false（正常冷启动）
+    bool takeover() {
+#if !defined(_WIN32)
+        if (!enabled()) return false;
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) throw std::system_error(errno, std::generic_category(), "socket");
+        if (const sockaddr_un addr = unixAddress(); ::connect(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) != 0) {
+            ::close(fd);
+            std::cout << "[HotRestart] No running instance at " << socketPath << ", starting cold" << std::endl;
+            return false;
+        }
+        setReceiveTimeout(fd, HANDSHAKE_TIMEOUT_SECONDS);
+
+        HandoffHeader request{};
+        if (!writeAll(fd, &request, sizeof(request))) {
+            ::close(fd);
+            throw std::runtime_error("Hot restart request failed: " + socketPath);
+        }
+
+        // 应答：头部 + SCM_RIGHTS（监听套接字、快照 memfd，按 flags 给出）
+        HandoffHeader reply{};
+        iovec iov{&reply, sizeof(reply)};
+        alignas(cmsghdr) char control[CMSG_SPACE(2 * sizeof(int))]{};
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        const ssize_t received = ::recvmsg(fd, &msg, MSG_CMSG_CLOEXEC | MSG_WAITALL);
+        std::vector<int> fds;
+        for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) continue;
+            const size_t num = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            for (size_t i = 0; i < num; ++i) {
+                int received_fd;
+                std::memcpy(&received_fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+                fds.push_back(received_fd);
+            }
+        }
+        const size_t expectedFds = ((reply.flags & FLAG_LISTEN_FD) ? 1 : 0) + ((reply.flags & FLAG_SNAPSHOT) ? 1 : 0);
+        if (received != sizeof(reply) || reply.magic != HANDOFF_MAGIC || reply.version != HANDOFF_VERSION ||
+            fds.size() != expectedFds) {
+            for (const int f: fds) ::close(f);
+            ::close(fd);
+            throw std::runtime_error("Invalid hot restart reply from " + socketPath);
+        }
+
+        size_t next = 0;
+        if (reply.flags & FLAG_LISTEN_FD) listenFd = fds[next++];
+        if (reply.flags & FLAG_SNAPSHOT) {
+            const int memfd = fds[next++];
+            snapshot.resize(reply.snapshotBytes);
+            size_t offset = 0;
+            while (offset < snapshot.size()) {
+                const ssize_t n = ::pread(memfd, snapshot.data() + offset, snapshot.size() - offset, static_cast<off_t>(offset));
+                if (n <= 0) break;
+                offset += n;
+            }
+            ::close(memfd);
+            if (offset != snapshot.size()) {
+                std::cerr << "[HotRestart] Truncated snapshot, recovering from log" << std::endl;
+                snapshot.clear();
+            }
+        }
+
+        // 之后旧进程转发的撤回记录在 attachEngine 之前先缓存
+        setReceiveTimeout(fd, 0);
+        forwardFd = fd;
+        receiveRunFlag.store(true);
+        receiveThread = std::thread(&HotRestart::receiveWorker, this);
+        std::cout << "[HotRestart] Took over from the running instance: listening socket " <<
+                (listenFd >= 0 ? "received" : "not received") << ", snapshot " <<
+                static_cast<double>(snapshot.size()) / 1048576 << " MBytes" << std::endl;
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // 交接得到的监听套接字（只取一次），没有时返回 -1
+    int takeListenFd() { return std::exchange(listenFd, -1); }
+
+    // 交接得到的引擎快照（只取一次），没有时为空
+    std::string takeSnapshot() { return std::move(snapshot); }
+
+    // 新进程：引擎初始化后开始应用旧进程转发的撤回记录（先应用已缓存的）
+    void attachEngine(Engine &engine) {
+        std::vector<std::string> pending;
+        {
+            std::lock_guard lock(receiveMtx);
+            attachedEngine = &engine;
+            pending.swap(pendingRecords);
+        }
+        for (const auto &line: pending) engine.applyLogRecord(line);
+        if (!pending.empty()) std::cout << "[HotRestart] Applied " << pending.size() << " forwarded revoke records" << std::endl;
+    }
+
+    // 绑定 hot_restart_socket 并等待下一个新进程的交接请求（只交接一次）；
+    // 交接后在本线程调用 onHandoff，调用方据此停止接受新连接并排空已有连接
+    void serve(Engine &engine, const int serverListenFd, std::function<void()> onHandoff) {
+#if !defined(_WIN32)
+        if (!enabled() || serveThread.joinable()) return;
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) throw std::system_error(errno, std::generic_category(), "socket");
+        ::unlink(socketPath.c_str()); // 旧进程（或崩溃遗留）的路径，旧进程仍持有的套接字不再可达
+        if (const sockaddr_un addr = unixAddress(); ::bind(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) != 0 ||
+                                                    ::listen(fd, 1) != 0) {
+            const int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "bind " + socketPath);
+        }
+        serveFd = fd;
+        serveRunFlag.store(true);
+        serveThread = std::thread(&HotRestart::serveWorker, this, std::ref(engine), serverListenFd, std::move(onHandoff));
+        std::cout << "[HotRestart] Accepting hot restart requests at " << socketPath << std::endl;
+#else
+        (void) engine, (void) serverListenFd, (void) onHandoff;
+#endif
+    }
+
+    // 停止等待交接请求（服务退出前调用，onHandoff 引用的对象随后即可销毁）；已开始的转发不受影响
+    void stopServing() {
+        serveRunFlag.store(false);
+        if (serveThread.joinable()) serveThread.join();
+#if !defined(_WIN32)
+        if (serveFd >= 0) {
+            ::close(serveFd);
+            serveFd = -1;
+            if (!handedOff.load()) ::unlink(socketPath.c_str()); // 已交接时路径属于新进程
+        }
+#endif
+    }
+
+    // 停止全部线程：旧进程先把排队的撤回记录发完再关闭转发连接；新进程停止接收
+    void stop() {
+        stopServing();
+        {
+            std::lock_guard lock(forwardMtx);
+            forwardRunFlag.store(false);
+        }
+        forwardCv.notify_all();
+        if (forwardThread.joinable()) forwardThread.join();
+#if !defined(_WIN32)
+        receiveRunFlag.store(false);
+        if (receiveThread.joinable()) {
+            ::shutdown(forwardFd, SHUT_RDWR);
+            receiveThread.join();
+        }
+        if (forwardFd >= 0) {
+            ::close(forwardFd);
+            forwardFd = -1;
+        }
+        if (listenFd >= 0) {
+            ::close(listenFd);
+            listenFd = -1;
+        }
+#endif
+    }
+
+private:
+    static constexpr uint32_t HANDOFF_MAGIC = 0x4e415648; // "HVAN"
+    static constexpr uint32_t HANDOFF_VERSION = 1;
+    static constexpr uint32_t FLAG_LISTEN_FD = 1;
+    static constexpr uint32_t FLAG_SNAPSHOT = 2;
+    static constexpr int HANDSHAKE_TIMEOUT_SECONDS = 10;
+
+    // 请求与应答共用的头部（同一台机器上的进程之间，本机字节序）
+    struct HandoffHeader {
+        uint32_t magic = HANDOFF_MAGIC;
+        uint32_t version = HANDOFF_VERSION;
+        uint32_t flags = 0;
+        uint32_t reserved = 0;
+        uint64_t snapshotBytes = 0;
+    };
+
+    std::string socketPath;
+    unsigned long drainSeconds = 10;
+
+    // 新进程：交接得到的资源
+    int listenFd = -1;
+    std::string snapshot;
+
+    // 转发连接：旧进程写、新进程读
+    int forwardFd = -1;
+
+    // 旧进程：等待交接请求
+    int serveFd = -1;
+    std::atomic<bool> serveRunFlag{false};
+    std::atomic<bool> handedOff{false};
+    std::thread serveThread;
+
+    // 旧进程：转发撤回记录（Engine 在持锁时入队，不能阻塞，因此不设上限）
+    std::mutex forwardMtx;
+    std::condition_variable forwardCv;
+    std::deque<std::string> forwardQueue;
+    std::atomic<bool> forwardRunFlag{false};
+    std::thread forwardThread;
+
+    // 新进程：接收转发的撤回记录
+    std::mutex receiveMtx;
+    Engine *attachedEngine = nullptr;
+    std::vector<std::string> pendingRecords;
+    std::atomic<bool> receiveRunFlag{false};
+    std::thread receiveThread;
+
+#if !defined(_WIN32)
+    sockaddr_un unixAddress() const {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::memcpy(addr.sun_path, socketPath.data(), socketPath.size());
+        return addr;
+    }
+
+    static void setReceiveTimeout(const int fd, const int seconds) {
+        const timeval timeout{seconds, 0};
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    }
+
+    static bool writeAll(const int fd, const void *data, size_t size) {
+        const auto *p = static_cast<const char *>(data);
+        while (size > 0) {
+            const ssize_t n = ::send(fd, p, size, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            p += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    // 把快照写入匿名内存文件，交给新进程映射或读取（不经过套接字缓冲区，也不落盘）
+    static int snapshotFd(const std::string &data) {
+#if defined(__linux__)
+        const int fd = ::memfd_create("jwtrevoker-snapshot", MFD_CLOEXEC);
+#else
+        char name[] = "/tmp/jwtrevoker-snapshot-XXXXXX";
+        const int fd = ::mkstemp(name);
+        if (fd >= 0) ::unlink(name);
+#endif
+        if (fd < 0) throw std::system_error(errno, std::generic_category(), "memfd_create");
+        size_t offset = 0;
+        while (offset < data.size()) {
+            const ssize_t n = ::pwrite(fd, data.data() + offset, data.size() - offset, static_cast<off_t>(offset));
+            if (n <= 0) {
+                const int error = errno;
+                ::close(fd);
+                throw std::system_error(error, std::generic_category(), "write snapshot");
+            }
+            offset += n;
+        }
+        return fd;
+    }
+
+    void serveWorker(Engine &engine, const int serverListenFd, const std::function<void()> onHandoff) {
+        while (serveRunFlag.load()) {
+            pollfd pfd{serveFd, POLLIN, 0};
+            if (::poll(&pfd, 1, 200) <= 0) continue;
+            const int fd = ::accept4(serveFd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd < 0) continue;
+            try {
+                if (handoff(engine, fd, serverListenFd)) {
+                    onHandoff();
+                    return;
+                }
+            } catch (const std::exception &e) {
+                std::cerr << "[HotRestart] Handoff failed: " << e.what() << std::endl;
+            }
+            ::close(fd);
+        }
+    }
+
+    // 交接成功后 fd 由转发线程持有
+    bool handoff(Engine &engine, const int fd, const int serverListenFd) {
+        setReceiveTimeout(fd, HANDSHAKE_TIMEOUT_SECONDS);
+        HandoffHeader request{};
+        if (::recv(fd, &request, sizeof(request), MSG_WAITALL) != sizeof(request) || request.magic != HANDOFF_MAGIC ||
+            request.version != HANDOFF_VERSION) {
+            std::cerr << "[HotRestart] Ignored an invalid hot restart request" << std::endl;
+            return false;
+        }
+
+        // 快照与开始转发在同一次持锁中完成：快照之后的撤回都会转发
+        std::string data;
+        forwardRunFlag.store(true);
+        engine.beginHandoff(data, [this](const std::string &record) {
+            {
+                std::lock_guard lock(forwardMtx);
+                if (!forwardRunFlag.load()) return;
+                forwardQueue.push_back(record);
+            }
+            forwardCv.notify_one();
+        });
+
+        HandoffHeader reply{};
+        std::vector<int> fds;
+        if (serverListenFd >= 0) {
+            reply.flags |= FLAG_LISTEN_FD;
+            fds.push_back(serverListenFd);
+        }
+        int memfd = -1;
+        if (!data.empty()) {
+            memfd = snapshotFd(data);
+            reply.flags |= FLAG_SNAPSHOT;
+            reply.snapshotBytes = data.size();
+            fds.push_back(memfd);
+        }
+
+        iovec iov{&reply, sizeof(reply)};
+        alignas(cmsghdr) char control[CMSG_SPACE(2 * sizeof(int))]{};
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        if (!fds.empty()) {
+            msg.msg_control = control;
+            msg.msg_controllen = CMSG_SPACE(fds.size() * sizeof(int));
+            cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_RIGHTS;
+            cmsg->cmsg_len = CMSG_LEN(fds.size() * sizeof(int));
+            std::memcpy(CMSG_DATA(cmsg), fds.data(), fds.size() * sizeof(int));
+        }
+        const ssize_t sent = ::sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if (memfd >= 0) ::close(memfd); // 新进程已持有自己的副本
+        if (sent != sizeof(reply)) {
+            // 新进程没有接管：停止转发，继续正常服务
+            engine.endHandoff();
+            std::lock_guard lock(forwardMtx);
+            forwardRunFlag.store(false);
+            forwardQueue.clear();
+            return false;
+        }
+
+        handedOff.store(true);
+        forwardFd = fd;
+        forwardThread = std::thread(&HotRestart::forwardWorker, this);
+        std::cout << "[HotRestart] Handed off to the new instance (snapshot " << static_cast<double>(data.size()) / 1048576 <<
+                " MBytes), draining connections for up to " << drainSeconds << " s" << std::endl;
+        return true;
+    }
+
+    // 停止时先发完队列中的记录；新进程断开后丢弃后续记录（它们仍由本进程写入日志）
+    void forwardWorker() {
+        std::string batch;
+        bool connected = true;
+        while (true) {
+            std::deque<std::string> records;
+            {
+                std::unique_lock lock(forwardMtx);
+                forwardCv.wait(lock, [this] { return !forwardQueue.empty() || !forwardRunFlag.load(); });
+                if (forwardQueue.empty()) break;
+                records.swap(forwardQueue);
+            }
+            if (!connected) continue;
+            batch.clear();
+            for (const auto &record: records) {
+                batch += record;
+                batch += '\n';
+            }
+            if (!writeAll(forwardFd, batch.data(), batch.size())) {
+                std::cerr << "[HotRestart] The new instance closed the forwarding connection" << std::endl;
+                connected = false;
+            }
+        }
+        ::shutdown(forwardFd, SHUT_WR);
+    }
+
+    void receiveWorker() {
+        std::string buffer;
+        char chunk[65536];
+        size_t applied = 0;
+        while (receiveRunFlag.load()) {
+            const ssize_t n = ::recv(forwardFd, chunk, sizeof(chunk), 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break; // 旧进程退出
+            buffer.append(chunk, n);
+            size_t begin = 0;
+            for (size_t end; (end = buffer.find('\n', begin)) != std::string::npos; begin = end + 1) {
+                std::string line = buffer.substr(begin, end - begin);
+                Engine *engine;
+                {
+                    std::lock_guard lock(receiveMtx);
+                    engine = attachedEngine;
+                    if (!engine) pendingRecords.push_back(std::move(line));
+                }
+                if (engine) {
+                    engine->applyLogRecord(line);
+                    ++applied;
+                }
+            }
+            buffer.erase(0, begin);
+        }
+        std::cout << "[HotRestart] Forwarding from the previous instance ended, " << applied << " records applied" <<
+                std::endl;
+    }
+#endif
+};
+
+#endif //HOT_RESTART_HPP
@@ -5,11 +5,17 @@
 #include <thread>
 #include <atomic>
 #include <string>
+#include <random>
+#include <future>
+#include <algorithm>
 #include <boost/asio.hpp>
 #include "../Utils/ThreadSafeQueue.hpp"
 #include "../Utils/StringParser.hpp"
+#include "../Utils/ConfigReader.hpp"
 #include "../Utils/JsonSerializer.hpp"
 #include "../Utils/SocketMsgFrame.hpp"
+#include "../Server/CoroutineSafeQueue.hpp"
+#include "../Metrics/Metrics.hpp"
 
 using boost::asio::io_context;
 using boost::asio::awaitable;
@@ -22,24 +28,52 @@ public:
         // 读取配置
         host = config.at("master_ip");
         port = stringToUShort(config.at("master_port"));
-
-        connect();
-        watchDogRunFlag.store(true);
-        sendRunFlag.store(true);
-        recvRunFlag.store(true);
-        watchDogThread = std::thread(&MasterSession::watchDog, this);
-        sendThread = std::thread(&MasterSession::send, this);
-        recvThread = std::thread(&MasterSession::recv, this);
+        backoffMin = std::chrono::milliseconds(stringToUInt(getConfigOrDefault(config, "reconnect_backoff_min_ms", "200")));
+        backoffMax = std::chrono::milliseconds(stringToUInt(getConfigOrDefault(config, "reconnect_backoff_max_ms", "30000")));
+        if (backoffMin.count() == 0) backoffMin = std::chrono::milliseconds(1);
+        if (backoffMax < backoffMin) backoffMax = backoffMin;
+
+        MetricsRegistry::instance().registerGaugeCallback("revoker_master_send_queue_depth",
+                                                          "Messages waiting to be sent to master",
+                                                          [this] { return static_cast<double>(sendQueue.size()); });
+        MetricsRegistry::instance().registerGaugeCallback("revoker_master_recv_queue_depth",
+                                                          "Messages from master waiting to be processed",
+                                                          [this] { return static_cast<double>(recvQueue.size()); });
+
+        // 所有链路协程（连接、收、发）都运行在同一个 io_context 上，由一个 io 线程驱动
+        std::future<void> authenticated = authPromise.get_future();
+        co_spawn(io_context_, sendLoop(), boost::asio::detached);
+        co_spawn(io_context_, connectionLoop(), [this](const std::exception_ptr &e) {
+            if (!e) return;
+            // 首次认证前的异常交给构造函数抛出，之后的异常（如认证被拒绝）视为致命错误
+            if (!authNotified) {
+                authNotified = true;
+                authPromise.set_exception(e);
+                return;
+            }
+            std::rethrow_exception(e);
+        });
+        ioThread = std::thread([this] { io_context_.run(); });
+
+        // 与原实现保持一致：构造函数阻塞，直到首次认证完成
+        try {
+            authenticated.get();
+        } catch (...) {
+            MetricsRegistry::instance().unregisterGaugeCallback("revoker_master_send_queue_depth");
+            MetricsRegistry::instance().unregisterGaugeCallback("revoker_master_recv_queue_depth");
+            io_context_.stop();
+            if (ioThread.joinable()) ioThread.join();
+            throw;
+        }
     }
 
     ~MasterSession() {
-        watchDogRunFlag.store(false);
-        sendRunFlag.store(false);
-        recvRunFlag.store(false);
-        if (watchDogThread.joinable()) watchDogThread.join();
-        if (sendThread.joinable()) sendThread.join();
-        if (recvThread.joinable()) recvThread.join();
-        sock.close();
+        MetricsRegistry::instance().unregisterGaugeCallback("revoker_master_send_queue_depth");
+        MetricsRegistry::instance().unregisterGaugeCallback("revoker_master_recv_queue_depth");
+        io_context_.stop();
+        if (ioThread.joinable()) ioThread.join();
+        boost::system::error_code ec;
+        sock.close(ec);
     }
 
     // 将消息放入发送消息队列（生产者）
@@ -48,108 +82,155 @@ public:
     // 取出接收消息队列的消息（消费者）
     std::string recvMsg() { return recvQueue.dequeue(); }
 
+    // 批量取出接收消息队列的消息，至少阻塞到一条消息，返回取出的条数（消费者）
+    size_t recvMsgBulk(std::vector<std::string> &msgs, const size_t maxMsgs) { return recvQueue.dequeueBulk(msgs, maxMsgs); }
+
+    // 投递一条空消息，唤醒阻塞在 recvMsg / recvMsgBulk 中的消费者（用于停止消费线程）
+    void wakeReceiver() { recvQueue.enqueue({}); }
+
 private:
     const std::map<std::string, std::string> &config;
     std::string host;
     unsigned short port;
 
+    // 重连退避参数（指数退避 + 随机抖动）
+    std::chrono::milliseconds backoffMin{200};
+    std::chrono::milliseconds backoffMax{30000};
+    std::mt19937 rng{std::random_device{}()};
+
     io_context io_context_;
     tcp::socket sock{io_context_};
+    std::thread ioThread;
 
-    // 消息发送队列、消息接收队列
-    ThreadSafeQueue<std::string> sendQueue{};
+    // 首次认证结果，用于唤醒构造函数
+    std::promise<void> authPromise;
+    bool authNotified = false;
+
+    // 连接状态（仅在 io 线程中访问），断开时 connectedSignal 永不超时，连接成功后被取消以唤醒发送协程
+    bool connected = false;
+    boost::asio::steady_timer connectedSignal{io_context_, boost::asio::steady_timer::time_point::max()};
+
+    // 消息发送队列（协程队列，任意线程可投递）、消息接收队列（阻塞队列，供调度器线程消费）
+    CoroutineSafeQueue<std::string> sendQueue{io_context_};
     ThreadSafeQueue<std::string> recvQueue{};
 
-    // 消息发送线程
-    std::thread sendThread;
-    std::atomic<bool> sendRunFlag{false};
-
-    // 消息接收线程
-    std::thread recvThread;
-    std::atomic<bool> recvRunFlag{false};
-
-    // 看门狗线程
-    bool connErrFlag = false;
-    std::thread watchDogThread;
-    std::atomic<bool> watchDogRunFlag{false};
-
-    void watchDog() {
-        while (watchDogRunFlag.load()) {
-            std::this_thread::sleep_for(std::chrono::seconds(1));
-            if (connErrFlag) {
-                std::cout << "Connection lost, try to reconnect." << std::endl;
-                sendRunFlag.store(false);
-                recvRunFlag.store(false);
-                if (sendThread.joinable()) sendThread.join();
-                if (recvThread.joinable()) recvThread.join();
-                sock.close(); // 关闭socket
-                connErrFlag = false; // 重置旗标
-                connect(); // 重新连接
-                sendRunFlag.store(true);
-                recvRunFlag.store(true);
-                sendThread = std::thread(&MasterSession::send, this);
-                recvThread = std::thread(&MasterSession::recv, this);
+    // 连接管理协程：连接 -> 接收，直到出错后立即按退避策略重连
+    awaitable<void> connectionLoop() {
+        auto backoff = backoffMin;
+        boost::asio::steady_timer backoffTimer(io_context_);
+        while (true) {
+            boost::system::error_code ec;
+            if (co_await connect(ec)) {
+                backoff = backoffMin;
+                connected = true;
+                connectedSignal.cancel();
+
+                // 接收协程在连接断开时立即返回（包括发送协程出错时主动关闭 socket）
+                co_await recvLoop();
+
+                connected = false;
+                connectedSignal.expires_at(boost::asio::steady_timer::time_point::max());
+                sock.close(ec);
+                std::cout << "[Master connection] Connection lost, try to reconnect." << std::endl;
+                continue;
             }
+
+            // 随机抖动：在 [backoff/2, backoff] 内等待，避免大量节点同时重连
+            const auto half = backoff.count() / 2;
+            const auto delay = std::chrono::milliseconds(
+                half + std::uniform_int_distribution<long long>(0, backoff.count() - half)(rng));
+            std::cerr << "[Master connection] Connection failure, try again after " << delay.count() << " ms: " <<
+                    ec.message() << std::endl;
+            backoffTimer.expires_after(delay);
+            co_await backoffTimer.async_wait(use_awaitable);
+            backoff = std::min(backoff * 2, backoffMax);
         }
     }
 
-    void connect() {
+    // 建立连接并完成认证，认证被拒绝时抛出异常
+    awaitable<bool> connect(boost::system::error_code &ec) {
         tcp::resolver resolver(io_context_);
-        const auto endpoints = resolver.resolve(host, std::to_string(port));
+        const auto endpoints = co_await resolver.async_resolve(host, std::to_string(port),
+                                                               boost::asio::redirect_error(use_awaitable, ec));
+        if (ec) co_return false;
+
+        const auto connected_endpoint = co_await boost::asio::async_connect(
+            sock, endpoints, boost::asio::redirect_error(use_awaitable, ec));
+        if (ec) {
+            boost::system::error_code ignored;
+            sock.close(ignored);
+            co_return false;
+        }
+        std::cout << "[Master connection] Master connected: " << connected_endpoint << std::endl;
+
+        std::string event_;
+        std::map<std::string, std::string> data_;
+        try {
+            // 发送认证请求
+            const std::string event = "hello_from_client";
+            std::map<std::string, std::string> data;
+            data["client_uid"] = config.at("client_uid");
+            data["token"] = config.at("token");
+            co_await asyncSendMsgToSocket(sock, msgAssembly(event, data));
+
+            // 接受认证请求
+            msgParse(co_await asyncRecvMsgFromSocket(sock), event_, data_);
+        } catch (const boost::system::system_error &e) {
+            ec = e.code();
+            boost::system::error_code ignored;
+            sock.close(ignored);
+            co_return false;
+        }
 
-        while (true) {
-            boost::system::error_code ec;
-            const auto connected_endpoint = boost::asio::connect(sock, endpoints, ec);
-            if (!ec) {
-                std::cout << "[Master connection] Master connected: " << connected_endpoint << std::endl;
-
-                // 发送认证请求
-                const std::string event = "hello_from_client";
-                std::map<std::string, std::string> data;
-                data["client_uid"] = config.at("client_uid");
-                data["token"] = config.at("token");
-                const std::string msg = msgAssembly(event, data);
-                sendMsgToSocket(sock, msg);
-
-                // 接受认证请求
-                std::string event_;
-                std::map<std::string, std::string> data_;
-                msgParse(recvMsgFromSocket(sock), event_, data_);
-
-                // 判断是否认证成功
-                if (event_ == "auth_success") {
-                    std::cout << "[Master connection] Master Authenticate success" << std::endl;
-                    break;
-                }
-                if (event_ == "auth_failed")
-                    throw std::invalid_argument("Authenticate failed, node_uid: " + config.at("client_uid") +
-                                                ", node_token: " + config.at("token"));
+        // 判断是否认证成功
+        if (event_ == "auth_success") {
+            std::cout << "[Master connection] Master Authenticate success" << std::endl;
+            if (!authNotified) {
+                authNotified = true;
+                authPromise.set_value();
             }
-            std::cerr << "[Master connection] Connection failure, try again after 5 sec: " << ec.message() << std::endl;
-            std::this_thread::sleep_for(std::chrono::seconds(5)); // 等待5秒再尝试重新连接
+            co_return true;
         }
+        if (event_ == "auth_failed")
+            throw std::invalid_argument("Authenticate failed, node_uid: " + config.at("client_uid") +
+                                        ", node_token: " + config.at("token"));
+        sock.close(ec);
+        ec = boost::asio::error::access_denied;
+        co_return false;
     }
 
-    void send() {
-        while (sendRunFlag.load()) {
-            try {
-                sendMsgToSocket(sock, sendQueue.dequeue());
-            } catch (const std::exception &e) {
-                connErrFlag = true;
-                std::cerr << "Send Error: " << e.what() << std::endl;
-                break;
+    // 发送协程：贯穿整个会话生命周期，断线期间消息保留在手中，重连后继续发送
+    awaitable<void> sendLoop() {
+        while (true) {
+            const std::string msg = co_await sendQueue.dequeue();
+            while (true) {
+                if (!connected) {
+                    boost::system::error_code ec;
+                    co_await connectedSignal.async_wait(boost::asio::redirect_error(use_awaitable, ec));
+                    continue;
+                }
+                try {
+                    co_await asyncSendMsgToSocket(sock, msg);
+                    break;
+                } catch (const std::exception &e) {
+                    // 关闭 socket，使接收协程立即返回并触发重连
+                    std::cerr << "[Master connection] Send Error: " << e.what() << std::endl;
+                    boost::system::error_code ec;
+                    sock.close(ec);
+                    connected = false;
+                }
             }
         }
     }
 
-    void recv() {
-        while (recvRunFlag.load()) {
+    // 接收协程：连接断开时返回
+    awaitable<void> recvLoop() {
+        while (true) {
             try {
-                recvQueue.enqueue(recvMsgFromSocket(sock));
+                recvQueue.enqueue(co_await asyncRecvMsgFromSocket(sock));
             } catch (const std::exception &e) {
-                connErrFlag = true;
-                std::cerr << "Receive Error: " << e.what() << std::endl;
-                break;
+                std::cerr << "[Master connection] Receive Error: " << e.what() << std::endl;
+                co_return;
             }
         }
     }
@@ -0,0 +1,243 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#define METRICS_SHARD_NUM 16
+#define METRICS_CACHE_LINE_SIZE 64
+
+// 每个线程固定映射到一个分片，记录时只写自己的分片，避免多线程争用同一缓存行
+inline unsigned int metricsShardIndex() {
+    static std::atomic<unsigned int> nextIndex{0};
+    thread_local const unsigned int index = nextIndex.fetch_add(1, std::memory_order_relaxed) % METRICS_SHARD_NUM;
+    return index;
+}
+
+// 计数器
+class Counter {
+public:
+    void inc(const uint64_t n = 1) { shards[metricsShardIndex()].value.fetch_add(n, std::memory_order_relaxed); }
+
+    uint64_t value() const {
+        uint64_t sum = 0;
+        for (const auto &shard: shards) sum += shard.value.load(std::memory_order_relaxed);
+        return sum;
+    }
+
+private:
+    struct alignas(METRICS_CACHE_LINE_SIZE) Shard {
+        std::atomic<uint64_t> value{0};
+    };
+
+    std::array<Shard, METRICS_SHARD_NUM> shards{};
+};
+
+// 瞬时值
+class Gauge {
+public:
+    void set(const int64_t v) { val.store(v, std::memory_order_relaxed); }
+    void add(const int64_t v) { val.fetch_add(v, std::memory_order_relaxed); }
+    int64_t value() const { return val.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> val{0};
+};
+
+// HDR 风格的对数线性直方图（单位：纳秒），每个 2 的幂区间再均分为 4 个子桶，相对误差不超过 25%
+class LatencyHistogram {
+public:
+    static constexpr unsigned int SUB_BUCKET_BITS = 2;
+    static constexpr unsigned int SUB_BUCKET_NUM = 1u << SUB_BUCKET_BITS;
+    static constexpr unsigned int BUCKET_NUM = SUB_BUCKET_NUM + (64 - SUB_BUCKET_BITS) * SUB_BUCKET_NUM;
+
+    void record(const uint64_t ns) {
+        Shard &shard = shards[metricsShardIndex()];
+        shard.buckets[bucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+        shard.sum.fetch_add(ns, std::memory_order_relaxed);
+    }
+
+    static unsigned int bucketIndex(const uint64_t ns) {
+        if (ns < SUB_BUCKET_NUM) return static_cast<unsigned int>(ns);
+        const unsigned int msb = 63 - std::countl_zero(ns);
+        const unsigned int sub = (ns >> (msb - SUB_BUCKET_BITS)) & (SUB_BUCKET_NUM - 1);
+        return SUB_BUCKET_NUM + (msb - SUB_BUCKET_BITS) * SUB_BUCKET_NUM + sub;
+    }
+
+    // 桶的上界（不含），单位纳秒
+    static uint64_t bucketUpperBound(const unsigned int index) {
+        if (index < SUB_BUCKET_NUM) return index + 1;
+        const unsigned int shift = (index - SUB_BUCKET_NUM) / SUB_BUCKET_NUM;
+        const uint64_t sub = (index - SUB_BUCKET_NUM) % SUB_BUCKET_NUM;
+        return (SUB_BUCKET_NUM + sub + 1) << shift;
+    }
+
+    // 汇总所有分片
+    void snapshot(std::array<uint64_t, BUCKET_NUM> &counts, uint64_t &sum) const {
+        counts.fill(0);
+        sum = 0;
+        for (const auto &shard: shards) {
+            for (unsigned int i = 0; i < BUCKET_NUM; ++i) counts[i] += shard.buckets[i].load(std::memory_order_relaxed);
+            sum += shard.sum.load(std::memory_order_relaxed);
+        }
+    }
+
+private:
+    struct alignas(METRICS_CACHE_LINE_SIZE) Shard {
+        std::array<std::atomic<uint64_t>, BUCKET_NUM> buckets{};
+        std::atomic<uint64_t> sum{0};
+    };
+
+    std::array<Shard, METRICS_SHARD_NUM> shards{};
+};
+
+// 指标注册表（进程内单例）：热路径只做分片原子加，聚合与格式化只在抓取时进行
+class MetricsRegistry {
+public:
+    static MetricsRegistry &instance() {
+        static MetricsRegistry registry;
+        return registry;
+    }
+
+    // 未启用时，ScopedTimer 不读取时钟
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+    void setEnabled(const bool e) { enabled.store(e, std::memory_order_relaxed); }
+
+    Counter &counter(const std::string &name, const std::string &help) {
+        std::lock_guard lock(mtx);
+        auto &entry = counters[name];
+        if (!entry.metric) entry = {help, std::make_unique<Counter>()};
+        return *entry.metric;
+    }
+
+    Gauge &gauge(const std::string &name, const std::string &help) {
+        std::lock_guard lock(mtx);
+        auto &entry = gauges[name];
+        if (!entry.metric) entry = {help, std::make_unique<Gauge>()};
+        return *entry.metric;
+    }
+
+    LatencyHistogram &histogram(const std::string &name, const std::string &help) {
+        std::lock_guard lock(mtx);
+        auto &entry = histograms[name];
+        if (!entry.metric) entry = {help, std::make_unique<LatencyHistogram>()};
+        return *entry.metric;
+    }
+
+    // 回调型瞬时值（如队列深度），抓取时调用；对象析构前必须注销
+    void registerGaugeCallback(const std::string &name, const std::string &help, std::function<double()> fn) {
+        std::lock_guard lock(mtx);
+        gaugeCallbacks[name] = {help, std::move(fn)};
+    }
+
+    void unregisterGaugeCallback(const std::string &name) {
+        std::lock_guard lock(mtx);
+        gaugeCallbacks.erase(name);
+    }
+
+    // 以 Prometheus 文本格式（0.0.4）输出所有指标。
+    // 计数器与瞬时值的名字可以带标签（如 name{namespace="a"}），同名的一组只输出一次 HELP / TYPE
+    std::string renderPrometheus() {
+        std::lock_guard lock(mtx);
+        std::string out;
+        char buf[128];
+        std::string lastFamily;
+        for (const auto &[name, entry]: counters) {
+            appendFamilyHeader(out, lastFamily, name, entry.help, "counter");
+            out += name + " " + std::to_string(entry.metric->value()) + "\n";
+        }
+        for (const auto &[name, entry]: gauges) {
+            appendFamilyHeader(out, lastFamily, name, entry.help, "gauge");
+            out += name + " " + std::to_string(entry.metric->value()) + "\n";
+        }
+        for (const auto &[name, entry]: gaugeCallbacks) {
+            appendFamilyHeader(out, lastFamily, name, entry.help, "gauge");
+            std::snprintf(buf, sizeof(buf), "%.17g", entry.fn());
+            out += name + " " + buf + "\n";
+        }
+        std::array<uint64_t, LatencyHistogram::BUCKET_NUM> counts{};
+        for (const auto &[name, entry]: histograms) {
+            uint64_t sum = 0;
+            entry.metric->snapshot(counts, sum);
+            out += "# HELP " + name + " " + entry.help + "\n# TYPE " + name + " histogram\n";
+            // 只输出 [256ns, 64s] 区间的桶边界，区间外的计数仍累计到相邻的桶和 +Inf 中
+            uint64_t cumulative = 0;
+            for (unsigned int i = 0; i < LatencyHistogram::BUCKET_NUM; ++i) {
+                cumulative += counts[i];
+                const uint64_t upper = LatencyHistogram::bucketUpperBound(i);
+                if (upper < 256 || upper > (1ull << 36)) continue;
+                std::snprintf(buf, sizeof(buf), "_bucket{le=\"%.9g\"} ", static_cast<double>(upper) / 1e9);
+                out += name + buf + std::to_string(cumulative) + "\n";
+            }
+            out += name + "_bucket{le=\"+Inf\"} " + std::to_string(cumulative) + "\n";
+            std::snprintf(buf, sizeof(buf), "_sum %.9f\n", static_cast<double>(sum) / 1e9);
+            out += name + buf;
+            out += name + "_count " + std::to_string(cumulative) + "\n";
+        }
+        return out;
+    }
+
+private:
+    MetricsRegistry() = default;
+
+    static void appendFamilyHeader(std::string &out, std::string &lastFamily, const std::string &name,
+                                   const std::string &help, const char *type) {
+        const std::string family = name.substr(0, name.find('{'));
+        if (family == lastFamily) return;
+        lastFamily = family;
+        out += "# HELP " + family + " " + help + "\n# TYPE " + family + " " + type + "\n";
+    }
+
+    template<typename M>
+    struct Entry {
+        std::string help;
+        std::unique_ptr<M> metric;
+    };
+
+    struct CallbackEntry {
+        std::string help;
+        std::function<double()> fn;
+    };
+
+    std::atomic<bool> enabled{false};
+    std::mutex mtx;
+    std::map<std::string, Entry<Counter> > counters;
+    std::map<std::string, Entry<Gauge> > gauges;
+    std::map<std::string, Entry<LatencyHistogram> > histograms;
+    std::map<std::string, CallbackEntry> gaugeCallbacks;
+};
+
+// 作用域计时器：析构时把耗时记录到直方图
+class ScopedTimer {
+public:
+    explicit ScopedTimer(LatencyHistogram &_histogram) : histogram(_histogram),
+                                                         active(MetricsRegistry::instance().isEnabled()) {
+        if (active) start = std::chrono::steady_clock::now();
+    }
+
+    ~ScopedTimer() {
+        if (!active) return;
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        histogram.record(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+
+    ScopedTimer(const ScopedTimer &) = delete;
+
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+    LatencyHistogram &histogram;
+    bool active;
+    std::chrono::steady_clock::time_point start;
+};
+
+#endif //METRICS_HPP
@@ -0,0 +1,109 @@
+#ifndef METRICS_SERVER_HPP
+#define METRICS_SERVER_HPP
+
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <boost/asio.hpp>
+#include "Metrics.hpp"
+#include "../Tracing/RequestTracer.hpp"
+#include "../Utils/ConfigReader.hpp"
+#include "../Utils/StringParser.hpp"
+
+using boost::asio::io_context;
+using boost::asio::awaitable;
+using boost::asio::use_awaitable;
+using boost::asio::ip::tcp;
+
+// Prometheus 抓取端点：独立的 io 线程，响应 GET /metrics 与 GET /debug/trace（请求追踪），不占用业务线程
+class MetricsServer {
+public:
+    explicit MetricsServer(const std::map<std::string, std::string> &config) {
+        const unsigned short port = stringToUShort(getConfigOrDefault(config, "metrics_port", "0"));
+        if (port == 0) return; // 未配置端口，不启用指标
+
+        const std::string ip = getConfigOrDefault(config, "metrics_ip", "0.0.0.0");
+        acceptor.open(tcp::v4());
+        acceptor.set_option(tcp::acceptor::reuse_address(true));
+#if defined(SO_REUSEPORT)
+        // 热重启期间新旧进程同时监听指标端口
+        if (!getConfigOrDefault(config, "hot_restart_socket", "").empty()) {
+            acceptor.set_option(boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>(true));
+        }
+#endif
+        acceptor.bind(tcp::endpoint(boost::asio::ip::make_address(ip), port));
+        acceptor.listen();
+        std::cout << "[Metrics] Metrics endpoint is running at: http://" << acceptor.local_endpoint() << "/metrics" <<
+                std::endl;
+
+        MetricsRegistry::instance().setEnabled(true);
+        co_spawn(io_context_, listener(), boost::asio::detached);
+        ioThread = std::thread([this] { io_context_.run(); });
+    }
+
+    ~MetricsServer() {
+        io_context_.stop();
+        if (ioThread.joinable()) ioThread.join();
+    }
+
+private:
+    io_context io_context_{1};
+    tcp::acceptor acceptor{io_context_};
+    std::thread ioThread;
+
+    // accept 失败后再次接受连接前的等待（文件描述符耗尽 EMFILE / ENFILE 等错误会持续出现，立即重试会占满指标线程）
+    static constexpr std::chrono::milliseconds ACCEPT_RETRY_DELAY{100};
+
+    awaitable<void> listener() {
+        while (true) {
+            boost::system::error_code ec;
+            tcp::socket sock = co_await acceptor.async_accept(boost::asio::redirect_error(use_awaitable, ec));
+            if (ec == boost::asio::error::operation_aborted) co_return;
+            if (ec) {
+                boost::asio::steady_timer retryTimer(io_context_, ACCEPT_RETRY_DELAY);
+                co_await retryTimer.async_wait(boost::asio::redirect_error(use_awaitable, ec));
+                continue;
+            }
+            co_spawn(io_context_, handleScrape(std::move(sock)), boost::asio::detached);
+        }
+    }
+
+    static awaitable<void> handleScrape(tcp::socket sock) {
+        try {
+            boost::asio::streambuf request;
+            co_await boost::asio::async_read_until(sock, request, "\r\n\r\n", use_awaitable);
+            std::istream is(&request);
+            std::string method, target;
+            is >> method >> target;
+
+            std::string body;
+            std::string status = "200 OK";
+            std::string contentType = "text/plain; version=0.0.4; charset=utf-8";
+            if (method != "GET") {
+                status = "405 Method Not Allowed";
+            } else if (target == "/metrics") {
+                body = MetricsRegistry::instance().renderPrometheus();
+            } else if (target == "/debug/trace") {
+                // 采样的请求追踪（Chrome trace JSON），未开启 trace_sample_rate 时为空
+                body = RequestTracer::instance().renderChromeTrace();
+                contentType = "application/json";
+            } else {
+                status = "404 Not Found";
+            }
+
+            std::string response = "HTTP/1.1 " + status + "\r\n"
+                                   "Content-Type: " + contentType + "\r\n"
+                                   "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                                   "Connection: close\r\n\r\n" + body;
+            co_await boost::asio::async_write(sock, boost::asio::buffer(response), use_awaitable);
+            boost::system::error_code ec;
+            sock.shutdown(tcp::socket::shutdown_both, ec);
+        } catch (const std::exception &e) {
+            std::cerr << "[Metrics] Scrape error: " << e.what() << std::endl;
+        }
+    }
+};
+
+#endif //METRICS_SERVER_HPP
@@ -8,6 +8,7 @@
 #include <fstream>
 #include <set>
 #include <boost/asio.hpp>
+#include "../Engine/SubjectIndex.hpp"
 #include "../Utils/JsonSerializer.hpp"
 #include "../Utils/SocketMsgFrame.hpp"
 
@@ -39,7 +40,8 @@ public:
         }
     }
 
-    void sendLogToProxyNode(const std::string &logFilePath) {
+    // tokenIss 不为空时随每条 token 记录一起发送（命名空间的日志），proxy_node 据此分派到同一个命名空间
+    void sendLogToProxyNode(const std::string &logFilePath, const std::string &tokenIss = "") {
         // 计算当前时刻的整点时间戳
         const std::time_t now_c = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
         std::tm *tm = std::localtime(&now_c);
@@ -72,6 +74,13 @@ public:
             }
             std::string line;
             while (std::getline(file, line)) {
+                // 按主体撤回的记录
+                if (std::string issuer, subject; line.starts_with('!')) {
+                    if (time_t before; parseSubjectRecord(line, issuer, subject, before)) {
+                        revokeSubject(issuer, subject, std::to_string(before));
+                    }
+                    continue;
+                }
                 std::istringstream iss(line);
 
                 // 解析 token 字符串
@@ -87,6 +96,7 @@ public:
                         std::map<std::string, std::string> data;
                         data["token"] = token;
                         data["exp_time"] = expTimeStr;
+                        if (!tokenIss.empty()) data["iss"] = tokenIss;
                         const std::string msg = msgAssembly("revoke_jwt", data);
                         sendMsgToSocket(sock, msg);
 
@@ -104,9 +114,10 @@ public:
         std::cout << "[Engine] Recover from log is done, " << fileSizes / 49 << " items have been loaded." << std::endl;
     }
 
-    // 询问 proxy_node 某个jwt是否被撤回
-    bool isRevoked(const std::string &token, const std::string &expTimeStr) {
-        std::map<std::string, std::string> data_;
+    // 询问 proxy_node 某个jwt是否被撤回（subject 为 iss / sub / iat 等附加字段）
+    bool isRevoked(const std::string &token, const std::string &expTimeStr,
+                   const std::map<std::string, std::string> &subject = {}) {
+        std::map<std::string, std::string> data_ = subject;
         data_["token"] = token;
         data_["expTime"] = expTimeStr;
         sendMsgToSocket(sock, msgAssembly("is_jwt_revoked", data_));
@@ -125,14 +136,24 @@ public:
     }
 
     // 将 jwt 发送到 proxy_node 的布隆过滤器
-    void revokeJwt(const std::string &token, const std::string &expTimeStr) {
+    void revokeJwt(const std::string &token, const std::string &expTimeStr, const std::string &iss = "") {
         std::map<std::string, std::string> data;
         data["token"] = token;
         data["exp_time"] = expTimeStr;
+        if (!iss.empty()) data["iss"] = iss;
         const std::string msg = msgAssembly("revoke_jwt", data);
         sendMsgToSocket(sock, msg);
     }
 
+    // 将按主体撤回发送到 proxy_node
+    void revokeSubject(const std::string &iss, const std::string &sub, const std::string &beforeStr) {
+        std::map<std::string, std::string> data;
+        data["iss"] = iss;
+        data["sub"] = sub;
+        data["revoked_before"] = beforeStr;
+        sendMsgToSocket(sock, msgAssembly("revoke_subject", data));
+    }
+
     void disconnect() {
         if (sock.is_open()) sock.close();
     }
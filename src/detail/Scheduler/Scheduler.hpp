@@ -1,26 +1,51 @@
 #ifndef SCHEDULER_HPP
 #define SCHEDULER_HPP
 
+#include <atomic>
 #include <map>
 #include <string>
+#include <vector>
 #include "../Engine/Engine.hpp"
+#include "../Engine/EngineNamespaces.hpp"
 #include "../MasterSession/MasterSession.hpp"
 #include "../Utils/JsonSerializer.hpp"
+#include "../Metrics/Metrics.hpp"
 #include "NodeMessageSender.hpp"
 
+// 节点角色（由 master 的 adjust_bloom_filter 设置）：single_node / proxy_node 持有引擎，slave_node 把查询与撤回交给 proxy_node
+enum class NodeRole { Single, Proxy, Slave };
+
+inline const char *nodeRoleName(const NodeRole role) {
+    switch (role) {
+        case NodeRole::Single: return "single_node";
+        case NodeRole::Proxy: return "proxy_node";
+        case NodeRole::Slave: return "slave_node";
+    }
+    return "unknown";
+}
+
 class Scheduler {
 public:
-    explicit Scheduler(const std::map<std::string, std::string> &config_, MasterSession &session_, Engine &engine_)
-        : config(config_), session(session_), engine(engine_) {
+    // engine_ 为默认引擎（参数由 master 下发），撤回按 iss 分派到 namespaces_ 中对应的引擎
+    Scheduler(const std::map<std::string, std::string> &config_, MasterSession &session_, Engine &engine_,
+              EngineNamespaces &namespaces_)
+        : config(config_), session(session_), engine(engine_), namespaces(namespaces_) {
         // 查询布隆过滤器默认设置
         std::map<std::string, std::string> data;
         data["client_uid"] = config.at("client_uid");
         session.asyncSendMsg(msgAssembly(std::string("get_bloom_filter_default_config"), data));
 
-        // 接收布隆过滤器默认设置
+        // 接收布隆过滤器默认设置；集群运行中启动（如热重启）时，应答之前可能先收到广播的撤回，初始化后再处理
         std::string event;
         std::map<std::string, std::string> data_;
-        msgParse(session.recvMsg(), event, data_);
+        std::vector<std::string> earlyMsgs;
+        while (true) {
+            std::string msg = session.recvMsg();
+            data_.clear();
+            msgParse(msg, event, data_);
+            if (event != "revoke_jwt" && event != "revoke_subject") break;
+            earlyMsgs.push_back(std::move(msg));
+        }
 
         // 解析布隆过滤器默认设置
         if (event == "bloom_filter_default_config") {
@@ -33,12 +58,13 @@ public:
                     rotationInterval << ", bloomFilterSize: " << bloomFilterSize << ", hashFunctionNum: " <<
                     hashFunctionNum << std::endl;
 
-            std::cout << "[Scheduler] " << "Bloom filter memory used: " << std::ceil(maxJwtLifeTime / rotationInterval)
+            std::cout << "[Scheduler] " << "Bloom filter budget (all windows dense): " << ceilDiv(maxJwtLifeTime, rotationInterval)
                     * static_cast<unsigned long>(bloomFilterSize) / 8388608 << " MBytes" << std::endl;
 
             // 初始化引擎
             engine.init(maxJwtLifeTime, rotationInterval, bloomFilterSize, hashFunctionNum);
         } else throw std::runtime_error("Get bloom filter default config failed.");
+        for (const auto &msg: earlyMsgs) procMsg(msg);
 
         // 启动处理消息线程
         if (!msgProcThread.joinable()) {
@@ -64,7 +90,10 @@ public:
     ~Scheduler() {
         // 停止处理消息线程
         msgProcThreadRunFlag.store(false);
-        if (msgProcThread.joinable()) msgProcThread.join();
+        if (msgProcThread.joinable()) {
+            session.wakeReceiver();
+            msgProcThread.join();
+        }
 
         // 停止发送心跳包线程
         keepaliveThreadRunFlag.store(false);
@@ -75,121 +104,160 @@ public:
         if (bloomFilterStatusReportThread.joinable()) bloomFilterStatusReportThread.join();
     }
 
-    // 代理查询
-    bool proxyQuery(const std::string &token, const time_t &expTime) {
-        return nodeMessageSender.isRevoked(token, std::to_string(expTime));
+    // 代理查询（subject 为查询携带的 iss / sub / iat，原样转发）
+    bool proxyQuery(const std::string &token, const time_t &expTime,
+                    const std::map<std::string, std::string> &subject = {}) {
+        static LatencyHistogram &proxyRtt = MetricsRegistry::instance().histogram(
+            "revoker_proxy_rtt_seconds", "Round-trip time of proxy queries to proxy_node");
+        ScopedTimer timer(proxyRtt);
+        return nodeMessageSender.isRevoked(token, std::to_string(expTime), subject);
     }
 
-    std::string getNodeRole() {
-        return nodeRole;
+    // 消息处理线程写入，服务端、UDP 与 RESP 的线程并发读取
+    NodeRole getNodeRole() const {
+        return nodeRole.load(std::memory_order_acquire);
     }
 
 private:
     const std::map<std::string, std::string> &config;
     MasterSession &session;
     Engine &engine;
+    EngineNamespaces &namespaces;
     NodeMessageSender nodeMessageSender = NodeMessageSender();
-    std::string nodeRole = "single_node";
+    std::atomic<NodeRole> nodeRole{NodeRole::Single};
 
     // 处理消息线程
     std::atomic<bool> msgProcThreadRunFlag{false};
     std::thread msgProcThread;
 
     void msgProcWorker() {
+        std::vector<std::string> msgs;
         while (msgProcThreadRunFlag) {
-            std::string msg = session.recvMsg();
-            std::string event;
-            std::map<std::string, std::string> data;
-            msgParse(msg, event, data);
-
-            if (event == "revoke_jwt") {
-                const std::string token = data["token"];
-                const std::string expTime = data["exp_time"];
-
-                if (nodeRole == "single_node" || nodeRole == "proxy_node") {
-                    // 如果 `node_role` 是 `single_node` 或 `proxy_node`，则在自己的布隆过滤器中撤回
-                    engine.revokeJwt(token, stringToTimestamp(expTime));
-                } else if (nodeRole == "slave_node") {
-                    // 如果是 `slave_node`，则将jwt发送给 proxy_node 撤回
-                    nodeMessageSender.revokeJwt(token, expTime);
-                }
-                engine.logRevoke(token, stringToTimestamp(expTime)); // 不管是什么模式，都要写日志
-                std::cout << "[revoke_jwt][" << nodeRole << "] " << token << std::endl;
-                continue;
+            // 批量取出消息，一次唤醒处理多条
+            msgs.clear();
+            session.recvMsgBulk(msgs, QUEUE_DEFAULT_MAXSIZE);
+            for (const auto &msg: msgs) {
+                if (!msg.empty()) procMsg(msg); // 空消息用于唤醒
+            }
+        }
+    }
+
+    void procMsg(const std::string &msg) {
+        std::string event;
+        std::map<std::string, std::string> data;
+        msgParse(msg, event, data);
+
+        // 撤回 token（可选的 iss 决定所属的命名空间）
+        if (event == "revoke_jwt") {
+            const std::string token = data["token"];
+            const std::string expTime = data["exp_time"];
+            const std::string iss = data["iss"];
+
+            if (const NodeRole role = nodeRole.load(); role == NodeRole::Single || role == NodeRole::Proxy) {
+                // 如果 `node_role` 是 `single_node` 或 `proxy_node`，则在自己的布隆过滤器中撤回
+                namespaces.revokeJwt(iss, token, stringToTimestamp(expTime));
+            } else if (role == NodeRole::Slave) {
+                // 如果是 `slave_node`，则将jwt发送给 proxy_node 撤回
+                nodeMessageSender.revokeJwt(token, expTime, iss);
+            }
+            namespaces.logRevoke(iss, token, stringToTimestamp(expTime)); // 不管是什么模式，都要写日志
+            std::cout << "[revoke_jwt][" << nodeRoleName(nodeRole) << "] " << token << std::endl;
+            return;
+        }
+
+        // 按主体批量撤回：撤回 iss / sub 在 revoked_before 之前签发的全部 token（iss 可省略）
+        if (event == "revoke_subject") {
+            const std::string iss = data["iss"];
+            const std::string sub = data["sub"];
+            const std::string before = data["revoked_before"];
+            if (!isValidSubject(iss, sub)) {
+                std::cerr << "[revoke_subject][" << nodeRoleName(nodeRole) << "] Invalid subject: " << sub << std::endl;
+                return;
+            }
+
+            if (const NodeRole role = nodeRole.load(); role == NodeRole::Single || role == NodeRole::Proxy) {
+                namespaces.revokeSubject(iss, sub, stringToTimestamp(before));
+            } else if (role == NodeRole::Slave) {
+                nodeMessageSender.revokeSubject(iss, sub, before);
+            }
+            namespaces.logRevokeSubject(iss, sub, stringToTimestamp(before));
+            std::cout << "[revoke_subject][" << nodeRoleName(nodeRole) << "] " << iss << " " << sub << " before " << before <<
+                    std::endl;
+            return;
+        }
+
+        // 调整参数，更改服务器角色，并重建布隆过滤器
+        if (event == "adjust_bloom_filter") {
+            const std::string node_role = data.at("node_role");
+
+            // single_node 逻辑
+            if (node_role == "single_node") {
+                nodeRole = NodeRole::Single;
+                nodeMessageSender.disconnect();
+                const unsigned int maxJwtLifeTime = stringToUInt(data.at("max_jwt_life_time"));
+                const unsigned int rotationInterval = stringToUInt(data.at("rotation_interval"));
+                const size_t bloomFilterSize = stringToSizeT(data.at("bloom_filter_size"));
+                const unsigned int hashFunctionNum = stringToUInt(data.at("hash_function_num"));
+                // 调整
+                engine.adjustFiltersParam(maxJwtLifeTime, rotationInterval, bloomFilterSize, hashFunctionNum);
+                // 回执
+                std::map<std::string, std::string> data_;
+                data_["node_uid"] = config.at("client_uid");
+                data_["uuid"] = data.at("uuid");
+                data_["node_role"] = node_role;
+                session.asyncSendMsg(msgAssembly("adjust_bloom_filter_done", data_));
+                // 打印
+                std::cout << "[Scheduler] " << "nodeMode: " << nodeRoleName(nodeRole) << " maxJwtLifeTime: " << maxJwtLifeTime <<
+                        ", rotationInterval: " << rotationInterval << ", bloomFilterSize: " << bloomFilterSize <<
+                        ", hashFunctionNum: " << hashFunctionNum << std::endl;
+                return;
+            }
+
+            // proxy_node 逻辑
+            if (node_role == "proxy_node") {
+                nodeRole = NodeRole::Proxy;
+                nodeMessageSender.disconnect();
+                const unsigned int maxJwtLifeTime = stringToUInt(data.at("max_jwt_life_time"));
+                const unsigned int rotationInterval = stringToUInt(data.at("rotation_interval"));
+                const size_t bloomFilterSize = stringToSizeT(data.at("bloom_filter_size"));
+                const unsigned int hashFunctionNum = stringToUInt(data.at("hash_function_num"));
+                // 调整
+                engine.adjustFiltersParam(maxJwtLifeTime, rotationInterval, bloomFilterSize, hashFunctionNum);
+                // 回执
+                std::map<std::string, std::string> data_;
+                data_["node_uid"] = config.at("client_uid");
+                data_["uuid"] = data.at("uuid");
+                data_["node_role"] = node_role;
+                session.asyncSendMsg(msgAssembly("adjust_bloom_filter_done", data_));
+                // 打印
+                std::cout << "[Scheduler] " << "nodeMode: " << nodeRoleName(nodeRole) << " maxJwtLifeTime: " << maxJwtLifeTime <<
+                        ", rotationInterval: " << rotationInterval << ", bloomFilterSize: " << bloomFilterSize <<
+                        ", hashFunctionNum: " << hashFunctionNum << std::endl;
+                return;
             }
 
-            // 调整参数，更改服务器角色，并重建布隆过滤器
-            if (event == "adjust_bloom_filter") {
-                const std::string node_role = data.at("node_role");
-
-                // single_node 逻辑
-                if (node_role == "single_node") {
-                    nodeRole = node_role;
-                    nodeMessageSender.disconnect();
-                    const unsigned int maxJwtLifeTime = stringToUInt(data.at("max_jwt_life_time"));
-                    const unsigned int rotationInterval = stringToUInt(data.at("rotation_interval"));
-                    const size_t bloomFilterSize = stringToSizeT(data.at("bloom_filter_size"));
-                    const unsigned int hashFunctionNum = stringToUInt(data.at("hash_function_num"));
-                    // 调整
-                    engine.adjustFiltersParam(maxJwtLifeTime, rotationInterval, bloomFilterSize, hashFunctionNum);
-                    // 回执
-                    std::map<std::string, std::string> data_;
-                    data_["node_uid"] = config.at("client_uid");
-                    data_["uuid"] = data.at("uuid");
-                    data_["node_role"] = node_role;
-                    session.asyncSendMsg(msgAssembly("adjust_bloom_filter_done", data_));
-                    // 打印
-                    std::cout << "[Scheduler] " << "nodeMode: " << nodeRole << " maxJwtLifeTime: " << maxJwtLifeTime <<
-                            ", rotationInterval: " << rotationInterval << ", bloomFilterSize: " << bloomFilterSize <<
-                            ", hashFunctionNum: " << hashFunctionNum << std::endl;
-                    continue;
-                }
-
-                // proxy_node 逻辑
-                if (node_role == "proxy_node") {
-                    nodeRole = node_role;
-                    nodeMessageSender.disconnect();
-                    const unsigned int maxJwtLifeTime = stringToUInt(data.at("max_jwt_life_time"));
-                    const unsigned int rotationInterval = stringToUInt(data.at("rotation_interval"));
-                    const size_t bloomFilterSize = stringToSizeT(data.at("bloom_filter_size"));
-                    const unsigned int hashFunctionNum = stringToUInt(data.at("hash_function_num"));
-                    // 调整
-                    engine.adjustFiltersParam(maxJwtLifeTime, rotationInterval, bloomFilterSize, hashFunctionNum);
-                    // 回执
-                    std::map<std::string, std::string> data_;
-                    data_["node_uid"] = config.at("client_uid");
-                    data_["uuid"] = data.at("uuid");
-                    data_["node_role"] = node_role;
-                    session.asyncSendMsg(msgAssembly("adjust_bloom_filter_done", data_));
-                    // 打印
-                    std::cout << "[Scheduler] " << "nodeMode: " << nodeRole << " maxJwtLifeTime: " << maxJwtLifeTime <<
-                            ", rotationInterval: " << rotationInterval << ", bloomFilterSize: " << bloomFilterSize <<
-                            ", hashFunctionNum: " << hashFunctionNum << std::endl;
-                    continue;
-                }
-
-                // single_node 逻辑
-                if (node_role == "slave_node") {
-                    nodeRole = node_role;
-                    nodeMessageSender.disconnect();
-                    // 启动TCP客户端，将 log 发送给 proxy_node
-                    const std::string proxy_node_host = data.at("proxy_node_host");
-                    const std::string proxy_node_port = data.at("proxy_node_port");
-                    nodeMessageSender.connect(proxy_node_host, stringToUShort(proxy_node_port));
-                    nodeMessageSender.sendLogToProxyNode(config.at("log_file_path"));
-                    // 调整
-                    engine.adjustFiltersParam(86400, 86400, 8, 1);
-                    // 回执
-                    std::map<std::string, std::string> data_;
-                    data_["node_uid"] = config.at("client_uid");
-                    data_["uuid"] = data.at("uuid");
-                    data_["node_role"] = node_role;
-                    session.asyncSendMsg(msgAssembly("adjust_bloom_filter_done", data_));
-                    // 打印
-                    std::cout << "[Scheduler] " << "nodeMode: " << nodeRole << std::endl;
-                }
-                continue;
+            // single_node 逻辑
+            if (node_role == "slave_node") {
+                nodeRole = NodeRole::Slave;
+                nodeMessageSender.disconnect();
+                // 启动TCP客户端，将 log 发送给 proxy_node
+                const std::string proxy_node_host = data.at("proxy_node_host");
+                const std::string proxy_node_port = data.at("proxy_node_port");
+                nodeMessageSender.connect(proxy_node_host, stringToUShort(proxy_node_port));
+                nodeMessageSender.sendLogToProxyNode(config.at("log_file_path"));
+                for (const auto &[logDir, iss]: namespaces.getLogDirs()) nodeMessageSender.sendLogToProxyNode(logDir, iss);
+                // 调整
+                engine.adjustFiltersParam(86400, 86400, 8, 1);
+                // 回执
+                std::map<std::string, std::string> data_;
+                data_["node_uid"] = config.at("client_uid");
+                data_["uuid"] = data.at("uuid");
+                data_["node_role"] = node_role;
+                session.asyncSendMsg(msgAssembly("adjust_bloom_filter_done", data_));
+                // 打印
+                std::cout << "[Scheduler] " << "nodeMode: " << nodeRoleName(nodeRole) << std::endl;
             }
+            return;
         }
     }
 
@@ -224,6 +292,11 @@ private:
             data["bloom_filter_size"] = std::to_string(engine.getBloomFilterSize()); // m^bf_i
             data["hash_function_num"] = std::to_string(engine.getHashFunctionNum()); // k^hash_i
             data["bloom_filter_filling_rate"] = vectorToString(engine.getBloomFilterFillingRate()); // n^jwt_(i-1,j)
+            data["bloom_filter_set_bits"] = vectorToString(engine.getBloomFilterSetBitNum()); // X_j
+            data["bloom_filter_fill_ratio"] = vectorToString(engine.getBloomFilterFillRatio()); // X_j / m^bf_i
+            data["bloom_filter_estimated_fpr"] = vectorToString(engine.getBloomFilterEstimatedFpr()); // (X_j / m^bf_i)^k
+            data["bloom_filter_estimated_items"] = vectorToString(engine.getBloomFilterEstimatedItemNum()); // n̂_j
+            data["bloom_filter_stages"] = vectorToString(engine.getBloomFilterStageNum()); // 每个窗口的子过滤器个数
             const std::string msg = msgAssembly(event, data);
             session.asyncSendMsg(msg);
         }
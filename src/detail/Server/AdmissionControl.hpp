@@ -0,0 +1,104 @@
+#ifndef ADMISSION_CONTROL_HPP
+#define ADMISSION_CONTROL_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "../Utils/ConfigReader.hpp"
+#include "../Metrics/Metrics.hpp"
+
+// 准入控制参数（0 表示不限制）
+struct AdmissionOptions {
+    size_t maxConnections = 0; // 同时打开的客户端连接数，超出的新连接立即关闭
+    size_t maxInflightPerConnection = 0; // 每个连接排队中的请求数，达到后暂停读取该连接（TCP 反压）
+    size_t maxInflight = 0; // 所有连接排队与处理中的请求总数，超出后新的查询直接回复 retry
+    std::chrono::milliseconds requestDeadline{0}; // 查询在队列中等待超过该时长后直接回复 retry
+};
+
+// 从配置中读取：server_max_connections、server_max_inflight_per_connection、server_max_inflight、server_request_deadline_ms
+inline AdmissionOptions parseAdmissionOptions(const std::map<std::string, std::string> &config) {
+    AdmissionOptions options;
+    options.maxConnections = std::stoul(getConfigOrDefault(config, "server_max_connections", "0"));
+    options.maxInflightPerConnection = std::stoul(getConfigOrDefault(config, "server_max_inflight_per_connection", "0"));
+    options.maxInflight = std::stoul(getConfigOrDefault(config, "server_max_inflight", "0"));
+    options.requestDeadline = std::chrono::milliseconds(std::stoul(getConfigOrDefault(config, "server_request_deadline_ms", "0")));
+    return options;
+}
+
+// 全局的连接数与在途请求数。过载时只丢弃查询（客户端收到 retry 后可重试或回退），撤回请求总是接受
+class AdmissionControl {
+public:
+    explicit AdmissionControl(const AdmissionOptions &_options) : options(_options) {}
+
+    const AdmissionOptions &getOptions() const { return options; }
+
+    bool enabled() const {
+        return options.maxConnections > 0 || options.maxInflightPerConnection > 0 || options.maxInflight > 0 ||
+               options.requestDeadline.count() > 0;
+    }
+
+    bool tryAcceptConnection() {
+        if (options.maxConnections > 0 && connections.load(std::memory_order_relaxed) >= options.maxConnections) {
+            static Counter &rejected = MetricsRegistry::instance().counter(
+                "revoker_server_rejected_connections_total", "Connections closed because server_max_connections was reached");
+            rejected.inc();
+            return false;
+        }
+        connections.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void releaseConnection() { connections.fetch_sub(1, std::memory_order_relaxed); }
+
+    size_t getConnections() const { return connections.load(std::memory_order_relaxed); }
+
+    // 在全局预算内时计入一个在途请求并返回 true
+    bool tryAdmitRequest() {
+        if (options.maxInflight > 0 && inflight.load(std::memory_order_relaxed) >= options.maxInflight) return false;
+        admitRequest();
+        return true;
+    }
+
+    // 不受预算限制地计入（撤回请求）
+    void admitRequest() {
+        inflight.fetch_add(1, std::memory_order_relaxed);
+        inflightGauge().add(1);
+    }
+
+    void releaseRequests(const size_t num = 1) {
+        inflight.fetch_sub(num, std::memory_order_relaxed);
+        inflightGauge().add(-static_cast<int64_t>(num));
+    }
+
+    // 查询已过期：在队列中等待超过 requestDeadline，或超过客户端给出的截止时刻 deadlineMs（Unix 毫秒，0 表示未给出）
+    bool isExpired(const std::chrono::steady_clock::time_point receivedAt, const int64_t deadlineMs) const {
+        if (options.requestDeadline.count() > 0 && std::chrono::steady_clock::now() - receivedAt > options.requestDeadline) {
+            return true;
+        }
+        return deadlineMs > 0 && std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::system_clock::now().time_since_epoch()).count() > deadlineMs;
+    }
+
+private:
+    AdmissionOptions options;
+    std::atomic<size_t> connections{0};
+    std::atomic<size_t> inflight{0};
+
+    static Gauge &inflightGauge() {
+        static Gauge &gauge = MetricsRegistry::instance().gauge("revoker_server_inflight_requests",
+                                                                "Requests queued or being processed across all connections");
+        return gauge;
+    }
+};
+
+// 连接协程退出（含异常）时归还连接数（TCP 与 RESP 连接共用）
+struct ConnectionGuard {
+    AdmissionControl &admission;
+
+    ~ConnectionGuard() { admission.releaseConnection(); }
+};
+
+#endif //ADMISSION_CONTROL_HPP
@@ -13,39 +13,82 @@ public:
     explicit CoroutineSafeQueue(boost::asio::io_context &ioc) : ioc_(ioc) {
     }
 
-    // 将消息放入队列中
+    // 将消息放入队列中（可在任意线程调用）
     void enqueue(T value) {
         std::lock_guard lock(mtx_);
         queue_.push_back(std::move(value));
         if (!waiters_.empty()) {
-            waiters_.front()->cancel(); // 唤醒等待的协程
+            // 唤醒等待的协程：取消操作投递到 io_context 中执行，避免跨线程直接操作定时器
+            auto timer = std::move(waiters_.front());
             waiters_.pop_front();
+            boost::asio::post(ioc_, [timer] { timer->cancel(); });
         }
     }
 
+    // 关闭队列：唤醒所有等待的协程，之后 dequeue 抛出 operation_aborted
+    void close() {
+        std::lock_guard lock(mtx_);
+        closed_ = true;
+        for (auto &timer: waiters_) boost::asio::post(ioc_, [timer] { timer->cancel(); });
+        waiters_.clear();
+        wakeSpaceWaiters();
+    }
+
     // 从队列中取出消息
     boost::asio::awaitable<T> dequeue() {
         for (;;) {
             std::unique_lock lock(mtx_);
+            if (closed_) throw boost::system::system_error(boost::asio::error::operation_aborted);
             if (!queue_.empty()) {
                 T value = std::move(queue_.front());
                 queue_.pop_front();
+                wakeSpaceWaiters();
                 co_return value;
             }
 
-            // 如果队列为空，设置一个定时器等待数据到来
-            auto timer = std::make_unique<boost::asio::steady_timer>(ioc_);
-            waiters_.push_back(std::move(timer));
+            // 如果队列为空，挂起一个永不超时的定时器，等待 enqueue 将其取消
+            auto timer = std::make_shared<boost::asio::steady_timer>(ioc_, boost::asio::steady_timer::time_point::max());
+            waiters_.push_back(timer);
             lock.unlock();
-            co_await waiters_.back()->async_wait(boost::asio::use_awaitable);
+            boost::system::error_code ec;
+            co_await timer->async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
         }
     }
 
+    // 等待队列长度降到 limit 以下（dequeue 取出消息时唤醒），用于暂停生产者实现反压；队列关闭后抛出 operation_aborted
+    boost::asio::awaitable<void> waitForSpace(const size_t limit) {
+        for (;;) {
+            std::unique_lock lock(mtx_);
+            if (closed_) throw boost::system::system_error(boost::asio::error::operation_aborted);
+            if (queue_.size() < limit) co_return;
+
+            auto timer = std::make_shared<boost::asio::steady_timer>(ioc_, boost::asio::steady_timer::time_point::max());
+            spaceWaiters_.push_back(timer);
+            lock.unlock();
+            boost::system::error_code ec;
+            co_await timer->async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+        }
+    }
+
+    // 获取队列的大小
+    size_t size() const {
+        std::lock_guard lock(mtx_);
+        return queue_.size();
+    }
+
 private:
-    std::mutex mtx_;
+    mutable std::mutex mtx_;
     std::deque<T> queue_;
-    std::deque<std::unique_ptr<boost::asio::steady_timer> > waiters_; // 使用智能指针来管理定时器
+    bool closed_ = false;
+    std::deque<std::shared_ptr<boost::asio::steady_timer> > waiters_; // 等待中的协程（定时器由协程与投递的取消操作共同持有）
+    std::deque<std::shared_ptr<boost::asio::steady_timer> > spaceWaiters_; // 等待队列腾出空间的协程
     boost::asio::io_context &ioc_;
+
+    // 调用方需持有 mtx_
+    void wakeSpaceWaiters() {
+        for (auto &timer: spaceWaiters_) boost::asio::post(ioc_, [timer] { timer->cancel(); });
+        spaceWaiters_.clear();
+    }
 };
 
 #endif //COROUTINE_SAFE_QUEUE_HPP
@@ -0,0 +1,341 @@
+#ifndef RESP_SERVER_HPP
+#define RESP_SERVER_HPP
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <boost/asio.hpp>
+
+#include "AdmissionControl.hpp"
+#include "../Engine/EngineNamespaces.hpp"
+#include "../Scheduler/Scheduler.hpp"
+#include "../Utils/ConfigReader.hpp"
+#include "../Utils/StringParser.hpp"
+#include "../Metrics/Metrics.hpp"
+
+using boost::asio::io_context;
+using boost::asio::awaitable;
+using boost::asio::use_awaitable;
+using boost::asio::ip::tcp;
+
+// RESP 请求的上限：超出时按协议错误断开连接
+inline constexpr size_t RESP_MAX_ARGS = 1 << 16;
+inline constexpr size_t RESP_MAX_BULK_BYTES = 1 << 20;
+inline constexpr size_t RESP_MAX_REQUEST_BYTES = 64 << 20;
+
+// 从 in 的开头解析一条命令，参数以 string_view 指向 in（不复制）。
+// 返回消耗的字节数，数据不完整时返回 0；格式错误时抛出 std::invalid_argument。
+// 支持 RESP 数组（*<n>\r\n$<len>\r\n<bytes>\r\n...，客户端库与 redis-benchmark 使用）与以空白分隔的内联命令（telnet）
+inline size_t parseRespCommand(const std::string_view in, std::vector<std::string_view> &args) {
+    args.clear();
+    const auto readLine = [&in](const size_t pos, std::string_view &line) -> size_t {
+        const size_t crlf = in.find("\r\n", pos);
+        if (crlf == std::string_view::npos) return 0;
+        line = in.substr(pos, crlf - pos);
+        return crlf + 2;
+    };
+    const auto readLength = [](const std::string_view digits, const size_t limit) {
+        size_t length = 0;
+        if (digits.empty() || std::from_chars(digits.data(), digits.data() + digits.size(), length).ptr !=
+            digits.data() + digits.size() || length > limit) {
+            throw std::invalid_argument("invalid length");
+        }
+        return length;
+    };
+
+    if (in.empty()) return 0;
+    std::string_view line;
+    if (in.front() != '*') {
+        const size_t next = readLine(0, line);
+        if (next == 0) {
+            if (in.size() > RESP_MAX_BULK_BYTES) throw std::invalid_argument("inline command too long");
+            return 0;
+        }
+        for (size_t pos = 0; pos < line.size();) {
+            const size_t start = line.find_first_not_of(" \t", pos);
+            if (start == std::string_view::npos) break;
+            const size_t stop = std::min(line.find_first_of(" \t", start), line.size());
+            args.push_back(line.substr(start, stop - start));
+            pos = stop;
+        }
+        return next;
+    }
+
+    size_t pos = readLine(0, line);
+    if (pos == 0) return 0;
+    const size_t argNum = readLength(line.substr(1), RESP_MAX_ARGS);
+    args.reserve(argNum);
+    for (size_t i = 0; i < argNum; ++i) {
+        const size_t next = readLine(pos, line);
+        if (next == 0) return 0;
+        if (line.empty() || line.front() != '$') throw std::invalid_argument("expected '$'");
+        const size_t length = readLength(line.substr(1), RESP_MAX_BULK_BYTES);
+        if (in.size() < next + length + 2) return 0;
+        if (in.compare(next + length, 2, "\r\n") != 0) throw std::invalid_argument("bulk string is not terminated");
+        args.push_back(in.substr(next, length));
+        pos = next + length + 2;
+    }
+    return pos;
+}
+
+// 兼容 Redis 协议（RESP2）的查询端口，标准客户端与 redis-benchmark 可直接使用，支持流水线：
+//   ISREVOKED <token> <exp> [iss]                     :1 已撤回 / :0 未撤回
+//   MISREVOKED [ISS <iss>] <token> <exp> [<token> <exp> ...]
+//                                                     整数数组，依次对应每个 token（均按 iss 所在的命名空间查询）
+//   REVOKE <token> <exp> [iss]                        +OK（只在本节点撤回并写入撤回日志，不经过 master 广播）
+//   PING [message]、QUIT；COMMAND 与 CONFIG 回复空数组（客户端启动时的探测）
+// 与 Server 共用一个 io 线程：每次读取后解析缓冲区中所有完整的命令，应答合并为一次写出。
+// 连接数计入 Server 的准入控制（server_max_connections）与热重启排空，排空开始时 Server 调用 stopAccepting()。
+// slave_node 的查询与 TCP 端口相同，经代理连接询问 proxy_node；REVOKE 只在 single_node / proxy_node 上接受
+class RespServer {
+public:
+    RespServer(const std::map<std::string, std::string> &config, Scheduler &_scheduler, EngineNamespaces &_namespaces,
+               AdmissionControl &_admission, io_context &_ioc)
+        : scheduler(_scheduler), namespaces(_namespaces), admission(_admission), ioc(_ioc), acceptor(_ioc) {
+        const unsigned short port = stringToUShort(getConfigOrDefault(config, "resp_port", "0"));
+        if (port == 0) return; // 未配置端口，不启用
+
+        const std::string ip = getConfigOrDefault(config, "resp_ip", "0.0.0.0");
+        acceptor.open(tcp::v4());
+        acceptor.set_option(tcp::acceptor::reuse_address(true));
+#if defined(SO_REUSEPORT)
+        // 热重启期间新旧进程同时监听
+        if (!getConfigOrDefault(config, "hot_restart_socket", "").empty()) {
+            acceptor.set_option(boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>(true));
+        }
+#endif
+        acceptor.bind(tcp::endpoint(boost::asio::ip::make_address(ip), port));
+        acceptor.listen();
+        std::cout << "[RESP] RESP endpoint is running at: " << acceptor.local_endpoint() << std::endl;
+        co_spawn(ioc, listener(), boost::asio::detached);
+    }
+
+    RespServer(const RespServer &) = delete;
+
+    RespServer &operator=(const RespServer &) = delete;
+
+    // 热重启排空：关闭监听，已有连接继续服务直到断开
+    void stopAccepting() {
+        boost::system::error_code ec;
+        acceptor.close(ec);
+    }
+
+private:
+    static constexpr size_t READ_BUFFER_BYTES = 16384;
+
+    Scheduler &scheduler;
+    EngineNamespaces &namespaces;
+    AdmissionControl &admission;
+    io_context &ioc;
+    tcp::acceptor acceptor;
+
+    // 引擎接口接收 std::string：参数复制到这几个复用的缓冲区中，稳定后不再分配内存
+    struct Scratch {
+        std::string token;
+        std::string iss;
+    };
+
+    awaitable<void> listener() {
+        while (true) {
+            boost::system::error_code ec;
+            tcp::socket sock = co_await acceptor.async_accept(boost::asio::redirect_error(use_awaitable, ec));
+            if (ec == boost::asio::error::operation_aborted || !acceptor.is_open()) co_return;
+            if (ec) continue;
+            // 连接数已满：立即关闭，与 TCP 端口相同
+            if (!admission.tryAcceptConnection()) {
+                sock.close(ec);
+                continue;
+            }
+            // 每批应答只写一次，不需要 Nagle 合并（否则与客户端的延迟确认叠加，流水线上每批多等几十毫秒）
+            sock.set_option(tcp::no_delay(true), ec);
+            co_spawn(ioc, handleClient(std::move(sock)), boost::asio::detached);
+        }
+    }
+
+    awaitable<void> handleClient(tcp::socket sock) {
+        ConnectionGuard connectionGuard{admission};
+        static Gauge &connections = MetricsRegistry::instance().gauge("revoker_resp_connections",
+                                                                      "Open RESP client connections");
+        static Counter &commandCount = MetricsRegistry::instance().counter("revoker_resp_commands_total",
+                                                                           "Commands processed on the RESP endpoint");
+        connections.add(1);
+        std::vector<char> buffer(READ_BUFFER_BYTES);
+        size_t begin = 0, end = 0; // buffer[begin, end) 为尚未解析的数据
+        std::vector<std::string_view> args;
+        std::string out;
+        Scratch scratch;
+        try {
+            bool quit = false;
+            while (!quit) {
+                // 缓冲区尾部已满：先把未解析的部分移到开头，仍然放不下（单条命令很大）时扩容
+                if (end == buffer.size()) {
+                    if (begin > 0) {
+                        std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+                        end -= begin;
+                        begin = 0;
+                    } else if (buffer.size() < RESP_MAX_REQUEST_BYTES) {
+                        buffer.resize(buffer.size() * 2);
+                    } else {
+                        co_await boost::asio::async_write(sock, boost::asio::buffer(
+                                                              std::string_view("-ERR Protocol error: request too large\r\n")),
+                                                          use_awaitable);
+                        break;
+                    }
+                }
+                end += co_await sock.async_read_some(boost::asio::buffer(buffer.data() + end, buffer.size() - end),
+                                                     use_awaitable);
+
+                size_t commands = 0;
+                while (!quit && begin < end) {
+                    size_t consumed = 0;
+                    try {
+                        consumed = parseRespCommand(std::string_view(buffer.data() + begin, end - begin), args);
+                    } catch (const std::invalid_argument &e) {
+                        out += "-ERR Protocol error: ";
+                        out += e.what();
+                        out += "\r\n";
+                        quit = true;
+                        break;
+                    }
+                    if (consumed == 0) break;
+                    begin += consumed;
+                    if (args.empty()) continue;
+                    quit = execute(args, scratch, out);
+                    ++commands;
+                }
+                if (begin == end) begin = end = 0;
+                commandCount.inc(commands);
+                if (!out.empty()) {
+                    co_await boost::asio::async_write(sock, boost::asio::buffer(out), use_awaitable);
+                    out.clear();
+                }
+            }
+        } catch (const boost::system::system_error &) {
+            // 客户端断开
+        }
+        boost::system::error_code ec;
+        sock.shutdown(tcp::socket::shutdown_both, ec);
+        connections.add(-1);
+    }
+
+    static bool equalsIgnoreCase(const std::string_view a, const std::string_view b) {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](const char x, const char y) {
+            return std::toupper(static_cast<unsigned char>(x)) == y;
+        });
+    }
+
+    static bool parseTime(const std::string_view value, time_t &time) {
+        long long parsed = 0;
+        const auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), parsed);
+        if (ec != std::errc() || ptr != value.data() + value.size()) return false;
+        time = static_cast<time_t>(parsed);
+        return true;
+    }
+
+    bool isRevoked(const std::string &iss, const std::string &token, const time_t expTime) const {
+        if (const NodeRole role = scheduler.getNodeRole(); role == NodeRole::Single || role == NodeRole::Proxy) {
+            return namespaces.isRevoked(iss, token, expTime);
+        }
+        std::map<std::string, std::string> subject;
+        if (!iss.empty()) subject["iss"] = iss;
+        return scheduler.proxyQuery(token, expTime, subject);
+    }
+
+    // 执行一条命令，应答追加到 out；返回 true 表示随后关闭连接（QUIT）
+    bool execute(const std::vector<std::string_view> &args, Scratch &scratch, std::string &out) const {
+        const std::string_view command = args.front();
+        time_t expTime = 0;
+
+        if (equalsIgnoreCase(command, "ISREVOKED")) {
+            if (args.size() != 3 && args.size() != 4) return error(out, "wrong number of arguments for 'isrevoked' command");
+            if (!parseTime(args[2], expTime)) return error(out, "value is not an integer or out of range");
+            scratch.token.assign(args[1]);
+            scratch.iss.assign(args.size() == 4 ? args[3] : std::string_view());
+            out += isRevoked(scratch.iss, scratch.token, expTime) ? ":1\r\n" : ":0\r\n";
+            return false;
+        }
+
+        if (equalsIgnoreCase(command, "MISREVOKED")) {
+            // 可选的 ISS <iss> 选项（JWT 不会是 "ISS"，与 token 不会混淆）
+            size_t first = 1;
+            scratch.iss.clear();
+            if (args.size() > 2 && equalsIgnoreCase(args[1], "ISS")) {
+                scratch.iss.assign(args[2]);
+                first = 3;
+            }
+            if (args.size() < first + 2 || (args.size() - first) % 2 != 0) {
+                return error(out, "wrong number of arguments for 'misrevoked' command");
+            }
+            for (size_t i = first + 1; i < args.size(); i += 2) {
+                if (!parseTime(args[i], expTime)) return error(out, "value is not an integer or out of range");
+            }
+            out += '*';
+            out += std::to_string((args.size() - first) / 2);
+            out += "\r\n";
+            for (size_t i = first; i < args.size(); i += 2) {
+                parseTime(args[i + 1], expTime);
+                scratch.token.assign(args[i]);
+                out += isRevoked(scratch.iss, scratch.token, expTime) ? ":1\r\n" : ":0\r\n";
+            }
+            return false;
+        }
+
+        if (equalsIgnoreCase(command, "REVOKE")) {
+            if (args.size() != 3 && args.size() != 4) return error(out, "wrong number of arguments for 'revoke' command");
+            if (!parseTime(args[2], expTime)) return error(out, "value is not an integer or out of range");
+            if (const NodeRole role = scheduler.getNodeRole(); role != NodeRole::Single && role != NodeRole::Proxy) {
+                return error(out, "REVOKE is only accepted on single_node or proxy_node");
+            }
+            scratch.token.assign(args[1]);
+            scratch.iss.assign(args.size() == 4 ? args[3] : std::string_view());
+            namespaces.revokeJwt(scratch.iss, scratch.token, expTime);
+            namespaces.logRevoke(scratch.iss, scratch.token, expTime);
+            out += "+OK\r\n";
+            return false;
+        }
+
+        if (equalsIgnoreCase(command, "PING")) {
+            if (args.size() == 1) {
+                out += "+PONG\r\n";
+            } else {
+                out += '$';
+                out += std::to_string(args[1].size());
+                out += "\r\n";
+                out += args[1];
+                out += "\r\n";
+            }
+            return false;
+        }
+
+        if (equalsIgnoreCase(command, "QUIT")) {
+            out += "+OK\r\n";
+            return true;
+        }
+
+        if (equalsIgnoreCase(command, "COMMAND") || equalsIgnoreCase(command, "CONFIG")) {
+            out += "*0\r\n";
+            return false;
+        }
+
+        out += "-ERR unknown command '";
+        out.append(command.substr(0, 64));
+        out += "'\r\n";
+        return false;
+    }
+
+    static bool error(std::string &out, const char *message) {
+        out += "-ERR ";
+        out += message;
+        out += "\r\n";
+        return false;
+    }
+};
+
+#endif //RESP_SERVER_HPP
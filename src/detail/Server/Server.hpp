@@ -4,11 +4,17 @@
 #include <map>
 #include <boost/asio.hpp>
 #include "../Engine/Engine.hpp"
+#include "../Engine/EngineNamespaces.hpp"
 #include "../Scheduler/Scheduler.hpp"
+#include "AdmissionControl.hpp"
+#include "RespServer.hpp"
 #include "CoroutineSafeQueue.hpp"
 #include "../Utils/JsonSerializer.hpp"
 #include "../Utils/StringParser.hpp"
 #include "../Utils/SocketMsgFrame.hpp"
+#include "../Metrics/Metrics.hpp"
+#include "../HotRestart/HotRestart.hpp"
+#include "../Tracing/RequestTracer.hpp"
 
 using boost::asio::io_context;
 using boost::asio::awaitable;
@@ -17,8 +23,19 @@ using boost::asio::ip::tcp;
 
 class Server {
 public:
-    Server(const std::map<std::string, std::string> &config_, Engine &engine_, Scheduler &scheduler_)
-        : config(config_), engine(engine_), scheduler(scheduler_) {
+    // 查询按 iss 分派到 namespaces_ 中对应的引擎；
+    // hotRestart_ 不为空时使用交接得到的监听套接字，并在收到下一次热重启请求后停止接受新连接、排空已有连接
+    Server(const std::map<std::string, std::string> &config_, Engine &engine_, Scheduler &scheduler_,
+           EngineNamespaces &namespaces_, HotRestart *hotRestart_ = nullptr)
+        : config(config_), engine(engine_), scheduler(scheduler_), namespaces(namespaces_), hotRestart(hotRestart_),
+          admission(parseAdmissionOptions(config_)) {
+        RequestTracer::instance().configure(config_);
+        if (admission.enabled()) {
+            const AdmissionOptions &options = admission.getOptions();
+            std::cout << "[Server] Admission control: max connections " << options.maxConnections <<
+                    ", max in-flight per connection " << options.maxInflightPerConnection << ", max in-flight " <<
+                    options.maxInflight << ", request deadline " << options.requestDeadline.count() << " ms" << std::endl;
+        }
     }
 
     ~Server() = default;
@@ -28,7 +45,25 @@ public:
             io_context io_context(1);
             boost::asio::signal_set signals(io_context, SIGINT, SIGTERM);
             signals.async_wait([&](auto, auto) { io_context.stop(); });
-            co_spawn(io_context, listener(io_context), boost::asio::detached);
+            tcp::acceptor acceptor = openAcceptor(io_context);
+            boost::asio::steady_timer drainTimer(io_context);
+            // Redis 协议（RESP）查询端口（未配置 resp_port 时不启用），与 TCP 端口共用本线程、准入控制与热重启排空
+            RespServer respServer(config, scheduler, namespaces, admission, io_context);
+            const ServingGuard servingGuard{hotRestart}; // 先于以上对象销毁，onHandoff 不会再被调用
+            if (hotRestart) {
+                hotRestart->serve(engine, acceptor.native_handle(), [&] {
+                    boost::asio::post(io_context, [&] { startDrain(acceptor, respServer, drainTimer, io_context); });
+                });
+            }
+#if defined(SIGUSR2)
+            // 请求追踪：收到 SIGUSR2 时把环形缓冲区导出到 trace_dump_path
+            boost::asio::signal_set traceSignals(io_context);
+            if (RequestTracer::instance().enabled()) {
+                traceSignals.add(SIGUSR2);
+                waitForTraceDump(traceSignals);
+            }
+#endif
+            co_spawn(io_context, listener(io_context, acceptor), boost::asio::detached);
             io_context.run();
         } catch (std::exception &e) {
             std::printf("Exception: %s\n", e.what());
@@ -39,90 +74,309 @@ private:
     const std::map<std::string, std::string> &config;
     Engine &engine;
     Scheduler &scheduler;
+    EngineNamespaces &namespaces;
+    HotRestart *hotRestart;
+    mutable AdmissionControl admission; // 连接数与在途请求数（计数器为原子变量）
+
+    // 未配置 server_max_inflight_per_connection 时，每个连接待发送回复的上限（客户端不读取回复时暂停读取与处理）
+    static constexpr size_t MAX_PENDING_REPLIES = 4096;
+
+    size_t replyLimit() const {
+        const size_t perConnectionLimit = admission.getOptions().maxInflightPerConnection;
+        return perConnectionLimit > 0 ? perConnectionLimit : MAX_PENDING_REPLIES;
+    }
 
-    awaitable<void> listener(io_context &ioc) const {
+    // 接收到的请求与接收时刻（用于判断在队列中等待是否超时），以及被采样时的阶段时间戳
+    struct Request {
+        std::string msg;
+        std::chrono::steady_clock::time_point receivedAt;
+        RequestTrace trace;
+    };
+
+    // 待发送的应答，被采样的请求在发送完成后提交追踪记录
+    struct Reply {
+        std::string msg;
+        RequestTrace trace;
+    };
+
+    // 处理完一个请求（或协程被销毁）时归还全局预算
+    struct RequestGuard {
+        AdmissionControl &admission;
+
+        ~RequestGuard() { admission.releaseRequests(); }
+    };
+
+    // 服务退出时停止等待热重启请求
+    struct ServingGuard {
+        HotRestart *hotRestart;
+
+        ~ServingGuard() { if (hotRestart) hotRestart->stopServing(); }
+    };
+
+    // 所有连接的收发队列积压总数
+    static Gauge &serverQueueDepth() {
+        static Gauge &depth = MetricsRegistry::instance().gauge("revoker_server_queue_depth",
+                                                                "Messages queued in client connection queues");
+        return depth;
+    }
+
+    static void waitForTraceDump(boost::asio::signal_set &signals) {
+        signals.async_wait([&signals](const boost::system::error_code &error, int) {
+            if (error) return;
+            RequestTracer::instance().dumpToFile();
+            waitForTraceDump(signals);
+        });
+    }
+
+    // 热重启时沿用旧进程交接的监听套接字，否则按 server_port 绑定
+    tcp::acceptor openAcceptor(io_context &ioc) const {
+        if (const int fd = hotRestart ? hotRestart->takeListenFd() : -1; fd >= 0) {
+            tcp::acceptor acceptor(ioc, tcp::v4(), fd);
+            std::cout << "Server is running at: " << acceptor.local_endpoint() << " (taken over)" << std::endl << std::endl;
+            return acceptor;
+        }
         auto server_port = stringToUShort(config.at("server_port")); // 读取配置文件的端口号
         auto endpoint = tcp::endpoint({tcp::v4(), server_port});
         tcp::acceptor acceptor(ioc, endpoint);
         std::cout << "Server is running at: " << endpoint << std::endl << std::endl;
+        return acceptor;
+    }
+
+    // 已交接给新进程：关闭本进程的监听（新进程持有同一个套接字，不会丢失排队的连接；RESP 端口由新进程以 SO_REUSEPORT 绑定），
+    // 已有连接（含 RESP 连接）全部断开或超过 hot_restart_drain_seconds 后停止服务
+    void startDrain(tcp::acceptor &acceptor, RespServer &respServer, boost::asio::steady_timer &drainTimer,
+                    io_context &ioc) const {
+        boost::system::error_code ec;
+        acceptor.close(ec);
+        respServer.stopAccepting();
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(hotRestart->getDrainSeconds());
+        std::cout << "[Server] Stopped accepting connections, draining " << admission.getConnections() << " connections" <<
+                std::endl;
+        waitForDrain(drainTimer, ioc, deadline);
+    }
+
+    void waitForDrain(boost::asio::steady_timer &drainTimer, io_context &ioc,
+                      const std::chrono::steady_clock::time_point deadline) const {
+        if (admission.getConnections() == 0 || std::chrono::steady_clock::now() >= deadline) {
+            std::cout << "[Server] Drained, " << admission.getConnections() << " connections left" << std::endl;
+            ioc.stop();
+            return;
+        }
+        drainTimer.expires_after(std::chrono::milliseconds(100));
+        drainTimer.async_wait([this, &drainTimer, &ioc, deadline](const boost::system::error_code &error) {
+            if (!error) waitForDrain(drainTimer, ioc, deadline);
+        });
+    }
+
+    awaitable<void> listener(io_context &ioc, tcp::acceptor &acceptor) const {
         while (true) {
-            tcp::socket socket = co_await acceptor.async_accept(use_awaitable);
+            boost::system::error_code acceptError;
+            tcp::socket socket = co_await acceptor.async_accept(boost::asio::redirect_error(use_awaitable, acceptError));
+            if (acceptError == boost::asio::error::operation_aborted || !acceptor.is_open()) co_return; // 热重启排空
+            if (acceptError) continue;
+            // 连接数已满：立即关闭，客户端按自身的退避策略重连
+            if (!admission.tryAcceptConnection()) {
+                boost::system::error_code ec;
+                socket.close(ec);
+                continue;
+            }
             co_spawn(ioc, handleClient(std::move(socket), ioc), boost::asio::detached);
         }
     }
 
     awaitable<void> handleClient(tcp::socket sock, io_context &ioc) const {
-        std::cout << "New client is connected: " << sock.remote_endpoint() << std::endl;
-        auto recvQueue = CoroutineSafeQueue<std::string>(ioc);
-        auto sendQueue = CoroutineSafeQueue<std::string>(ioc);
+        ConnectionGuard connectionGuard{admission};
+        const auto remoteEndpoint = sock.remote_endpoint();
+        std::cout << "New client is connected: " << remoteEndpoint << std::endl;
+        static Gauge &connections = MetricsRegistry::instance().gauge("revoker_server_connections",
+                                                                      "Open client connections");
+        connections.add(1);
+        auto recvQueue = CoroutineSafeQueue<Request>(ioc);
+        auto sendQueue = CoroutineSafeQueue<Reply>(ioc);
+
+        // 发送与处理协程并发运行（co_spawn + use_awaitable 是惰性启动的，不能依次 co_await），
+        // 任一协程退出时关闭 socket，使接收协程随之退出
+        boost::asio::steady_timer allDone(ioc, boost::asio::steady_timer::time_point::max());
+        int running = 2;
+        auto onDone = [&](const std::exception_ptr &) {
+            boost::system::error_code ec;
+            sock.close(ec);
+            if (--running == 0) allDone.cancel();
+        };
+        co_spawn(ioc, sendTask(sock, sendQueue), onDone);
+        co_spawn(ioc, processTask(recvQueue, sendQueue), onDone);
         try {
-            auto recv = co_spawn(ioc, recvTask(sock, recvQueue), use_awaitable);
-            auto send = co_spawn(ioc, sendTask(sock, sendQueue), use_awaitable);
-            auto process = co_spawn(ioc, processTask(recvQueue, sendQueue), use_awaitable);
-            co_await std::move(recv);
-            co_await std::move(send);
-            co_await std::move(process);
+            co_await recvTask(sock, recvQueue, sendQueue);
         } catch (const std::exception &e) {
-            // 如果任一协程抛出异常，其他协程也会被取消
             std::cerr << e.what() << std::endl;
-            std::cout << "Client connection is lost: " << sock.remote_endpoint() << std::endl;
+            std::cout << "Client connection is lost: " << remoteEndpoint << std::endl;
         }
+
+        // 关闭 socket 与队列，等待发送与处理协程结束后再释放它们引用的局部对象
+        boost::system::error_code ec;
+        sock.close(ec);
+        recvQueue.close();
+        sendQueue.close();
+        if (running > 0) co_await allDone.async_wait(boost::asio::redirect_error(use_awaitable, ec));
+
+        // 连接断开时丢弃的消息不再计入积压，也不再占用全局预算
+        serverQueueDepth().add(-static_cast<int64_t>(recvQueue.size() + sendQueue.size()));
+        if (recvQueue.size() > 0) admission.releaseRequests(recvQueue.size());
+        connections.add(-1);
         co_return;
     }
 
-    static awaitable<void> recvTask(tcp::socket &sock, CoroutineSafeQueue<std::string> &recvQueue) {
+    awaitable<void> recvTask(tcp::socket &sock, CoroutineSafeQueue<Request> &recvQueue,
+                             CoroutineSafeQueue<Reply> &sendQueue) const {
+        static Counter &shedCount = MetricsRegistry::instance().counter(
+            "revoker_server_shed_requests_total", "Queries answered with retry because server_max_inflight was reached");
+        const size_t perConnectionLimit = admission.getOptions().maxInflightPerConnection;
+        const size_t pendingReplyLimit = replyLimit();
         while (true) {
-            recvQueue.enqueue(co_await asyncRecvMsgFromSocket(sock));
+            // 本连接积压过多（包括客户端不读取的回复，过载时回复 retry 也会积压）时暂停读取，由 TCP 流控把压力传回客户端
+            if (perConnectionLimit > 0) co_await recvQueue.waitForSpace(perConnectionLimit);
+            co_await sendQueue.waitForSpace(pendingReplyLimit);
+            RequestTrace trace = RequestTracer::instance().sample();
+            std::string msg = co_await asyncRecvMsgFromSocket(sock, [&trace] { trace.mark(TraceStage::RecvStart); });
+            trace.mark(TraceStage::Received);
+
+            // 超出全局预算：查询直接回复 retry，不进入队列；撤回请求不能丢弃
+            if (!admission.tryAdmitRequest()) {
+                std::string event;
+                std::map<std::string, std::string> data;
+                msgParse(msg, event, data);
+                if (event == "is_jwt_revoked") {
+                    shedCount.inc();
+                    trace.setKind("shed");
+                    trace.mark(TraceStage::Replied);
+                    sendQueue.enqueue({retryResponse(data), std::move(trace)});
+                    serverQueueDepth().add(1);
+                    continue;
+                }
+                admission.admitRequest();
+            }
+            recvQueue.enqueue({std::move(msg), std::chrono::steady_clock::now(), std::move(trace)});
+            serverQueueDepth().add(1);
         }
     }
 
-    static awaitable<void> sendTask(tcp::socket &sock, CoroutineSafeQueue<std::string> &sendQueue) {
+    // 过载或超时的查询：status 为 retry，客户端稍后重试或回退到其他节点
+    static std::string retryResponse(std::map<std::string, std::string> &data) {
+        std::map<std::string, std::string> data_;
+        data_["token"] = data["token"];
+        data_["expTime"] = data["exp_time"];
+        data_["status"] = "retry";
+        return msgAssembly("is_jwt_revoked_response", data_);
+    }
+
+    static awaitable<void> sendTask(tcp::socket &sock, CoroutineSafeQueue<Reply> &sendQueue) {
         while (true) {
-            co_await asyncSendMsgToSocket(sock, co_await sendQueue.dequeue());
+            Reply reply = co_await sendQueue.dequeue();
+            serverQueueDepth().add(-1);
+            co_await asyncSendMsgToSocket(sock, reply.msg);
+            if (reply.trace.sampled()) {
+                reply.trace.mark(TraceStage::Sent);
+                RequestTracer::instance().commit(reply.trace);
+            }
         }
     }
 
-    awaitable<void> processTask(CoroutineSafeQueue<std::string> &recvQueue,
-                                CoroutineSafeQueue<std::string> &sendQueue) const {
+    awaitable<void> processTask(CoroutineSafeQueue<Request> &recvQueue,
+                                CoroutineSafeQueue<Reply> &sendQueue) const {
+        static Counter &expiredCount = MetricsRegistry::instance().counter(
+            "revoker_server_expired_requests_total", "Queries answered with retry because their deadline had passed");
+        const size_t pendingReplyLimit = replyLimit();
         while (true) {
-            auto message = co_await recvQueue.dequeue();
+            // 每个请求至多产生一条回复：回复积压到上限时暂停处理，待发送回复的个数不会超过上限
+            co_await sendQueue.waitForSpace(pendingReplyLimit);
+            auto [message, receivedAt, trace] = co_await recvQueue.dequeue();
+            trace.mark(TraceStage::Dequeued);
+            RequestGuard requestGuard{admission};
+            serverQueueDepth().add(-1);
+            static LatencyHistogram &requestLatency = MetricsRegistry::instance().histogram(
+                "revoker_server_request_seconds", "Server request processing time (parse, engine/proxy, reply)");
+            ScopedTimer timer(requestLatency);
             std::string event;
             std::map<std::string, std::string> data;
             msgParse(message, event, data);
+            trace.mark(TraceStage::Parsed);
 
-            // 查询请求
+            // 查询请求（可携带 sub / iat 与可选的 iss，同时检查按主体撤回的索引；
+            // 可选的 deadline_ms 为客户端的截止时刻，Unix 毫秒）
             if (event == "is_jwt_revoked") {
+                // 已过期的查询不再查询引擎或代理节点，直接回复 retry
+                if (admission.isExpired(receivedAt, data.contains("deadline_ms") ? stringToTimestamp(data["deadline_ms"]) : 0)) {
+                    expiredCount.inc();
+                    trace.setKind("expired");
+                    trace.mark(TraceStage::Replied);
+                    sendQueue.enqueue({retryResponse(data), std::move(trace)});
+                    serverQueueDepth().add(1);
+                    continue;
+                }
                 const std::string token = data["token"];
                 const std::string expTime = data["exp_time"];
+                const bool hasSubject = data.contains("sub") && data.contains("iat");
                 // 如果是 single_node 或 proxy_node 模式，则查询自身的布隆过滤器
-                if (scheduler.getNodeRole() == "single_node" || scheduler.getNodeRole() == "proxy_node") {
-                    const bool isRevoked = engine.isRevoked(token, stringToTimestamp(expTime));
+                const NodeRole role = scheduler.getNodeRole();
+                if (role == NodeRole::Single || role == NodeRole::Proxy) {
+                    bool isRevoked = namespaces.isRevoked(data["iss"], token, stringToTimestamp(expTime));
+                    if (!isRevoked && hasSubject) {
+                        isRevoked = namespaces.isSubjectRevoked(data["iss"], data["sub"], stringToTimestamp(data["iat"]));
+                    }
+                    trace.setKind("engine");
+                    trace.mark(TraceStage::Processed);
                     std::map<std::string, std::string> data_;
                     data_["token"] = token;
                     data_["expTime"] = expTime;
                     data_["status"] = isRevoked ? "revoked" : "active";
-                    const std::string resp = msgAssembly("is_jwt_revoked_response", data_);
-                    sendQueue.enqueue(resp);
+                    std::string resp = msgAssembly("is_jwt_revoked_response", data_);
+                    trace.mark(TraceStage::Replied);
+                    sendQueue.enqueue({std::move(resp), std::move(trace)});
+                    serverQueueDepth().add(1);
                     continue;
                 }
                 // 如果是salve_node，则委托 proxy_node 查询（代理查询）
-                if (scheduler.getNodeRole() == "slave_node") {
-                    const bool isRevoked = scheduler.proxyQuery(token, stringToTimestamp(expTime));
+                if (role == NodeRole::Slave) {
+                    std::map<std::string, std::string> subject;
+                    if (data.contains("iss")) subject["iss"] = data["iss"]; // proxy_node 按 iss 选择命名空间
+                    if (hasSubject) {
+                        subject["sub"] = data["sub"];
+                        subject["iat"] = data["iat"];
+                    }
+                    const bool isRevoked = scheduler.proxyQuery(token, stringToTimestamp(expTime), subject);
+                    trace.setKind("proxy");
+                    trace.mark(TraceStage::Processed);
                     std::map<std::string, std::string> data_;
                     data_["token"] = token;
                     data_["expTime"] = expTime;
                     data_["status"] = isRevoked ? "revoked" : "active";
-                    const std::string resp = msgAssembly("is_jwt_revoked_response", data_);
-                    sendQueue.enqueue(resp);
+                    std::string resp = msgAssembly("is_jwt_revoked_response", data_);
+                    trace.mark(TraceStage::Replied);
+                    sendQueue.enqueue({std::move(resp), std::move(trace)});
+                    serverQueueDepth().add(1);
                     continue;
                 }
             }
 
             // 当前节点被设置为 `proxy_node` 时，接受其他节点的插入请求
-            if (event == "revoke_jwt" && scheduler.getNodeRole() == "proxy_node") {
+            if (event == "revoke_jwt" && scheduler.getNodeRole() == NodeRole::Proxy) {
                 const std::string token = data["token"];
                 const std::string expTime = data["exp_time"];
-                engine.revokeJwt(token, stringToTimestamp(expTime));
+                namespaces.revokeJwt(data["iss"], token, stringToTimestamp(expTime));
+                trace.setKind("revoke");
+                trace.mark(TraceStage::Processed);
+                RequestTracer::instance().commit(trace);
+                continue;
+            }
+
+            // 同上，接受其他节点转发的按主体撤回
+            if (event == "revoke_subject" && scheduler.getNodeRole() == NodeRole::Proxy) {
+                if (const std::string sub = data["sub"]; isValidSubject(data["iss"], sub)) {
+                    namespaces.revokeSubject(data["iss"], sub, stringToTimestamp(data["revoked_before"]));
+                }
+                trace.setKind("revoke");
+                trace.mark(TraceStage::Processed);
+                RequestTracer::instance().commit(trace);
                 continue;
             }
         }
@@ -0,0 +1,203 @@
+#ifndef UDP_QUERY_SERVER_HPP
+#define UDP_QUERY_SERVER_HPP
+
+#include <atomic>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/asio.hpp>
+
+#if defined(__linux__)
+#include <sys/socket.h>
+#include <sys/time.h>
+#endif
+
+#include "../Engine/EngineNamespaces.hpp"
+#include "../Scheduler/Scheduler.hpp"
+#include "../Utils/ConfigReader.hpp"
+#include "../Utils/JsonSerializer.hpp"
+#include "../Utils/StringParser.hpp"
+#include "../Metrics/Metrics.hpp"
+
+using boost::asio::ip::udp;
+
+// 无连接的查询端点：每个数据报是一条不带长度前缀的 is_jwt_revoked 消息（字段与 TCP 相同，另带 id），
+// 应答也是一个数据报：{"event":"is_jwt_revoked_response","data":{"id":...,"status":"revoked|active|retry"}}，
+// 客户端按 id 匹配应答，超时自行重发。
+// udp_threads 个线程各持有一个绑定同一端口的套接字（SO_REUSEPORT，由内核按来源分散数据报），
+// Linux 上用 recvmmsg / sendmmsg 每次系统调用收发一批数据报，其他平台逐个收发。
+// 只在本节点持有引擎（single_node / proxy_node）时回答；slave_node 的代理查询连接不能被多个线程共用，回复 retry
+class UdpQueryServer {
+public:
+    UdpQueryServer(const std::map<std::string, std::string> &config, Scheduler &_scheduler, EngineNamespaces &_namespaces)
+        : scheduler(_scheduler), namespaces(_namespaces) {
+        const unsigned short port = stringToUShort(getConfigOrDefault(config, "udp_port", "0"));
+        if (port == 0) return; // 未配置端口，不启用
+
+        const auto endpoint = udp::endpoint(boost::asio::ip::make_address(getConfigOrDefault(config, "udp_ip", "0.0.0.0")),
+                                            port);
+        const unsigned int threadNum = std::max(1ul, std::stoul(getConfigOrDefault(config, "udp_threads", "1")));
+        batchSize = std::max(1ul, std::stoul(getConfigOrDefault(config, "udp_batch_size", "32")));
+        // 多个线程共用端口，或热重启期间新旧进程同时绑定该端口，都需要 SO_REUSEPORT
+        const bool reusePort = threadNum > 1 || !getConfigOrDefault(config, "hot_restart_socket", "").empty();
+        for (unsigned int i = 0; i < threadNum; ++i) sockets.push_back(openSocket(endpoint, reusePort));
+
+        runFlag.store(true);
+        for (auto &sock: sockets) workers.emplace_back([this, &sock] { worker(*sock); });
+        std::cout << "[UDP] Query endpoint is running at: " << endpoint << " (" << threadNum << " thread(s), batch " <<
+                batchSize << ")" << std::endl;
+    }
+
+    ~UdpQueryServer() {
+        runFlag.store(false);
+        for (auto &worker: workers) {
+            if (worker.joinable()) worker.join();
+        }
+    }
+
+    UdpQueryServer(const UdpQueryServer &) = delete;
+
+    UdpQueryServer &operator=(const UdpQueryServer &) = delete;
+
+private:
+    // 单个数据报的上限（超出的数据报被截断，按无效请求丢弃）
+    static constexpr size_t MAX_DATAGRAM_BYTES = 8192;
+
+    Scheduler &scheduler;
+    EngineNamespaces &namespaces;
+    size_t batchSize = 32;
+    boost::asio::io_context io_context_; // 只用于创建套接字，收发均为阻塞调用
+    std::vector<std::unique_ptr<udp::socket> > sockets;
+    std::atomic<bool> runFlag{false};
+    std::vector<std::thread> workers;
+
+    // 绑定套接字并设置接收超时（阻塞的收取定期返回，以便检查 runFlag 后退出）
+    std::unique_ptr<udp::socket> openSocket(const udp::endpoint &endpoint, const bool reusePort) {
+        auto sock = std::make_unique<udp::socket>(io_context_);
+        sock->open(endpoint.protocol());
+        if (reusePort) {
+#if defined(SO_REUSEPORT)
+            sock->set_option(boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>(true));
+#else
+            throw std::runtime_error("udp_threads > 1 and hot_restart_socket require SO_REUSEPORT");
+#endif
+        }
+        sock->bind(endpoint);
+#if defined(_WIN32)
+        const DWORD timeout = 200;
+#else
+        const timeval timeout{0, 200000};
+#endif
+        ::setsockopt(sock->native_handle(), SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char *>(&timeout),
+                     sizeof(timeout));
+        return sock;
+    }
+
+    static Counter &queryCount() {
+        static Counter &count = MetricsRegistry::instance().counter("revoker_udp_queries_total",
+                                                                    "Queries answered over the UDP endpoint");
+        return count;
+    }
+
+    static Counter &invalidCount() {
+        static Counter &count = MetricsRegistry::instance().counter(
+            "revoker_udp_invalid_datagrams_total", "UDP datagrams dropped because they were truncated or not a query");
+        return count;
+    }
+
+    // 处理一个数据报，返回应答；无效的数据报返回空串（不应答）
+    std::string handleDatagram(const std::string &msg) const {
+        std::string event;
+        std::map<std::string, std::string> data;
+        try {
+            msgParse(msg, event, data);
+        } catch (const std::exception &) {
+            return {};
+        }
+        if (event != "is_jwt_revoked" || !data.contains("token") || !data.contains("exp_time")) return {};
+
+        std::map<std::string, std::string> data_;
+        data_["id"] = data["id"];
+        if (const NodeRole role = scheduler.getNodeRole(); role == NodeRole::Single || role == NodeRole::Proxy) {
+            bool isRevoked = namespaces.isRevoked(data["iss"], data["token"], stringToTimestamp(data["exp_time"]));
+            if (!isRevoked && data.contains("sub") && data.contains("iat")) {
+                isRevoked = namespaces.isSubjectRevoked(data["iss"], data["sub"], stringToTimestamp(data["iat"]));
+            }
+            data_["status"] = isRevoked ? "revoked" : "active";
+        } else {
+            data_["status"] = "retry";
+        }
+        queryCount().inc();
+        return msgAssembly("is_jwt_revoked_response", data_);
+    }
+
+#if defined(__linux__)
+    // 一次 recvmmsg 收取至多 batchSize 个数据报（MSG_WAITFORONE：收到第一个后不再等待），应答用一次 sendmmsg 发回
+    void worker(udp::socket &sock) const {
+        const int fd = sock.native_handle();
+        std::vector<char> buffers(batchSize * MAX_DATAGRAM_BYTES);
+        std::vector<iovec> recvIov(batchSize);
+        std::vector<sockaddr_storage> addrs(batchSize);
+        std::vector<mmsghdr> recvMsgs(batchSize);
+        std::vector<std::string> replies(batchSize);
+        std::vector<iovec> sendIov(batchSize);
+        std::vector<mmsghdr> sendMsgs(batchSize);
+        while (runFlag) {
+            for (size_t i = 0; i < batchSize; ++i) {
+                recvIov[i] = {buffers.data() + i * MAX_DATAGRAM_BYTES, MAX_DATAGRAM_BYTES};
+                recvMsgs[i] = {};
+                recvMsgs[i].msg_hdr.msg_name = &addrs[i];
+                recvMsgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+                recvMsgs[i].msg_hdr.msg_iov = &recvIov[i];
+                recvMsgs[i].msg_hdr.msg_iovlen = 1;
+            }
+            const int received = ::recvmmsg(fd, recvMsgs.data(), static_cast<unsigned int>(batchSize), MSG_WAITFORONE,
+                                            nullptr);
+            if (received <= 0) continue; // 超时或被信号中断
+
+            unsigned int replyNum = 0;
+            for (int i = 0; i < received; ++i) {
+                if (recvMsgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+                    invalidCount().inc();
+                    continue;
+                }
+                replies[replyNum] = handleDatagram(std::string(buffers.data() + i * MAX_DATAGRAM_BYTES, recvMsgs[i].msg_len));
+                if (replies[replyNum].empty()) {
+                    invalidCount().inc();
+                    continue;
+                }
+                sendIov[replyNum] = {replies[replyNum].data(), replies[replyNum].size()};
+                sendMsgs[replyNum] = {};
+                sendMsgs[replyNum].msg_hdr.msg_name = &addrs[i];
+                sendMsgs[replyNum].msg_hdr.msg_namelen = recvMsgs[i].msg_hdr.msg_namelen;
+                sendMsgs[replyNum].msg_hdr.msg_iov = &sendIov[replyNum];
+                sendMsgs[replyNum].msg_hdr.msg_iovlen = 1;
+                ++replyNum;
+            }
+            // 发送缓冲区满时 sendmmsg 只发出一部分，剩余的应答丢弃（客户端重发）
+            if (replyNum > 0) ::sendmmsg(fd, sendMsgs.data(), replyNum, MSG_DONTWAIT);
+        }
+    }
+#else
+    void worker(udp::socket &sock) const {
+        std::vector<char> buffer(MAX_DATAGRAM_BYTES);
+        while (runFlag) {
+            udp::endpoint sender;
+            boost::system::error_code ec;
+            const size_t length = sock.receive_from(boost::asio::buffer(buffer), sender, 0, ec);
+            if (ec) continue; // 超时或数据报被截断
+            const std::string reply = handleDatagram(std::string(buffer.data(), length));
+            if (reply.empty()) {
+                invalidCount().inc();
+                continue;
+            }
+            sock.send_to(boost::asio::buffer(reply), sender, 0, ec);
+        }
+    }
+#endif
+};
+
+#endif //UDP_QUERY_SERVER_HPP
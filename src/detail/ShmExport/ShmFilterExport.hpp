@@ -0,0 +1,153 @@
+#ifndef SHM_FILTER_EXPORT_HPP
+#define SHM_FILTER_EXPORT_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "ShmFilterLayout.hpp"
+
+// 共享内存导出的写端：把撤回记录同步写入一块命名的共享内存（如 /dev/shm 下的文件），
+// 同机的网关进程用 ShmFilterReader 直接探测，不经过 TCP。
+// 窗口本身是多态的（布隆 / 布谷鸟 / 封存），因此导出区域是一份独立的布隆过滤器镜像，窗口划分与轮换和 Engine 一致。
+// 所有修改由调用方串行化（Engine 持有 filtersMtx）。
+// 新区域先写到 path + ".tmp"，publish() 时原子地重命名到 path；被替换的区域由 retire() 通知读端重新打开
+class ShmFilterExport {
+public:
+    ShmFilterExport(std::string _path, const unsigned long maxJwtLifeTime, const unsigned long rotationInterval,
+                    const size_t windowBits, const unsigned int hashNum, const unsigned int windowNum)
+        : path(std::move(_path)) {
+#if defined(_WIN32)
+        (void) maxJwtLifeTime, (void) rotationInterval, (void) windowBits, (void) hashNum, (void) windowNum;
+        throw std::runtime_error("shm_export_path is only supported on POSIX systems");
+#else
+        const uint64_t windowWords = (windowBits + 511) / 512 * SHM_BLOCK_WORDS;
+        const uint64_t dataOffset = (sizeof(ShmFilterHeader) + 4095) / 4096 * 4096;
+        mappedBytes = dataOffset + windowNum * windowWords * sizeof(uint64_t);
+
+        const std::string tmpPath = path + ".tmp";
+        fd = ::open(tmpPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) throw std::system_error(errno, std::generic_category(), "open " + tmpPath);
+        // 文件系统按需分配零页，未置位的区域不占用内存
+        if (::ftruncate(fd, static_cast<off_t>(mappedBytes)) != 0) {
+            const int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "ftruncate " + tmpPath);
+        }
+        void *addr = ::mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED) {
+            const int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "mmap " + tmpPath);
+        }
+        base = static_cast<char *>(addr);
+
+        header = new(base) ShmFilterHeader{};
+        header->magic = SHM_FILTER_MAGIC;
+        header->version = SHM_FILTER_VERSION;
+        header->hashNum = hashNum;
+        header->maxJwtLifeTime = maxJwtLifeTime;
+        header->rotationInterval = rotationInterval;
+        header->windowBits = windowBits;
+        header->windowNum = windowNum;
+        header->windowWords = windowWords;
+        header->dataOffset = dataOffset;
+        words = reinterpret_cast<uint64_t *>(base + dataOffset);
+#endif
+    }
+
+    ~ShmFilterExport() {
+#if !defined(_WIN32)
+        if (base) ::munmap(base, mappedBytes);
+        if (fd >= 0) ::close(fd);
+        if (!published) ::unlink((path + ".tmp").c_str());
+#endif
+    }
+
+    ShmFilterExport(const ShmFilterExport &) = delete;
+
+    ShmFilterExport &operator=(const ShmFilterExport &) = delete;
+
+    // 写入逻辑窗口 0 .. num - 1，hash 为 shmTokenHash(token)
+    void add(const uint64_t hash, const unsigned int num) {
+        const uint64_t step = shmMix(hash) | 1;
+        const uint64_t block = shmBlockOffset(hash, header->windowWords);
+        const uint64_t head = header->head.load(std::memory_order_relaxed);
+        for (unsigned int w = 0; w < num && w < header->windowNum; ++w) {
+            uint64_t *blockWords = words + (head + w) % header->windowNum * header->windowWords + block;
+            uint64_t position = shmRotl(hash, 32);
+            for (unsigned int i = 0; i < header->hashNum; ++i, position += step) {
+                const uint64_t bit = position & 511;
+                std::atomic_ref(blockWords[bit >> 6]).fetch_or(uint64_t{1} << (bit & 63), std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // 淘汰最旧的窗口，清空后作为最新的窗口
+    void rotate() {
+        const uint64_t generation = header->generation.load(std::memory_order_relaxed);
+        header->generation.store(generation + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        const uint64_t head = header->head.load(std::memory_order_relaxed);
+        uint64_t *window = words + head * header->windowWords;
+        for (uint64_t i = 0; i < header->windowWords; ++i) {
+            std::atomic_ref(window[i]).store(0, std::memory_order_relaxed);
+        }
+        header->head.store((head + 1) % header->windowNum, std::memory_order_relaxed);
+        header->generation.store(generation + 2, std::memory_order_release);
+    }
+
+    // 把区域发布到 path（替换上一个区域）
+    void publish() {
+#if !defined(_WIN32)
+        const std::string tmpPath = path + ".tmp";
+        if (::rename(tmpPath.c_str(), path.c_str()) != 0) {
+            throw std::system_error(errno, std::generic_category(), "rename " + tmpPath);
+        }
+        published = true;
+#endif
+    }
+
+    // 通知读端这块区域不再更新
+    void retire() { header->retired.store(1, std::memory_order_release); }
+
+    // 停止导出：读端重新打开时找不到区域，回退到 TCP 查询
+    void remove() {
+        retire();
+#if !defined(_WIN32)
+        // 热重启时 path 上可能已是新进程发布的区域，只删除自己的
+        struct stat own{}, current{};
+        if (published && ::fstat(fd, &own) == 0 && ::stat(path.c_str(), &current) == 0 && own.st_dev == current.st_dev &&
+            own.st_ino == current.st_ino) {
+            ::unlink(path.c_str());
+        }
+#endif
+    }
+
+    const std::string &getPath() const { return path; }
+
+    size_t getMappedBytes() const { return mappedBytes; }
+
+private:
+    std::string path;
+    int fd = -1;
+    char *base = nullptr;
+    size_t mappedBytes = 0;
+    ShmFilterHeader *header = nullptr;
+    uint64_t *words = nullptr; // 第一个窗口位图
+    bool published = false;
+};
+
+#endif //SHM_FILTER_EXPORT_HPP
@@ -0,0 +1,83 @@
+#ifndef SHM_FILTER_LAYOUT_HPP
+#define SHM_FILTER_LAYOUT_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// 共享内存导出区域的布局，写端（ShmFilterExport）与读端（ShmFilterReader）共用，只依赖标准库。
+// 区域 = 头部（按页对齐）+ windowNum 个窗口位图（每个按缓存行对齐），窗口按环形排列：
+// 逻辑窗口 i（0 为最旧、所有撤回都会写入的窗口）位于第 (head + i) % windowNum 个位图。
+// 轮换时写端先把 generation 加 1（奇数），清空最旧的位图并前移 head，再加 1（偶数）；
+// 读端在 generation 为偶数且前后一致时的探测结果才有效（seqlock）。写入只置位，不改变 generation。
+
+constexpr uint64_t SHM_FILTER_MAGIC = 0x4d48535652574a31ULL; // "1JWRVSHM"
+constexpr uint32_t SHM_FILTER_VERSION = 1;
+
+struct ShmFilterHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t hashNum; // 每个窗口的哈希函数个数
+    uint64_t maxJwtLifeTime;
+    uint64_t rotationInterval;
+    uint64_t windowBits; // 每个窗口的设计比特数（按块向上取整后为 windowWords * 64）
+    uint64_t windowNum;
+    uint64_t windowWords; // 每个窗口占用的 64 位字数（按缓存行向上取整）
+    uint64_t dataOffset; // 第一个窗口位图相对区域起点的偏移
+    alignas(64) std::atomic<uint64_t> generation; // seqlock 计数，奇数表示正在轮换
+    std::atomic<uint64_t> head; // 逻辑窗口 0 所在的位图下标
+    std::atomic<uint32_t> retired; // 非 0 表示写端已换用新区域（或已停止），读端应重新打开
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "shared-memory counters must be lock-free");
+
+inline uint64_t shmRotl(const uint64_t x, const int r) { return (x << r) | (x >> (64 - r)); }
+
+inline uint64_t shmMix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// 导出区域使用的 token 哈希：不依赖 SHA256，四路并行的乘法-循环移位，读端探测一次只需几十纳秒
+inline uint64_t shmTokenHash(const std::string_view token) {
+    constexpr uint64_t P1 = 0x9e3779b185ebca87ULL;
+    constexpr uint64_t P2 = 0xc2b2ae3d27d4eb4fULL;
+    const char *p = token.data();
+    size_t n = token.size();
+    uint64_t h = P1 ^ (n * P2);
+    if (n >= 32) {
+        uint64_t lanes[4] = {P1 + P2, P2, 0, 0 - P1};
+        for (; n >= 32; n -= 32, p += 32) {
+            for (uint64_t &lane: lanes) {
+                uint64_t word;
+                std::memcpy(&word, p + (&lane - lanes) * 8, 8);
+                lane = shmRotl(lane + word * P2, 31) * P1;
+            }
+        }
+        h ^= shmRotl(lanes[0], 1) + shmRotl(lanes[1], 7) + shmRotl(lanes[2], 12) + shmRotl(lanes[3], 18);
+    }
+    for (; n >= 8; n -= 8, p += 8) {
+        uint64_t word;
+        std::memcpy(&word, p, 8);
+        h = shmRotl(h ^ (word * P2), 27) * P1;
+    }
+    uint64_t tail = 0;
+    std::memcpy(&tail, p, n);
+    return shmMix(h ^ tail);
+}
+
+// 分块布隆过滤器：每个窗口按 512 比特（一个缓存行）分块，一个 token 的 k 个比特都落在同一块内，
+// 探测每个窗口只访问一个缓存行。块内第 i 个比特为 (rotl(hash, 32) + i * step) & 511，step = shmMix(hash) | 1
+constexpr uint64_t SHM_BLOCK_WORDS = 8;
+
+inline uint64_t shmBlockOffset(const uint64_t hash, const uint64_t windowWords) {
+    return hash % (windowWords / SHM_BLOCK_WORDS) * SHM_BLOCK_WORDS;
+}
+
+#endif //SHM_FILTER_LAYOUT_HPP
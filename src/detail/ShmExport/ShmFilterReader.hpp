@@ -0,0 +1,141 @@
+#ifndef SHM_FILTER_READER_HPP
+#define SHM_FILTER_READER_HPP
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <ctime>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ShmFilterLayout.hpp"
+
+// 共享内存导出的读端（仅 POSIX，只依赖标准库与 ShmFilterLayout.hpp，可直接拷贝到网关项目中使用）：
+// 只读映射撤回服务发布的区域，在本进程内探测 token，不经过 TCP。
+//
+//     ShmFilterReader reader("/dev/shm/jwtrevoker");
+//     if (reader.isRevoked(token, exp)) { ... }
+//
+// 与 Engine::isRevoked 的语义相同：可能误判、不会漏报（写入在服务端返回前即已可见）。
+// 按主体批量撤回（revoke_subject）不在导出范围内，需要的话仍向服务查询。
+// 一个对象不能被多个线程同时使用，每个线程各自打开一个（映射共享同一份物理内存）。
+// 服务重建窗口后会发布新区域并使旧区域失效，读端下次查询时自动重新打开；
+// 服务停止后（重新打开失败，或写端停在轮换中途）isRevoked 抛出 std::system_error，调用方应回退到 TCP 查询；
+// 路径上不是导出区域或版本不符时抛出 std::runtime_error（std::system_error 的基类，捕获它即可覆盖两种情况）
+class ShmFilterReader {
+public:
+    explicit ShmFilterReader(std::string _path) : path(std::move(_path)) { open(); }
+
+    ~ShmFilterReader() { close(); }
+
+    ShmFilterReader(const ShmFilterReader &) = delete;
+
+    ShmFilterReader &operator=(const ShmFilterReader &) = delete;
+
+    bool isRevoked(const std::string_view token, const time_t expTime, const time_t now = std::time(nullptr)) {
+        if (header->retired.load(std::memory_order_acquire)) reopen();
+
+        // 剩余时长决定需要探测的窗口个数，与 Engine::isRevoked 一致
+        const time_t remainingTime = expTime - now;
+        if (remainingTime <= 0 || static_cast<uint64_t>(remainingTime) > header->maxJwtLifeTime) return false;
+        const uint64_t num = (remainingTime + header->rotationInterval - 1) / header->rotationInterval;
+        if (num > header->windowNum) return false;
+
+        const uint64_t hash = shmTokenHash(token);
+        const uint64_t step = shmMix(hash) | 1;
+        for (unsigned int spin = 0;; ++spin) {
+            const uint64_t generation = header->generation.load(std::memory_order_acquire);
+            if ((generation & 1) == 0) {
+                const bool revoked = probe(hash, step, num, header->head.load(std::memory_order_relaxed));
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (header->generation.load(std::memory_order_relaxed) == generation) return revoked;
+            }
+            // 轮换只清空一个窗口，通常几十微秒内完成；写端在轮换中途退出时不会无限等待
+            if (spin >= MAX_SPIN) {
+                throw std::system_error(std::make_error_code(std::errc::timed_out),
+                                        "Shared-memory filter is stuck in rotation: " + path);
+            }
+        }
+    }
+
+    const std::string &getPath() const { return path; }
+
+private:
+    static constexpr unsigned int MAX_SPIN = 1u << 24;
+
+    std::string path;
+    const char *base = nullptr;
+    size_t mappedBytes = 0;
+    const ShmFilterHeader *header = nullptr;
+    const uint64_t *words = nullptr;
+
+    bool probe(const uint64_t hash, const uint64_t step, const uint64_t num, const uint64_t head) const {
+        const uint64_t block = shmBlockOffset(hash, header->windowWords);
+        for (uint64_t w = 0; w < num; ++w) {
+            const uint64_t *blockWords = words + (head + w) % header->windowNum * header->windowWords + block;
+            uint64_t position = shmRotl(hash, 32);
+            for (unsigned int i = 0; i < header->hashNum; ++i, position += step) {
+                const uint64_t bit = position & 511;
+                const uint64_t word = std::atomic_ref(const_cast<uint64_t &>(blockWords[bit >> 6])).load(std::memory_order_relaxed);
+                if ((word >> (bit & 63) & 1) == 0) return false;
+            }
+        }
+        return true;
+    }
+
+    void open() {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) throw std::system_error(errno, std::generic_category(), "open " + path);
+        struct stat st{};
+        if (::fstat(fd, &st) != 0) {
+            const int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "fstat " + path);
+        }
+        const auto size = static_cast<size_t>(st.st_size);
+        if (size < sizeof(ShmFilterHeader)) {
+            ::close(fd);
+            throw std::runtime_error("Not a shared-memory filter: " + path);
+        }
+        void *addr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd); // 映射保持有效
+        if (addr == MAP_FAILED) throw std::system_error(errno, std::generic_category(), "mmap " + path);
+
+        const auto *mapped = static_cast<const ShmFilterHeader *>(addr);
+        if (mapped->magic != SHM_FILTER_MAGIC || mapped->version != SHM_FILTER_VERSION || mapped->windowNum == 0 ||
+            mapped->windowWords < SHM_BLOCK_WORDS || mapped->rotationInterval == 0 ||
+            mapped->dataOffset + mapped->windowNum * mapped->windowWords * sizeof(uint64_t) > size) {
+            ::munmap(addr, size);
+            throw std::runtime_error("Not a shared-memory filter or unsupported version: " + path);
+        }
+        base = static_cast<const char *>(addr);
+        mappedBytes = size;
+        header = mapped;
+        words = reinterpret_cast<const uint64_t *>(base + header->dataOffset);
+    }
+
+    void close() {
+        if (base) ::munmap(const_cast<char *>(base), mappedBytes);
+        base = nullptr;
+        header = nullptr;
+        words = nullptr;
+    }
+
+    // 换用 path 上当前发布的区域；打开失败时保留旧映射，下次查询再试
+    void reopen() {
+        const char *oldBase = base;
+        const size_t oldBytes = mappedBytes;
+        open();
+        ::munmap(const_cast<char *>(oldBase), oldBytes);
+    }
+};
+
+#endif //SHM_FILTER_READER_HPP
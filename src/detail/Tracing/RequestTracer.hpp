@@ -0,0 +1,231 @@
+#ifndef REQUEST_TRACER_HPP
+#define REQUEST_TRACER_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "../Utils/ConfigReader.hpp"
+
+// 请求在 Server 中经过的阶段（每个阶段记录到达时刻）
+enum class TraceStage : uint8_t {
+    RecvStart, // 收到消息头
+    Received, // 收齐消息体
+    Dequeued, // 处理协程从接收队列取出
+    Parsed, // msgParse 完成
+    Processed, // 查询引擎 / 代理查询 / 写入完成
+    Replied, // 应答放入发送队列
+    Sent, // 应答写入套接字
+    Num
+};
+
+inline constexpr size_t TRACE_STAGE_NUM = static_cast<size_t>(TraceStage::Num);
+
+// 时间戳计数器：x86 上为 TSC（要求 constant_tsc，现代 CPU 均满足），其他平台为 steady_clock 纳秒
+inline uint64_t readTraceClock() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// 一个被采样请求的各阶段时间戳（0 表示未经过该阶段）与处理方式
+struct TraceRecord {
+    std::array<uint64_t, TRACE_STAGE_NUM> stamps{};
+    const char *kind = "query"; // engine | proxy | revoke | shed | expired
+};
+
+// 随请求在队列间传递；未被采样时为空，每个阶段只多一次判空
+class RequestTrace {
+public:
+    RequestTrace() = default;
+
+    explicit RequestTrace(std::unique_ptr<TraceRecord> _record) : record(std::move(_record)) {}
+
+    bool sampled() const { return record != nullptr; }
+
+    void mark(const TraceStage stage) {
+        if (record) record->stamps[static_cast<size_t>(stage)] = readTraceClock();
+    }
+
+    void setKind(const char *kind) {
+        if (record) record->kind = kind;
+    }
+
+    std::unique_ptr<TraceRecord> release() { return std::move(record); }
+
+private:
+    std::unique_ptr<TraceRecord> record;
+};
+
+// 按 trace_sample_rate 采样请求，完成的记录写入定长的无锁环形缓冲区（覆盖最旧的记录）；
+// 通过指标端点的 GET /debug/trace 或 SIGUSR2（写入 trace_dump_path）导出为 Chrome trace JSON，
+// 可在 chrome://tracing 或 Perfetto 中查看
+class RequestTracer {
+public:
+    static RequestTracer &instance() {
+        static RequestTracer tracer;
+        return tracer;
+    }
+
+    // 由 Server 在启动时调用一次（之后采样周期只读）
+    void configure(const std::map<std::string, std::string> &config) {
+        const double rate = std::stod(getConfigOrDefault(config, "trace_sample_rate", "0"));
+        if (rate < 0 || rate > 1) throw std::invalid_argument("trace_sample_rate must be between 0 and 1");
+        size_t capacity = std::stoul(getConfigOrDefault(config, "trace_ring_size", "4096"));
+        if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+            throw std::invalid_argument("trace_ring_size must be a power of 2");
+        }
+        dumpPath = getConfigOrDefault(config, "trace_dump_path", "revoker_trace.json");
+        if (rate == 0) return;
+
+        slots = std::make_unique<Slot[]>(capacity);
+        mask = capacity - 1;
+        clockBase = readTraceClock();
+        steadyBase = std::chrono::steady_clock::now();
+        samplePeriod.store(static_cast<uint64_t>(std::llround(1 / rate)), std::memory_order_release);
+        std::cout << "[Tracer] Sampling 1/" << samplePeriod.load() << " requests into a ring of " << capacity <<
+                " traces" << std::endl;
+    }
+
+    bool enabled() const { return samplePeriod.load(std::memory_order_relaxed) != 0; }
+
+    const std::string &getDumpPath() const { return dumpPath; }
+
+    // 每个请求调用一次：每 samplePeriod 个请求采样一个（各线程独立计数）
+    RequestTrace sample() {
+        const uint64_t period = samplePeriod.load(std::memory_order_relaxed);
+        if (period == 0) return {};
+        thread_local uint64_t countdown = 0;
+        if (countdown-- > 0) return {};
+        countdown = period - 1;
+        return RequestTrace(std::make_unique<TraceRecord>());
+    }
+
+    // 提交一个完成的请求：领取一个槽位，以序号的奇偶标记写入中 / 已完成（seqlock），读取方跳过不一致的槽位。
+    // 序号相差环容量整数倍的两次提交落在同一个槽位：用 CAS 把序号从已完成的偶数值改为本次的奇数值才能写入，
+    // 槽位正被写入或已有更新的记录时丢弃本条（采样记录，丢弃不影响统计）
+    void commit(RequestTrace &trace) {
+        const std::unique_ptr<TraceRecord> record = trace.release();
+        if (!record || !slots) return;
+        const uint64_t id = head.fetch_add(1, std::memory_order_relaxed);
+        Slot &slot = slots[id & mask];
+        uint64_t seq = slot.seq.load(std::memory_order_relaxed);
+        if ((seq & 1) != 0 || seq > 2 * id ||
+            !slot.seq.compare_exchange_strong(seq, 2 * id + 1, std::memory_order_relaxed)) {
+            return;
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < TRACE_STAGE_NUM; ++i) slot.stamps[i].store(record->stamps[i], std::memory_order_relaxed);
+        slot.kind.store(record->kind, std::memory_order_relaxed);
+        slot.seq.store(2 * id + 2, std::memory_order_release);
+    }
+
+    // Chrome trace（JSON Object Format）：每个请求一行（tid 为请求序号），外层事件覆盖整个请求，内层为各阶段
+    std::string renderChromeTrace() const {
+        std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        if (!slots) return out + "]}\n";
+
+        // 用两次采样之间的 steady_clock 换算时间戳计数器的频率
+        const double ticksPerUs = static_cast<double>(readTraceClock() - clockBase) /
+                                  std::max(1.0, static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                      std::chrono::steady_clock::now() - steadyBase).count()));
+        const uint64_t end = head.load(std::memory_order_acquire);
+        const uint64_t begin = end > mask + 1 ? end - (mask + 1) : 0;
+        bool first = true;
+        char buf[256];
+        for (uint64_t id = begin; id < end; ++id) {
+            const Slot &slot = slots[id & mask];
+            const uint64_t seq = slot.seq.load(std::memory_order_acquire);
+            if (seq != 2 * id + 2) continue; // 仍在写入，或已被更新的记录覆盖
+            TraceRecord record;
+            for (size_t i = 0; i < TRACE_STAGE_NUM; ++i) record.stamps[i] = slot.stamps[i].load(std::memory_order_relaxed);
+            record.kind = slot.kind.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) != seq) continue;
+
+            const auto toUs = [&](const uint64_t stamp) {
+                return static_cast<double>(static_cast<int64_t>(stamp - clockBase)) / ticksPerUs;
+            };
+            const auto event = [&](const char *name, const uint64_t from, const uint64_t to) {
+                std::snprintf(buf, sizeof(buf),
+                              "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%llu,\"ts\":%.3f,\"dur\":%.3f}",
+                              first ? "" : ",", name, record.kind, static_cast<unsigned long long>(id), toUs(from),
+                              std::max(0.0, toUs(to) - toUs(from)));
+                out += buf;
+                first = false;
+            };
+
+            // 外层事件：第一个与最后一个记录到的阶段之间
+            uint64_t firstStamp = 0, lastStamp = 0;
+            for (const uint64_t stamp: record.stamps) {
+                if (stamp == 0) continue;
+                if (firstStamp == 0) firstStamp = stamp;
+                lastStamp = stamp;
+            }
+            if (firstStamp == 0) continue;
+            event(record.kind, firstStamp, lastStamp);
+
+            // 各阶段：相邻两个记录到的时间戳之间，按后一个时间戳所属的阶段命名
+            static constexpr const char *STAGE_NAMES[TRACE_STAGE_NUM] = {
+                "", "recv", "queue", "parse", "process", "reply", "send"
+            };
+            uint64_t previous = 0;
+            for (size_t i = 0; i < TRACE_STAGE_NUM; ++i) {
+                const uint64_t stamp = record.stamps[i];
+                if (stamp == 0) continue;
+                if (previous != 0) {
+                    event(i == static_cast<size_t>(TraceStage::Processed) ? record.kind : STAGE_NAMES[i], previous, stamp);
+                }
+                previous = stamp;
+            }
+        }
+        return out + "]}\n";
+    }
+
+    // SIGUSR2：写入 trace_dump_path
+    void dumpToFile() const {
+        std::ofstream file(dumpPath, std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "[Tracer] Cannot open trace dump file: " << dumpPath << std::endl;
+            return;
+        }
+        file << renderChromeTrace();
+        std::cout << "[Tracer] Dumped request traces to " << dumpPath << std::endl;
+    }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> seq{0};
+        std::array<std::atomic<uint64_t>, TRACE_STAGE_NUM> stamps{};
+        std::atomic<const char *> kind{nullptr};
+    };
+
+    std::atomic<uint64_t> samplePeriod{0}; // 0 表示不采样
+    std::unique_ptr<Slot[]> slots;
+    uint64_t mask = 0;
+    std::atomic<uint64_t> head{0};
+    uint64_t clockBase = 0;
+    std::chrono::steady_clock::time_point steadyBase;
+    std::string dumpPath;
+
+    RequestTracer() = default;
+};
+
+#endif //REQUEST_TRACER_HPP
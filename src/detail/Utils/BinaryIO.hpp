@@ -0,0 +1,37 @@
+#ifndef BINARYIO_HPP
+#define BINARYIO_HPP
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// 过滤器序列化使用的二进制读写：按本机字节序直接拷贝，只用于同一平台上的快照
+
+inline void appendBytes(std::string &out, const void *data, const size_t len) {
+    out.append(static_cast<const char *>(data), len);
+}
+
+template<typename T>
+void appendPod(std::string &out, const T &value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    appendBytes(out, &value, sizeof(T));
+}
+
+// 从 in 的开头读取 len 字节并前移；数据不足时抛出异常
+inline void readBytes(std::string_view &in, void *data, const size_t len) {
+    if (in.size() < len) throw std::runtime_error("Truncated binary data");
+    std::memcpy(data, in.data(), len);
+    in.remove_prefix(len);
+}
+
+template<typename T>
+T readPod(std::string_view &in) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    T value;
+    readBytes(in, &value, sizeof(T));
+    return value;
+}
+
+#endif //BINARYIO_HPP
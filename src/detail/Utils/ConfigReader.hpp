@@ -60,4 +60,11 @@ inline std::map<std::string, std::string> readConfig(const std::string& filename
     return config;
 }
 
+// 读取可选配置项，不存在时返回默认值
+inline std::string getConfigOrDefault(const std::map<std::string, std::string>& config, const std::string& key,
+                                      const std::string& defaultValue) {
+    const auto it = config.find(key);
+    return it == config.end() ? defaultValue : it->second;
+}
+
 #endif // CONFIGREADER_HPP
@@ -0,0 +1,102 @@
+#ifndef EPOCH_DOMAIN_HPP
+#define EPOCH_DOMAIN_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+// 基于纪元的内存回收（RCU 风格）：无锁读者在读取共享结构期间持有 ReadGuard，
+// 写者先发布新版本，再调用 synchronize() 等待发布之前进入的读者全部离开，之后才能释放旧版本。
+// 每个线程第一次读取时登记一个独占缓存行的槽位（线程退出后归还复用），读者进出只写自己的槽位
+class EpochDomain {
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> epoch{0}; // 读者进入时的纪元，0 表示不在读取中
+        std::atomic<bool> inUse{true};
+        unsigned int depth = 0; // 嵌套的 ReadGuard 层数（只由持有槽位的线程访问）
+        Slot *next = nullptr;
+    };
+
+public:
+    static EpochDomain &instance() {
+        static EpochDomain domain;
+        return domain;
+    }
+
+    // 读者临界区：其间读到的已发布指针在析构之前不会被释放。可以嵌套，不能在其中调用 synchronize()
+    class ReadGuard {
+    public:
+        ReadGuard() : slot(instance().localSlot()) {
+            if (slot->depth++ == 0) {
+                slot->epoch.store(instance().globalEpoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                // 槽位的写入先于之后对共享指针的读取对写者可见
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+            }
+        }
+
+        ~ReadGuard() {
+            if (--slot->depth == 0) slot->epoch.store(0, std::memory_order_release);
+        }
+
+        ReadGuard(const ReadGuard &) = delete;
+
+        ReadGuard &operator=(const ReadGuard &) = delete;
+
+    private:
+        Slot *slot;
+    };
+
+    // 等待调用之前进入的读者全部离开（调用方已把旧版本从共享指针上摘下）。
+    // 读者之后进入时要么读到新版本，要么其纪元不小于本次推进后的纪元，均无需等待
+    void synchronize() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const uint64_t target = globalEpoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+        for (const Slot *slot = head.load(std::memory_order_acquire); slot; slot = slot->next) {
+            while (true) {
+                const uint64_t epoch = slot->epoch.load(std::memory_order_acquire);
+                if (epoch == 0 || epoch >= target) break;
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    EpochDomain(const EpochDomain &) = delete;
+
+    EpochDomain &operator=(const EpochDomain &) = delete;
+
+private:
+    EpochDomain() = default;
+
+    // 槽位只增不减（线程数有限），进程退出前不释放，线程退出时的归还不会访问已释放的内存
+    std::atomic<uint64_t> globalEpoch{1};
+    std::atomic<Slot *> head{nullptr};
+
+    struct SlotOwner {
+        Slot *slot = nullptr;
+
+        ~SlotOwner() {
+            if (slot) slot->inUse.store(false, std::memory_order_release);
+        }
+    };
+
+    Slot *localSlot() {
+        thread_local SlotOwner owner;
+        if (!owner.slot) owner.slot = acquireSlot();
+        return owner.slot;
+    }
+
+    Slot *acquireSlot() {
+        for (Slot *slot = head.load(std::memory_order_acquire); slot; slot = slot->next) {
+            bool expected = false;
+            if (!slot->inUse.load(std::memory_order_relaxed) &&
+                slot->inUse.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+                return slot;
+            }
+        }
+        auto *slot = new Slot();
+        slot->next = head.load(std::memory_order_relaxed);
+        while (!head.compare_exchange_weak(slot->next, slot, std::memory_order_release, std::memory_order_relaxed)) {}
+        return slot;
+    }
+};
+
+#endif //EPOCH_DOMAIN_HPP
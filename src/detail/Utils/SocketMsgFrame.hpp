@@ -36,10 +36,13 @@ inline void sendMsgToSocket(tcp::socket &sock, const std::string &msg) {
     boost::asio::write(sock, boost::asio::buffer(msgFrame, 4 + msg.size()));
 }
 
-inline awaitable<std::string> asyncRecvMsgFromSocket(tcp::socket &sock) {
+// onHeader 在收到消息头后调用（请求追踪用它标记消息开始到达的时刻，不包括连接空闲的时间）
+template<typename OnHeader>
+awaitable<std::string> asyncRecvMsgFromSocket(tcp::socket &sock, OnHeader onHeader) {
     // 接收消息头
     char msgHeaderBE[4]{};
     co_await async_read(sock, boost::asio::buffer(msgHeaderBE, 4), use_awaitable);
+    onHeader();
 
     // 网络字节序转为主机字节序
     std::uint32_t msgBodyLength = 0;
@@ -53,6 +56,10 @@ inline awaitable<std::string> asyncRecvMsgFromSocket(tcp::socket &sock) {
     co_return std::string(msgBody.begin(), msgBody.end());
 }
 
+inline awaitable<std::string> asyncRecvMsgFromSocket(tcp::socket &sock) {
+    return asyncRecvMsgFromSocket(sock, [] {});
+}
+
 inline awaitable<void> asyncSendMsgToSocket(tcp::socket &sock, const std::string &msg) {
     if (msg.empty()) co_return;
     // 动态分配消息帧内存，包括 4 bytes 的消息长度和消息体
@@ -62,7 +69,7 @@ inline awaitable<void> asyncSendMsgToSocket(tcp::socket &sock, const std::string
     std::memcpy(msgFrame.data() + 4, msg.data(), msg.size());
 
     // 异步发送消息帧
-    co_await async_write(sock, boost::asio::buffer(msgFrame));
+    co_await async_write(sock, boost::asio::buffer(msgFrame), use_awaitable);
 }
 
 #endif //MSG_SEND_RECV_HPP
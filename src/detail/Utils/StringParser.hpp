@@ -4,6 +4,7 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <cstdio>
 
 inline unsigned short stringToUShort(const std::string& str) {
     try { return std::stoul(str); }
@@ -61,4 +62,18 @@ inline std::string vectorToString(const std::vector<unsigned long>& vec) {
     return result;
 }
 
+inline std::string vectorToString(const std::vector<double>& vec) {
+    std::string result = "[";
+
+    for (size_t i = 0; i < vec.size(); ++i) {
+        if (i > 0) { result += ","; }
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.6g", vec[i]);
+        result += buf;
+    }
+
+    result += "]";
+    return result;
+}
+
 #endif //STRINGCONVERTER_HPP
@@ -1,53 +1,156 @@
 #ifndef THREAD_SAFE_QUEUE_HPP
 #define THREAD_SAFE_QUEUE_HPP
 
-#include <queue>
-#include <mutex>
-#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
 
 #define QUEUE_DEFAULT_MAXSIZE 4096
+#define QUEUE_CACHE_LINE_SIZE 64
 
+// 有界无锁多生产者多消费者环形队列（Vyukov MPMC），容量向上取整为 2 的幂
+// 非阻塞接口：tryEnqueue / tryDequeue；阻塞接口：enqueue / dequeue / dequeueBulk（基于 std::atomic::wait，Linux 下即 futex）
 template<typename T>
 class ThreadSafeQueue {
 public:
-    explicit ThreadSafeQueue(const size_t _maxSize = QUEUE_DEFAULT_MAXSIZE) : maxSize(_maxSize) {
+    explicit ThreadSafeQueue(const size_t _maxSize = QUEUE_DEFAULT_MAXSIZE) {
+        capacity = 2;
+        while (capacity < _maxSize) capacity <<= 1;
+        mask = capacity - 1;
+        cells = std::make_unique<Cell[]>(capacity);
+        for (size_t i = 0; i < capacity; ++i) cells[i].sequence.store(i, std::memory_order_relaxed);
     }
 
-    // 向队列中添加元素
+    ThreadSafeQueue(const ThreadSafeQueue &) = delete;
+
+    ThreadSafeQueue &operator=(const ThreadSafeQueue &) = delete;
+
+    // 尝试向队列中添加元素，队列满时立即返回 false
+    bool tryEnqueue(T &value) {
+        size_t pos = enqueuePos.value.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &cell = cells[pos & mask];
+            const size_t seq = cell.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos.value.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.data = std::move(value);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    wake(itemsEpoch, consumersWaiting);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // 队列已满
+            } else {
+                pos = enqueuePos.value.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // 尝试从队列中取出元素，队列空时立即返回 false
+    bool tryDequeue(T &value) {
+        size_t pos = dequeuePos.value.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &cell = cells[pos & mask];
+            const size_t seq = cell.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeuePos.value.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    value = std::move(cell.data);
+                    cell.sequence.store(pos + mask + 1, std::memory_order_release);
+                    wake(slotsEpoch, producersWaiting);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // 队列为空
+            } else {
+                pos = dequeuePos.value.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // 向队列中添加元素，队列满时等待
     void enqueue(T value) {
-        std::unique_lock lock(queueMutex);
-        queueCv.wait(lock, [this] { return queue.size() < maxSize; }); // 队列满时等待
-        queue.push(std::move(value));
-        queueCv.notify_one();
+        if (!tryEnqueue(value)) waitFor(slotsEpoch, producersWaiting, [&] { return tryEnqueue(value); });
     }
 
-    // 从队列中取出元素
+    // 从队列中取出元素，队列为空时等待
     T dequeue() {
-        std::unique_lock lock(queueMutex);
-        queueCv.wait(lock, [this] { return !queue.empty(); }); // 等待队列中有元素
-        T value = std::move(queue.front());
-        queue.pop();
-        queueCv.notify_one();
+        T value{};
+        if (!tryDequeue(value)) waitFor(itemsEpoch, consumersWaiting, [&] { return tryDequeue(value); });
         return value;
     }
 
-    // 检查队列是否为空
-    bool isEmpty() const {
-        std::unique_lock lock(queueMutex);
-        return queue.empty();
+    // 批量取出元素：至少等待到一个元素，之后不再阻塞，最多取出 maxItems 个，返回取出的个数
+    size_t dequeueBulk(std::vector<T> &out, const size_t maxItems) {
+        if (maxItems == 0) return 0;
+        T value{};
+        if (!tryDequeue(value)) waitFor(itemsEpoch, consumersWaiting, [&] { return tryDequeue(value); });
+        out.push_back(std::move(value));
+        size_t n = 1;
+        while (n < maxItems && tryDequeue(value)) {
+            out.push_back(std::move(value));
+            ++n;
+        }
+        return n;
     }
 
-    // 获取队列的大小
+    // 检查队列是否为空
+    bool isEmpty() const { return size() == 0; }
+
+    // 获取队列的大小（并发下为近似值）
     size_t size() const {
-        std::unique_lock lock(queueMutex);
-        return queue.size();
+        const size_t tail = dequeuePos.value.load(std::memory_order_acquire);
+        const size_t head = enqueuePos.value.load(std::memory_order_acquire);
+        return head > tail ? head - tail : 0;
     }
 
 private:
-    size_t maxSize;
-    std::queue<T> queue;
-    mutable std::mutex queueMutex;
-    std::condition_variable queueCv;
+    struct Cell {
+        std::atomic<size_t> sequence{0};
+        T data{};
+    };
+
+    // 独占一个缓存行的计数器，避免生产者与消费者之间的伪共享
+    template<typename V>
+    struct alignas(QUEUE_CACHE_LINE_SIZE) Padded {
+        std::atomic<V> value{0};
+    };
+
+    size_t capacity = 0;
+    size_t mask = 0;
+    std::unique_ptr<Cell[]> cells;
+
+    Padded<size_t> enqueuePos;
+    Padded<size_t> dequeuePos;
+
+    // 等待/唤醒：epoch 每次状态变化递增，仅在有等待者时才调用 notify（避免无谓的系统调用）
+    Padded<uint32_t> itemsEpoch;
+    Padded<uint32_t> consumersWaiting;
+    Padded<uint32_t> slotsEpoch;
+    Padded<uint32_t> producersWaiting;
+
+    static void wake(Padded<uint32_t> &epoch, Padded<uint32_t> &waiting) {
+        epoch.value.fetch_add(1, std::memory_order_seq_cst);
+        if (waiting.value.load(std::memory_order_seq_cst) != 0) epoch.value.notify_one();
+    }
+
+    // 先读取 epoch 再登记等待者并重试，保证 wake 与 wait 之间不会丢失唤醒
+    template<typename F>
+    static void waitFor(Padded<uint32_t> &epoch, Padded<uint32_t> &waiting, F &&tryOnce) {
+        for (;;) {
+            const uint32_t ticket = epoch.value.load(std::memory_order_seq_cst);
+            waiting.value.fetch_add(1, std::memory_order_seq_cst);
+            if (tryOnce()) {
+                waiting.value.fetch_sub(1, std::memory_order_seq_cst);
+                return;
+            }
+            epoch.value.wait(ticket, std::memory_order_seq_cst);
+            waiting.value.fetch_sub(1, std::memory_order_seq_cst);
+            if (tryOnce()) return;
+        }
+    }
 };
 
 #endif // THREAD_SAFE_QUEUE_HPP
@@ -2,9 +2,13 @@
 
 #include "detail/Utils/ConfigReader.hpp"
 #include "detail/Engine/Engine.hpp"
+#include "detail/Engine/EngineNamespaces.hpp"
 #include "detail/MasterSession/MasterSession.hpp"
 #include "detail/Scheduler/Scheduler.hpp"
 #include "detail/Server/Server.hpp"
+#include "detail/Server/UdpQueryServer.hpp"
+#include "detail/Metrics/MetricsServer.hpp"
+#include "detail/HotRestart/HotRestart.hpp"
 
 
 int main(const int argc, char *argv[]) {
@@ -24,18 +28,36 @@ int main(const int argc, char *argv[]) {
     // 读取配置文件
     const std::map<std::string, std::string> config = readConfig(configFilePath);
 
+    // 启动指标端点（未配置 metrics_port 时不启用）
+    MetricsServer metricsServer(config);
+
     // 连接到 Master 服务器
     MasterSession session(config);
 
-    // 启动引擎
+    // 热重启：向正在运行的旧进程请求交接（未配置 hot_restart_socket 或没有旧进程时正常启动）
+    HotRestart hotRestart(config);
+    hotRestart.takeover();
+
+    // 启动引擎（有交接的快照时，调度器初始化引擎时直接还原，不再从日志重建）
     Engine engine(config);
+    engine.setHandoffSnapshot(hotRestart.takeSnapshot());
+
+    // 按签发者划分的命名空间（未配置 engine_namespaces 时所有请求都使用默认引擎）
+    EngineNamespaces namespaces(config, engine);
 
     // 启动调度器
-    Scheduler scheduler(config, session, engine);
+    Scheduler scheduler(config, session, engine, namespaces);
+    hotRestart.attachEngine(engine);
+
+    // 无连接的 UDP 查询端点（未配置 udp_port 时不启用）
+    UdpQueryServer udpServer(config, scheduler, namespaces);
 
     // 启动服务
-    const Server server(config, engine, scheduler);
+    const Server server(config, engine, scheduler, namespaces, hotRestart.enabled() ? &hotRestart : nullptr);
     server.run();
 
+    // 把交接后收到的撤回记录发完再退出
+    hotRestart.stop();
+
     return 0;
 }
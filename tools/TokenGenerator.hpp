@@ -0,0 +1,63 @@
+#ifndef TOKEN_GENERATOR_HPP
+#define TOKEN_GENERATOR_HPP
+
+#include <algorithm>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// token 长度分布，格式：fixed:N | uniform:MIN:MAX | normal:MEAN:STDDEV
+class TokenSizeDistribution {
+public:
+    explicit TokenSizeDistribution(const std::string &spec) {
+        std::vector<std::string> parts;
+        std::istringstream iss(spec);
+        for (std::string part; std::getline(iss, part, ':');) parts.push_back(part);
+        if (parts.empty()) throw std::invalid_argument("Empty token size spec");
+
+        kind = parts[0];
+        if (kind == "fixed" && parts.size() == 2) {
+            a = std::stod(parts[1]);
+        } else if ((kind == "uniform" || kind == "normal") && parts.size() == 3) {
+            a = std::stod(parts[1]);
+            b = std::stod(parts[2]);
+        } else {
+            throw std::invalid_argument("Invalid token size spec: " + spec +
+                                        " (expected fixed:N, uniform:MIN:MAX or normal:MEAN:STDDEV)");
+        }
+    }
+
+    template<typename Rng>
+    size_t operator()(Rng &rng) const {
+        double len = a;
+        if (kind == "uniform") len = std::uniform_real_distribution<double>(a, b)(rng);
+        else if (kind == "normal") len = std::normal_distribution<double>(a, b)(rng);
+        return static_cast<size_t>(std::max(1.0, len));
+    }
+
+private:
+    std::string kind;
+    double a = 0;
+    double b = 0;
+};
+
+// 生成由 base64url 字符组成的随机 token
+template<typename Rng>
+std::string randomToken(Rng &rng, const size_t len) {
+    static constexpr char alphabet[] = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ-_";
+    std::uniform_int_distribution<int> dist(0, 63);
+    std::string token(len, '\0');
+    for (auto &c: token) c = alphabet[dist(rng)];
+    return token;
+}
+
+inline std::vector<std::string> makeTokens(const size_t n, const TokenSizeDistribution &sizes, const unsigned int seed) {
+    std::mt19937_64 rng(seed);
+    std::vector<std::string> tokens(n);
+    for (auto &t: tokens) t = randomToken(rng, sizes(rng));
+    return tokens;
+}
+
+#endif //TOKEN_GENERATOR_HPP
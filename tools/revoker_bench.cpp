@@ -0,0 +1,385 @@
+// 微基准测试：覆盖引擎、哈希、消息编解码与帧收发的热路径
+// 输出格式与 Google Benchmark 的 JSON 兼容（name / iterations / real_time / time_unit），
+// 可直接用 Google Benchmark 的 tools/compare.py 对比两次提交的结果。
+//
+// 用法：revoker_bench [--filter <子串>] [--min-time <秒>] [--repetitions <次数>] [--json <文件>]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "detail/Engine/SHA256/SHA256.h"
+#include "detail/Engine/BaseBloomFilter.hpp"
+#include "detail/Engine/Engine.hpp"
+#if !defined(_WIN32)
+#include "detail/ShmExport/ShmFilterReader.hpp"
+#endif
+#include "detail/Utils/JsonSerializer.hpp"
+#include "detail/Utils/SocketMsgFrame.hpp"
+#include "TokenGenerator.hpp"
+
+// 防止编译器优化掉被测代码的结果
+template<typename T>
+inline void doNotOptimize(const T &value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void *sink;
+    sink = &value;
+#endif
+}
+
+class BenchRunner {
+public:
+    BenchRunner(std::string _filter, const double _minTime, const unsigned int _repetitions)
+        : filter(std::move(_filter)), minTime(_minTime), repetitions(_repetitions) {
+    }
+
+    // 名称是否匹配过滤条件（用于跳过昂贵的准备工作）
+    bool matches(const std::string &prefix) const {
+        return filter.empty() || filter.find(prefix) != std::string::npos || prefix.find(filter) != std::string::npos;
+    }
+
+    // fn(iterations) 执行 iterations 次被测操作
+    void run(const std::string &name, const std::function<void(uint64_t)> &fn) {
+        if (!filter.empty() && name.find(filter) == std::string::npos) return;
+
+        // 校准迭代次数：指数增长，直到单次运行耗时达到 minTime 的 1/10，再按比例放大到 minTime
+        uint64_t iterations = 1;
+        double elapsed = 0;
+        while (true) {
+            elapsed = timeIt(fn, iterations);
+            if (elapsed >= minTime / 10 || iterations >= (1ull << 40)) break;
+            iterations *= 10;
+        }
+        iterations = std::max<uint64_t>(1, static_cast<uint64_t>(static_cast<double>(iterations) * minTime /
+                                                                 std::max(elapsed, 1e-9)));
+
+        // 多次重复取中位数
+        std::vector<double> nsPerOp;
+        for (unsigned int r = 0; r < repetitions; ++r) {
+            nsPerOp.push_back(timeIt(fn, iterations) * 1e9 / static_cast<double>(iterations));
+        }
+        std::sort(nsPerOp.begin(), nsPerOp.end());
+        const double median = nsPerOp[nsPerOp.size() / 2];
+
+        results.push_back({name, iterations, median, nsPerOp.front(), nsPerOp.back()});
+        std::printf("%-48s %14.1f ns/op %14.0f ops/s %12llu iters\n", name.c_str(), median, 1e9 / median,
+                    static_cast<unsigned long long>(iterations));
+        std::fflush(stdout);
+    }
+
+    std::string toJson() const {
+        char date[64];
+        const std::time_t now = std::time(nullptr);
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+        std::string out = "{\n  \"context\": {\n";
+        out += "    \"date\": \"" + std::string(date) + "\",\n";
+        out += "    \"executable\": \"revoker_bench\",\n";
+        out += "    \"num_cpus\": " + std::to_string(std::thread::hardware_concurrency()) + ",\n";
+        out += "    \"repetitions\": " + std::to_string(repetitions) + "\n  },\n";
+        out += "  \"benchmarks\": [\n";
+        char buf[512];
+        for (size_t i = 0; i < results.size(); ++i) {
+            const auto &r = results[i];
+            std::snprintf(buf, sizeof(buf),
+                          "    {\"name\": \"%s\", \"run_name\": \"%s\", \"run_type\": \"iteration\", "
+                          "\"iterations\": %llu, \"real_time\": %.3f, \"cpu_time\": %.3f, \"time_unit\": \"ns\", "
+                          "\"min_time\": %.3f, \"max_time\": %.3f}%s\n",
+                          r.name.c_str(), r.name.c_str(), static_cast<unsigned long long>(r.iterations), r.median,
+                          r.median, r.min, r.max, i + 1 < results.size() ? "," : "");
+            out += buf;
+        }
+        out += "  ]\n}\n";
+        return out;
+    }
+
+private:
+    struct Result {
+        std::string name;
+        uint64_t iterations;
+        double median;
+        double min;
+        double max;
+    };
+
+    std::string filter;
+    double minTime;
+    unsigned int repetitions;
+    std::vector<Result> results;
+
+    static double timeIt(const std::function<void(uint64_t)> &fn, const uint64_t iterations) {
+        const auto start = std::chrono::steady_clock::now();
+        fn(iterations);
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+// 生成 36 字节（形如 JWT jti）的随机 token
+static std::vector<std::string> makeTokens(const size_t n, const unsigned int seed) {
+    return makeTokens(n, TokenSizeDistribution("fixed:36"), seed);
+}
+
+static void benchBloomFilter(BenchRunner &runner) {
+    const auto tokens = makeTokens(1 << 16, 1);
+    const auto absent = makeTokens(1 << 16, 2);
+    const size_t mask = tokens.size() - 1;
+    for (const unsigned int k: {1u, 3u, 5u, 8u}) {
+        BaseBloomFilter filter(1 << 24, k);
+        const std::string suffix = "/m:16777216/k:" + std::to_string(k);
+        runner.run("BaseBloomFilter::add" + suffix, [&](const uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) filter.add(tokens[i & mask]);
+        });
+        runner.run("BaseBloomFilter::contains/hit" + suffix, [&](const uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) doNotOptimize(filter.contains(tokens[i & mask]));
+        });
+        runner.run("BaseBloomFilter::contains/miss" + suffix, [&](const uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) doNotOptimize(filter.contains(absent[i & mask]));
+        });
+    }
+
+    // 轻载窗口：只写入 1024 个 token，仍处于稀疏形式
+    BaseBloomFilter sparse(1 << 24, 5);
+    for (size_t i = 0; i < 1024; ++i) sparse.add(tokens[i]);
+    runner.run("BaseBloomFilter::contains/sparse-hit/m:16777216/k:5", [&](const uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) doNotOptimize(sparse.contains(tokens[i & 1023]));
+    });
+    runner.run("BaseBloomFilter::contains/sparse-miss/m:16777216/k:5", [&](const uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) doNotOptimize(sparse.contains(absent[i & mask]));
+    });
+}
+
+// 同一比特预算（2^24 比特）、同样 3 * 2^18 个元素（布谷鸟装载率 75%）下各窗口实现的查询开销（哈希预先计算）
+static void benchWindowFilters(BenchRunner &runner) {
+    if (!runner.matches("WindowFilter::")) return;
+    constexpr size_t itemNum = 3 << 18;
+    const auto tokens = makeTokens(itemNum, 6);
+    const auto absent = makeTokens(1 << 16, 7);
+    std::vector<BloomHashes> present(1 << 16), missing(1 << 16);
+    std::vector<uint64_t> keys;
+    keys.reserve(itemNum);
+
+    std::vector<std::pair<std::string, std::unique_ptr<WindowFilter> > > filters;
+    WindowFilterOptions options;
+    filters.emplace_back("bloom/k:5", makeWindowFilter(1 << 24, 5, options));
+    options.kind = WindowFilterKind::Cuckoo;
+    filters.emplace_back("cuckoo", makeWindowFilter(1 << 24, 5, options));
+    BloomHashes hashes;
+    for (size_t i = 0; i < itemNum; ++i) {
+        BaseBloomFilter::hashKey(tokens[i], 5, hashes);
+        for (const auto &[name, filter]: filters) filter->add(hashes);
+        keys.push_back(hashes.data()[0]);
+        if (i < present.size()) present[i] = hashes;
+    }
+    for (size_t i = 0; i < missing.size(); ++i) BaseBloomFilter::hashKey(absent[i], 5, missing[i]);
+    filters.emplace_back("binary-fuse", std::make_unique<BinaryFuseFilter>(keys));
+    filters.emplace_back("binary-fuse8", std::make_unique<BinaryFuse8Filter>(keys));
+
+    const size_t mask = present.size() - 1;
+    for (const auto &[name, filter]: filters) {
+        filter->releaseSparse();
+        std::cout << "[Bench] " << name << ": " << filter->getMemoryBytes() << " bytes, estimated fpr " <<
+                filter->getEstimatedFpr() << std::endl;
+        runner.run("WindowFilter::contains/hit/" + name, [&](const uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) doNotOptimize(filter->contains(present[i & mask]));
+        });
+        runner.run("WindowFilter::contains/miss/" + name, [&](const uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) doNotOptimize(filter->contains(missing[i & mask]));
+        });
+    }
+}
+
+static void benchEngine(BenchRunner &runner) {
+    if (!runner.matches("Engine::")) return;
+    const auto tokens = makeTokens(1 << 16, 3);
+    const auto absent = makeTokens(1 << 16, 4);
+    const size_t mask = tokens.size() - 1;
+    const auto hitTokens = makeTokens(1 << 12, 5);
+    const size_t hitMask = hitTokens.size() - 1;
+
+    // 引擎会清理日志目录中的过期文件，使用独立的临时目录
+    const std::filesystem::path logDir = std::filesystem::temp_directory_path() / "revoker_bench_logs";
+    std::filesystem::remove_all(logDir);
+    std::filesystem::create_directories(logDir);
+    const std::map<std::string, std::string> config{{"log_file_path", logDir.string()}};
+
+    constexpr unsigned int rotationInterval = 3600;
+    for (const unsigned int windows: {1u, 6u, 24u, 48u}) {
+        Engine engine(config);
+        engine.init(windows * rotationInterval, rotationInterval, 1 << 22, 5);
+        const std::string suffix = "/windows:" + std::to_string(windows);
+
+        // 过期时间取最大生存时长，撤回与查询都覆盖全部窗口（最坏情况）
+        const time_t expTime = std::time(nullptr) + windows * rotationInterval - 1;
+        runner.run("Engine::revokeJwt" + suffix, [&](const uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) engine.revokeJwt(tokens[i & mask], expTime);
+        });
+        // 命中查询使用预先撤回的小 token 集合，不依赖上面的 revokeJwt 基准是否被过滤掉
+        if (runner.matches("Engine::isRevoked/hit")) {
+            for (size_t i = 0; i < hitTokens.size(); ++i) engine.revokeJwt(hitTokens[i], expTime);
+        }
+        runner.run("Engine::isRevoked/hit" + suffix, [&](const uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) doNotOptimize(engine.isRevoked(hitTokens[i & hitMask], expTime));
+        });
+        runner.run("Engine::isRevoked/miss" + suffix, [&](const uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) doNotOptimize(engine.isRevoked(absent[i & mask], expTime));
+        });
+        runner.run("Engine::rotate" + suffix, [&](const uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) engine.rotate();
+        });
+    }
+    std::filesystem::remove_all(logDir);
+}
+
+#if !defined(_WIN32)
+// 网关进程经共享内存导出直接探测（与 Engine::isRevoked 相同的 24 个窗口、2^22 比特、k = 5）
+static void benchShmReader(BenchRunner &runner) {
+    if (!runner.matches("ShmFilterReader::")) return;
+    const auto tokens = makeTokens(1 << 12, 5);
+    const auto absent = makeTokens(1 << 16, 4);
+    const size_t mask = absent.size() - 1;
+    const size_t hitMask = tokens.size() - 1;
+    const std::string path = (std::filesystem::temp_directory_path() / "revoker_bench_shm").string();
+
+    constexpr unsigned int rotationInterval = 3600;
+    ShmFilterExport shmExport(path, 24 * rotationInterval, rotationInterval, 1 << 22, 5, 24);
+    shmExport.publish();
+    const time_t expTime = std::time(nullptr) + 24 * rotationInterval - 1;
+    for (const auto &token: tokens) shmExport.add(shmTokenHash(token), 24);
+
+    ShmFilterReader reader(path);
+    runner.run("ShmFilterReader::isRevoked/hit/windows:24", [&](const uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) doNotOptimize(reader.isRevoked(tokens[i & hitMask], expTime));
+    });
+    runner.run("ShmFilterReader::isRevoked/miss/windows:24", [&](const uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) doNotOptimize(reader.isRevoked(absent[i & mask], expTime));
+    });
+    shmExport.remove();
+}
+#endif
+
+static void benchSHA256(BenchRunner &runner, const std::string &backend) {
+    for (const size_t len: {static_cast<size_t>(40), static_cast<size_t>(4096)}) {
+        const std::vector<SHA256::BYTE> data(len, 0x5a);
+        SHA256::BYTE digest[SHA256_BLOCK_SIZE];
+        runner.run("SHA256::sha256_update/" + backend + "/bytes:" + std::to_string(len), [&](const uint64_t n) {
+            SHA256::SHA256_CTX ctx;
+            SHA256::sha256_init(&ctx);
+            for (uint64_t i = 0; i < n; ++i) SHA256::sha256_update(&ctx, data.data(), len);
+            SHA256::sha256_final(&ctx, digest);
+            doNotOptimize(digest);
+        });
+        runner.run("SHA256::digest/" + backend + "/bytes:" + std::to_string(len), [&](const uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                SHA256::sha256(data.data(), len, digest);
+                doNotOptimize(digest);
+            }
+        });
+
+        // 每次迭代计算 8 条独立消息的摘要
+        const SHA256::BYTE *batchData[SHA256_MULTI_BUFFER_LANES];
+        size_t batchLen[SHA256_MULTI_BUFFER_LANES];
+        SHA256::BYTE batchDigest[SHA256_MULTI_BUFFER_LANES][SHA256_BLOCK_SIZE];
+        std::fill(std::begin(batchData), std::end(batchData), data.data());
+        std::fill(std::begin(batchLen), std::end(batchLen), len);
+        runner.run("SHA256::batch8/" + backend + "/bytes:" + std::to_string(len), [&](const uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                SHA256::sha256_batch(batchData, batchLen, SHA256_MULTI_BUFFER_LANES, batchDigest);
+                doNotOptimize(batchDigest);
+            }
+        });
+    }
+}
+
+static void benchCodec(BenchRunner &runner) {
+    std::map<std::string, std::string> data;
+    data["token"] = makeTokens(1, 6)[0];
+    data["exp_time"] = "1735689600";
+    const std::string msg = msgAssembly("is_jwt_revoked", data);
+
+    runner.run("msgAssembly/is_jwt_revoked", [&](const uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) doNotOptimize(msgAssembly("is_jwt_revoked", data));
+    });
+    runner.run("msgParse/is_jwt_revoked", [&](const uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            std::string event;
+            std::map<std::string, std::string> parsed;
+            msgParse(msg, event, parsed);
+            doNotOptimize(parsed);
+        }
+    });
+}
+
+// 帧收发：回环 TCP 连接上一次发送 + 一次接收（含系统调用开销）
+static void benchFraming(BenchRunner &runner) {
+    io_context ioc;
+    tcp::acceptor acceptor(ioc, tcp::endpoint(boost::asio::ip::make_address("127.0.0.1"), 0));
+    tcp::socket client(ioc);
+    client.connect(acceptor.local_endpoint());
+    tcp::socket server = acceptor.accept();
+    client.set_option(tcp::no_delay(true));
+
+    for (const size_t len: {static_cast<size_t>(96), static_cast<size_t>(1024)}) {
+        const std::string msg(len, 'x');
+        runner.run("SocketMsgFrame/send+recv/bytes:" + std::to_string(len), [&](const uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                sendMsgToSocket(client, msg);
+                doNotOptimize(recvMsgFromSocket(server));
+            }
+        });
+    }
+}
+
+int main(const int argc, char *argv[]) {
+    std::string filter;
+    double minTime = 0.5;
+    unsigned int repetitions = 3;
+    std::string jsonPath;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "Error: " << arg << " option requires an argument." << std::endl;
+            return 1;
+        }
+        if (arg == "--filter") filter = argv[++i];
+        else if (arg == "--min-time") minTime = std::stod(argv[++i]);
+        else if (arg == "--repetitions") repetitions = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--json") jsonPath = argv[++i];
+        else {
+            std::cerr << "Usage: revoker_bench [--filter <substr>] [--min-time <sec>] [--repetitions <n>] "
+                    "[--json <file>]" << std::endl;
+            return 1;
+        }
+    }
+
+    BenchRunner runner(filter, minTime, repetitions);
+    benchBloomFilter(runner);
+    benchWindowFilters(runner);
+    // 逐个实现运行哈希基准便于对比，其余基准使用自动选择的实现
+    for (const char *backend: {"scalar", "avx2", "sha-ni"}) {
+        if (SHA256::sha256_select_backend(backend)) benchSHA256(runner, backend);
+    }
+    SHA256::sha256_select_backend("auto");
+    benchCodec(runner);
+    benchFraming(runner);
+    benchEngine(runner);
+#if !defined(_WIN32)
+    benchShmReader(runner);
+#endif
+
+    if (!jsonPath.empty()) {
+        std::ofstream(jsonPath) << runner.toJson();
+        std::cout << "Results written to " << jsonPath << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,279 @@
+// 离线快照构建：从撤回日志（log_file_path 下的小时文件）按给定的窗口参数并行重建各窗口，
+// 写出与 Engine::saveSnapshot 相同格式的快照。服务配置 startup_snapshot_path 指向该文件后，
+// 启动时映射并直接还原快照，只重放快照之后的日志，代替逐条重放全部日志。
+//
+// 两个阶段都按核并行：先把日志切成按行对齐的块，各线程解析并计算哈希（SHA256 是主要开销）；
+// 再按窗口分给各线程写入（每个窗口只由一个线程写入，无需加锁）。
+//
+// 用法：revoker_build --log-dir <目录> --out <快照文件> --max-jwt-life-time <秒> --rotation-interval <秒>
+//                     --bloom-filter-size <比特> --hash-function-num <个数>
+//                     [--config <配置文件>] [--threads <线程数>] [--now <Unix 时间戳>]
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "detail/Engine/Engine.hpp"
+#include "detail/Engine/EngineSnapshot.hpp"
+#include "detail/Engine/SubjectIndex.hpp"
+#include "detail/Utils/ConfigReader.hpp"
+#include "detail/Utils/StringParser.hpp"
+
+struct Options {
+    std::vector<std::string> logDirs;
+    std::string outPath;
+    std::string configPath;
+    unsigned int maxJwtLifeTime = 0;
+    unsigned int rotationInterval = 0;
+    size_t bloomFilterSize = 0;
+    unsigned int hashFunctionNum = 0;
+    unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+    time_t now = 0;
+};
+
+// 一个按行对齐的日志块的解析结果：token 记录（指向日志内容）、每条记录 baseHashNum 个原始哈希值与主体记录
+struct Shard {
+    std::string_view data;
+    std::vector<std::pair<std::string_view, uint32_t> > records; // token、需要写入的窗口数
+    std::vector<uint64_t> hashes;
+    std::vector<std::tuple<uint64_t, time_t, time_t> > subjects;
+    size_t expired = 0;
+    size_t invalid = 0;
+};
+
+class SnapshotBuilder {
+public:
+    explicit SnapshotBuilder(const Options &_opt) : opt(_opt) {
+        if (!opt.configPath.empty()) config = readConfig(opt.configPath);
+        filterOptions = parseWindowFilterOptions(config);
+        hashNum = baseHashNum(filterOptions, opt.hashFunctionNum);
+        filtersNum = ceilDiv(opt.maxJwtLifeTime, opt.rotationInterval);
+    }
+
+    int run() {
+        const auto start = std::chrono::steady_clock::now();
+        loadLogs();
+        const auto loaded = std::chrono::steady_clock::now();
+        parseAndHash();
+        const auto hashed = std::chrono::steady_clock::now();
+        fillWindows();
+        const auto filled = std::chrono::steady_clock::now();
+        const size_t snapshotBytes = writeSnapshot();
+        const auto written = std::chrono::steady_clock::now();
+
+        size_t records = 0, expired = 0, invalid = 0;
+        for (const auto &shard: shards) {
+            records += shard.records.size();
+            expired += shard.expired;
+            invalid += shard.invalid;
+        }
+        const auto seconds = [](const auto from, const auto to) { return std::chrono::duration<double>(to - from).count(); };
+        std::printf("[Build] %zu log file(s), %.1f MBytes, %zu chunk(s), %u thread(s)\n", files.size(),
+                    static_cast<double>(logBytes) / 1048576, shards.size(), opt.threads);
+        std::printf("[Build] %zu live token record(s), %zu expired or out of range, %zu invalid line(s), %zu subject(s)\n",
+                    records, expired, invalid, subjects.size());
+        std::printf("[Build] read %.3f s, parse+hash %.3f s, fill %u windows %.3f s, write %.3f s\n",
+                    seconds(start, loaded), seconds(loaded, hashed), filtersNum, seconds(hashed, filled),
+                    seconds(filled, written));
+        std::printf("[Build] Wrote %s (%.1f MBytes, saved at %lld)\n", opt.outPath.c_str(),
+                    static_cast<double>(snapshotBytes) / 1048576, static_cast<long long>(opt.now));
+        return 0;
+    }
+
+private:
+    static constexpr size_t CHUNK_BYTES = 4 << 20;
+
+    const Options &opt;
+    std::map<std::string, std::string> config;
+    WindowFilterOptions filterOptions;
+    unsigned int hashNum = 0;
+    unsigned int filtersNum = 0;
+
+    std::vector<std::string> files; // 日志内容，解析结果中的 token 指向这里
+    size_t logBytes = 0;
+    std::vector<Shard> shards;
+    std::vector<std::unique_ptr<WindowFilter> > filters;
+    SubjectIndex subjects;
+
+    // 读入目录下所有的日志文件，再切成按行对齐的块
+    void loadLogs() {
+        for (const auto &dir: opt.logDirs) {
+            for (const auto &entry: std::filesystem::directory_iterator(dir)) {
+                if (!entry.is_regular_file() || entry.path().extension() != ".txt") continue;
+                std::ifstream file(entry.path(), std::ios::binary);
+                if (!file.is_open()) throw std::runtime_error("Cannot open log file: " + entry.path().string());
+                files.emplace_back(std::istreambuf_iterator(file), std::istreambuf_iterator<char>());
+                logBytes += files.back().size();
+            }
+        }
+        for (const auto &content: files) {
+            std::string_view rest(content);
+            while (!rest.empty()) {
+                size_t end = std::min(CHUNK_BYTES, rest.size());
+                if (end < rest.size()) {
+                    const size_t newline = rest.find('\n', end);
+                    end = newline == std::string_view::npos ? rest.size() : newline + 1;
+                }
+                shards.emplace_back().data = rest.substr(0, end);
+                rest.remove_prefix(end);
+            }
+        }
+    }
+
+    // 按核并行执行 fn(i)，i 取遍 [0, n)，由各线程按顺序领取
+    void parallelFor(const size_t n, const std::function<void(size_t)> &fn) const {
+        std::atomic<size_t> next{0};
+        std::vector<std::thread> workers;
+        for (unsigned int t = 0; t < std::min<size_t>(opt.threads, n); ++t) {
+            workers.emplace_back([&] {
+                for (size_t i = next.fetch_add(1); i < n; i = next.fetch_add(1)) fn(i);
+            });
+        }
+        for (auto &worker: workers) worker.join();
+    }
+
+    // 与 Engine::recoverFromLog 相同的规则：跳过已过期与超出最大生存时长的记录，主体记录保留到 before + maxJwtLifeTime
+    void parseAndHash() {
+        parallelFor(shards.size(), [this](const size_t index) {
+            Shard &shard = shards[index];
+            BloomHashes hashes;
+            std::string token, issuer, subject;
+            std::string_view rest = shard.data;
+            while (!rest.empty()) {
+                const size_t newline = rest.find('\n');
+                std::string_view line = rest.substr(0, newline);
+                rest.remove_prefix(newline == std::string_view::npos ? rest.size() : newline + 1);
+                if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+                if (line.empty()) continue;
+
+                if (line.starts_with('!')) {
+                    if (time_t before; parseSubjectRecord(line, issuer, subject, before)) {
+                        const time_t expireAt = before + static_cast<time_t>(opt.maxJwtLifeTime);
+                        if (expireAt > opt.now) {
+                            shard.subjects.emplace_back(SubjectIndex::subjectKey(issuer, subject), before, expireAt);
+                        } else {
+                            ++shard.expired;
+                        }
+                    } else {
+                        ++shard.invalid;
+                    }
+                    continue;
+                }
+
+                const size_t comma = line.rfind(',');
+                long long expTime = 0;
+                if (comma == std::string_view::npos || comma == 0 ||
+                    std::from_chars(line.data() + comma + 1, line.data() + line.size(), expTime).ec != std::errc()) {
+                    ++shard.invalid;
+                    continue;
+                }
+                const time_t remainingTime = static_cast<time_t>(expTime) - opt.now;
+                if (remainingTime <= 0 || remainingTime > static_cast<time_t>(opt.maxJwtLifeTime)) {
+                    ++shard.expired;
+                    continue;
+                }
+                const unsigned int num = ceilDiv(remainingTime, opt.rotationInterval);
+                if (num > filtersNum) {
+                    ++shard.expired;
+                    continue;
+                }
+
+                token.assign(line.substr(0, comma));
+                BaseBloomFilter::hashKey(token, hashNum, hashes);
+                shard.records.emplace_back(line.substr(0, comma), num);
+                shard.hashes.insert(shard.hashes.end(), hashes.data(), hashes.data() + hashNum);
+            }
+        });
+
+        for (const auto &shard: shards) {
+            for (const auto &[key, before, expireAt]: shard.subjects) subjects.revoke(key, before, expireAt);
+        }
+    }
+
+    // 第 i 个窗口写入所有 num > i 的记录；窗口 0 最重，最先领取
+    void fillWindows() {
+        filters = getNewFilters(filtersNum, opt.bloomFilterSize, opt.hashFunctionNum, filterOptions);
+        parallelFor(filtersNum, [this](const size_t window) {
+            WindowFilter &filter = *filters[window];
+            BloomHashes hashes;
+            std::string token;
+            for (const auto &shard: shards) {
+                for (size_t r = 0; r < shard.records.size(); ++r) {
+                    const auto &[tokenView, num] = shard.records[r];
+                    if (num <= window) continue;
+                    // 追加了子过滤器的窗口需要更多的哈希值时补算
+                    if (const unsigned int required = filter.requiredHashNum(); required > hashNum) {
+                        token.assign(tokenView);
+                        BaseBloomFilter::hashKey(token, required, hashes);
+                    } else {
+                        std::memcpy(hashes.resize(hashNum), shard.hashes.data() + r * hashNum, hashNum * sizeof(uint64_t));
+                    }
+                    filter.add(hashes);
+                }
+            }
+        });
+    }
+
+    size_t writeSnapshot() const {
+        std::string out;
+        serializeEngineSnapshot(out, opt.hashFunctionNum, opt.maxJwtLifeTime, opt.rotationInterval, opt.bloomFilterSize,
+                                opt.now, filters, [this](auto &&fn) { subjects.forEach(fn); });
+        writeSnapshotFile(opt.outPath, out);
+        return out.size();
+    }
+};
+
+int main(const int argc, char *argv[]) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "Error: " << arg << " option requires an argument." << std::endl;
+            return 1;
+        }
+        const std::string value = argv[++i];
+        if (arg == "--log-dir") opt.logDirs.push_back(value);
+        else if (arg == "--out") opt.outPath = value;
+        else if (arg == "--config") opt.configPath = value;
+        else if (arg == "--max-jwt-life-time") opt.maxJwtLifeTime = stringToUInt(value);
+        else if (arg == "--rotation-interval") opt.rotationInterval = stringToUInt(value);
+        else if (arg == "--bloom-filter-size") opt.bloomFilterSize = stringToSizeT(value);
+        else if (arg == "--hash-function-num") opt.hashFunctionNum = stringToUInt(value);
+        else if (arg == "--threads") opt.threads = std::max(1u, stringToUInt(value));
+        else if (arg == "--now") opt.now = static_cast<time_t>(std::stoll(value));
+        else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (opt.logDirs.empty() || opt.outPath.empty() || opt.maxJwtLifeTime == 0 || opt.rotationInterval == 0 ||
+        opt.bloomFilterSize == 0 || opt.hashFunctionNum == 0) {
+        std::cerr << "Error: --log-dir, --out, --max-jwt-life-time, --rotation-interval, --bloom-filter-size and "
+                "--hash-function-num are required." << std::endl;
+        return 1;
+    }
+    // 快照的保存时刻：服务启动时按它淘汰之后经过的窗口，并只重放它所在小时及之后的日志
+    if (opt.now == 0) opt.now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+
+    try {
+        SnapshotBuilder builder(opt);
+        return builder.run();
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
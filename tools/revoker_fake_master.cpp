@@ -0,0 +1,334 @@
+// 本地 master 替身：完成节点认证与默认配置下发，并按脚本注入 revoke_jwt / adjust_bloom_filter 风暴，
+// 用于在没有真实集群的情况下压测节点、测量角色切换停顿（配合 revoker_loadgen --timeline 使用）。
+//
+// 用法：revoker_fake_master [--port 9999] [--script <文件>] [--max-jwt-life-time 86400]
+//                           [--rotation-interval 3600] [--bloom-filter-size 8388608]
+//                           [--hash-function-num 5] [--reject-auth] [--verbose]
+//
+// 脚本命令（每行一条，# 开头为注释；未指定 --script 时从标准输入读取）：
+//   wait <秒>
+//   wait_nodes <个数>                                  等待指定数量的节点完成认证
+//   revoke_storm <条数> <速率/秒> [token长度分布] [最大剩余寿命秒]
+//   revoke_subject <sub> [iss] [revoked_before]       按主体批量撤回，revoked_before 默认为当前时间
+//   adjust single_node|proxy_node <max_jwt_life_time> <rotation_interval> <bloom_filter_size> <hash_function_num>
+//   adjust slave_node <proxy_node_host> <proxy_node_port>
+//   nodes                                              列出已连接的节点
+//   quit
+
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/asio.hpp>
+
+#include "detail/Server/CoroutineSafeQueue.hpp"
+#include "detail/Utils/JsonSerializer.hpp"
+#include "detail/Utils/SocketMsgFrame.hpp"
+#include "detail/Utils/StringParser.hpp"
+#include "TokenGenerator.hpp"
+
+using boost::asio::io_context;
+using boost::asio::awaitable;
+using boost::asio::use_awaitable;
+using boost::asio::ip::tcp;
+using Clock = std::chrono::steady_clock;
+
+struct MasterOptions {
+    unsigned short port = 9999;
+    std::string scriptPath;
+    std::string maxJwtLifeTime = "86400";
+    std::string rotationInterval = "3600";
+    std::string bloomFilterSize = "8388608";
+    std::string hashFunctionNum = "5";
+    bool rejectAuth = false;
+    bool verbose = false;
+};
+
+class FakeMaster {
+public:
+    explicit FakeMaster(MasterOptions _opt) : opt(std::move(_opt)) {
+    }
+
+    int run() {
+        tcp::acceptor acceptor(ioc, tcp::endpoint(tcp::v4(), opt.port));
+        std::cout << "[FakeMaster] Listening at: " << acceptor.local_endpoint() << std::endl;
+        co_spawn(ioc, listener(acceptor), boost::asio::detached);
+
+        auto work = boost::asio::make_work_guard(ioc);
+        std::thread ioThread([this] { ioc.run(); });
+        runScript();
+        work.reset();
+        ioc.stop();
+        ioThread.join();
+        return 0;
+    }
+
+private:
+    struct Node {
+        explicit Node(io_context &ioc, tcp::socket _sock) : sock(std::move(_sock)), sendQueue(ioc) {
+        }
+
+        tcp::socket sock;
+        CoroutineSafeQueue<std::string> sendQueue;
+        std::string uid;
+        bool authenticated = false;
+    };
+
+    struct PendingAdjust {
+        Clock::time_point sentAt;
+        std::string role;
+    };
+
+    MasterOptions opt;
+    io_context ioc{1};
+    std::list<std::shared_ptr<Node> > nodes; // 仅在 io 线程中访问
+    std::map<std::string, PendingAdjust> pendingAdjusts;
+    std::mt19937_64 rng{std::random_device{}()};
+
+    awaitable<void> listener(tcp::acceptor &acceptor) {
+        while (true) {
+            tcp::socket sock = co_await acceptor.async_accept(use_awaitable);
+            auto node = std::make_shared<Node>(ioc, std::move(sock));
+            nodes.push_back(node);
+            co_spawn(ioc, handleNode(node), boost::asio::detached);
+        }
+    }
+
+    awaitable<void> handleNode(const std::shared_ptr<Node> node) {
+        const auto remoteEndpoint = node->sock.remote_endpoint();
+        std::cout << "[FakeMaster] Node connected: " << remoteEndpoint << std::endl;
+
+        boost::asio::steady_timer writerDone(ioc, Clock::time_point::max());
+        bool writerRunning = true;
+        co_spawn(ioc, [node]() -> awaitable<void> {
+            while (true) co_await asyncSendMsgToSocket(node->sock, co_await node->sendQueue.dequeue());
+        }, [&](const std::exception_ptr &) {
+            boost::system::error_code ec;
+            node->sock.close(ec);
+            writerRunning = false;
+            writerDone.cancel();
+        });
+
+        try {
+            while (true) handleNodeMsg(*node, co_await asyncRecvMsgFromSocket(node->sock));
+        } catch (const std::exception &e) {
+            std::cout << "[FakeMaster] Node disconnected: " << remoteEndpoint << " (" << e.what() << ")" << std::endl;
+        }
+
+        boost::system::error_code ec;
+        node->sock.close(ec);
+        node->sendQueue.close();
+        if (writerRunning) co_await writerDone.async_wait(boost::asio::redirect_error(use_awaitable, ec));
+        nodes.remove(node);
+    }
+
+    void handleNodeMsg(Node &node, const std::string &msg) {
+        std::string event;
+        std::map<std::string, std::string> data;
+        msgParse(msg, event, data);
+
+        if (event == "hello_from_client") {
+            node.uid = data["client_uid"];
+            node.authenticated = !opt.rejectAuth;
+            node.sendQueue.enqueue(msgAssembly(opt.rejectAuth ? "auth_failed" : "auth_success", {}));
+            std::cout << "[FakeMaster] Node " << node.uid << (opt.rejectAuth ? " rejected" : " authenticated") <<
+                    std::endl;
+            return;
+        }
+        if (event == "get_bloom_filter_default_config") {
+            std::map<std::string, std::string> config;
+            config["max_jwt_life_time"] = opt.maxJwtLifeTime;
+            config["rotation_interval"] = opt.rotationInterval;
+            config["bloom_filter_size"] = opt.bloomFilterSize;
+            config["hash_function_num"] = opt.hashFunctionNum;
+            node.sendQueue.enqueue(msgAssembly("bloom_filter_default_config", config));
+            return;
+        }
+        if (event == "adjust_bloom_filter_done") {
+            const auto it = pendingAdjusts.find(data["uuid"]);
+            if (it == pendingAdjusts.end()) return;
+            const auto elapsed = std::chrono::duration<double, std::milli>(Clock::now() - it->second.sentAt).count();
+            std::cout << "[FakeMaster] Node " << node.uid << " switched to " << it->second.role << " in " << elapsed
+                    << " ms" << std::endl;
+            return;
+        }
+        if (opt.verbose) std::cout << "[FakeMaster] " << node.uid << " -> " << msg << std::endl;
+    }
+
+    // 向所有已认证节点广播
+    void broadcast(const std::string &msg) {
+        for (const auto &node: nodes) { if (node->authenticated) node->sendQueue.enqueue(msg); }
+    }
+
+    // 按速率注入 revoke_jwt：每 1ms 补发到期应发的条数
+    awaitable<void> revokeStorm(const size_t count, const double rate, const TokenSizeDistribution sizes,
+                                const unsigned int maxLife) {
+        boost::asio::steady_timer timer(ioc);
+        const auto begin = Clock::now();
+        size_t sent = 0;
+        while (sent < count) {
+            const double elapsed = std::chrono::duration<double>(Clock::now() - begin).count();
+            const size_t due = std::min(count, static_cast<size_t>(elapsed * rate) + 1);
+            const auto now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+            for (; sent < due; ++sent) {
+                std::map<std::string, std::string> data;
+                data["token"] = randomToken(rng, sizes(rng));
+                data["exp_time"] = std::to_string(now + std::uniform_int_distribution<unsigned int>(1, maxLife)(rng));
+                broadcast(msgAssembly("revoke_jwt", data));
+            }
+            timer.expires_after(std::chrono::milliseconds(1));
+            co_await timer.async_wait(use_awaitable);
+        }
+        std::cout << "[FakeMaster] Revoke storm done: " << count << " messages in " <<
+                std::chrono::duration<double>(Clock::now() - begin).count() << " s" << std::endl;
+    }
+
+    void adjust(const std::vector<std::string> &args) {
+        std::map<std::string, std::string> data;
+        const std::string &role = args[1];
+        data["node_role"] = role;
+        if (role == "slave_node" && args.size() == 4) {
+            data["proxy_node_host"] = args[2];
+            data["proxy_node_port"] = args[3];
+        } else if ((role == "single_node" || role == "proxy_node") && args.size() == 6) {
+            data["max_jwt_life_time"] = args[2];
+            data["rotation_interval"] = args[3];
+            data["bloom_filter_size"] = args[4];
+            data["hash_function_num"] = args[5];
+        } else {
+            std::cerr << "[FakeMaster] Invalid adjust command" << std::endl;
+            return;
+        }
+        // 每个节点使用独立的 uuid，以便分别统计切换耗时
+        for (const auto &node: nodes) {
+            if (!node->authenticated) continue;
+            data["uuid"] = randomToken(rng, 32);
+            pendingAdjusts[data["uuid"]] = {Clock::now(), role};
+            node->sendQueue.enqueue(msgAssembly("adjust_bloom_filter", data));
+        }
+    }
+
+    // 在 io 线程中执行并等待完成
+    template<typename F>
+    void runOnIo(F &&fn) {
+        std::promise<void> done;
+        boost::asio::post(ioc, [&] {
+            fn();
+            done.set_value();
+        });
+        done.get_future().get();
+    }
+
+    size_t authenticatedNodes() {
+        size_t n = 0;
+        runOnIo([&] { for (const auto &node: nodes) n += node->authenticated; });
+        return n;
+    }
+
+    void runScript() {
+        std::ifstream file;
+        if (!opt.scriptPath.empty()) {
+            file.open(opt.scriptPath);
+            if (!file.is_open()) {
+                std::cerr << "[FakeMaster] Failed to open script: " << opt.scriptPath << std::endl;
+                return;
+            }
+        }
+        std::istream &in = opt.scriptPath.empty() ? std::cin : file;
+
+        std::string line;
+        while (std::getline(in, line)) {
+            std::istringstream iss(line);
+            std::vector<std::string> args;
+            for (std::string arg; iss >> arg;) args.push_back(arg);
+            if (args.empty() || args[0][0] == '#') continue;
+            const std::string &cmd = args[0];
+
+            try {
+                if (cmd == "quit") break;
+                if (cmd == "wait" && args.size() == 2) {
+                    std::this_thread::sleep_for(std::chrono::duration<double>(std::stod(args[1])));
+                } else if (cmd == "wait_nodes" && args.size() == 2) {
+                    while (authenticatedNodes() < stringToSizeT(args[1])) {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                    }
+                } else if (cmd == "revoke_storm" && args.size() >= 3) {
+                    const TokenSizeDistribution sizes(args.size() > 3 ? args[3] : "fixed:36");
+                    const unsigned int maxLife = args.size() > 4 ? stringToUInt(args[4]) : 3600;
+                    std::promise<void> done;
+                    co_spawn(ioc, revokeStorm(stringToSizeT(args[1]), std::stod(args[2]), sizes, std::max(1u, maxLife)),
+                             [&](const std::exception_ptr &) { done.set_value(); });
+                    done.get_future().get();
+                } else if (cmd == "revoke_subject" && args.size() >= 2 && args.size() <= 4) {
+                    std::map<std::string, std::string> data;
+                    data["sub"] = args[1];
+                    data["iss"] = args.size() > 2 ? args[2] : "";
+                    data["revoked_before"] = args.size() > 3
+                                                 ? args[3]
+                                                 : std::to_string(std::chrono::system_clock::to_time_t(
+                                                     std::chrono::system_clock::now()));
+                    runOnIo([&] { broadcast(msgAssembly("revoke_subject", data)); });
+                } else if (cmd == "adjust" && args.size() >= 2) {
+                    runOnIo([&] { adjust(args); });
+                } else if (cmd == "nodes") {
+                    runOnIo([&] {
+                        for (const auto &node: nodes) {
+                            std::cout << "[FakeMaster] " << node->uid << " "
+                                    << (node->authenticated ? "authenticated" : "pending") << std::endl;
+                        }
+                    });
+                } else {
+                    std::cerr << "[FakeMaster] Unknown command: " << line << std::endl;
+                }
+            } catch (const std::exception &e) {
+                std::cerr << "[FakeMaster] Command failed: " << line << " (" << e.what() << ")" << std::endl;
+            }
+        }
+    }
+};
+
+int main(const int argc, char *argv[]) {
+    MasterOptions opt;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--reject-auth") {
+            opt.rejectAuth = true;
+            continue;
+        }
+        if (arg == "--verbose") {
+            opt.verbose = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Error: " << arg << " option requires an argument." << std::endl;
+            return 1;
+        }
+        const std::string value = argv[++i];
+        if (arg == "--port") opt.port = stringToUShort(value);
+        else if (arg == "--script") opt.scriptPath = value;
+        else if (arg == "--max-jwt-life-time") opt.maxJwtLifeTime = value;
+        else if (arg == "--rotation-interval") opt.rotationInterval = value;
+        else if (arg == "--bloom-filter-size") opt.bloomFilterSize = value;
+        else if (arg == "--hash-function-num") opt.hashFunctionNum = value;
+        else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    try {
+        FakeMaster master(opt);
+        return master.run();
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,393 @@
+// 协议级压测工具：按网关的方式驱动 Server（4 字节长度前缀 + JSON）
+//
+// 开环模式（--mode open）：按固定速率调度请求，延迟从“计划发送时刻”开始计算，
+//   发送端落后时延迟照样计入，天然修正协调遗漏（coordinated omission）。
+// 闭环模式（--mode closed）：每个连接收到回执后才发下一个请求；指定 --rate 时按
+//   期望间隔补记被遗漏的样本（与 HdrHistogram 的 recordValueWithExpectedInterval 相同）。
+//
+// 用法：revoker_loadgen [--host 127.0.0.1] [--port 8888] [--mode open|closed] [--rate 10000]
+//                       [--connections 4] [--threads 1] [--duration 10] [--revoke-ratio 0.01]
+//                       [--tokens 100000] [--token-size fixed:36] [--max-life 3600]
+//                       [--drain-timeout 2] [--deadline-ms 0] [--timeline] [--json <文件>] [--seed 1]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/asio.hpp>
+
+#include "detail/Utils/JsonSerializer.hpp"
+#include "detail/Utils/SocketMsgFrame.hpp"
+#include "detail/Utils/StringParser.hpp"
+#include "TokenGenerator.hpp"
+
+using boost::asio::io_context;
+using boost::asio::awaitable;
+using boost::asio::use_awaitable;
+using boost::asio::ip::tcp;
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::string host = "127.0.0.1";
+    std::string port = "8888";
+    std::string mode = "open";
+    double rate = 10000; // 所有连接合计的请求速率（次/秒），闭环模式下为 0 表示不限速
+    unsigned int connections = 4;
+    unsigned int threads = 1;
+    double duration = 10;
+    double revokeRatio = 0.0;
+    size_t tokens = 100000;
+    std::string tokenSize = "fixed:36";
+    unsigned int maxLife = 3600;
+    double drainTimeout = 2;
+    unsigned int deadlineMs = 0; // 查询携带的截止时刻 = 发送时刻 + deadlineMs（0 表示不携带）
+    bool timeline = false;
+    std::string jsonPath;
+    unsigned int seed = 1;
+};
+
+// 单个连接的统计（只在该连接的 strand 上访问）
+struct ConnStats {
+    struct Sample {
+        uint32_t second; // 完成时刻（相对压测开始）
+        uint64_t latencyNs;
+    };
+
+    std::vector<Sample> samples;
+    uint64_t queries = 0;
+    uint64_t revokes = 0;
+    uint64_t responses = 0;
+    uint64_t revoked = 0;
+    uint64_t retried = 0; // Server 过载或请求超时时回复的 retry
+    uint64_t unexpected = 0;
+    uint64_t timeouts = 0;
+    uint64_t errors = 0;
+};
+
+class LoadGenerator {
+public:
+    explicit LoadGenerator(Options _opt) : opt(std::move(_opt)),
+                                           tokens(makeTokens(opt.tokens, TokenSizeDistribution(opt.tokenSize),
+                                                             opt.seed)),
+                                           stats(opt.connections) {
+    }
+
+    int run() {
+        io_context ioc(static_cast<int>(opt.threads));
+        tcp::resolver resolver(ioc);
+        endpoints = resolver.resolve(opt.host, opt.port);
+
+        start = Clock::now() + std::chrono::milliseconds(100); // 预留建立连接的时间
+        end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(opt.duration));
+        for (unsigned int i = 0; i < opt.connections; ++i) {
+            co_spawn(make_strand(ioc), connection(i), [this, i](const std::exception_ptr &e) {
+                if (!e) return;
+                try { std::rethrow_exception(e); } catch (const std::exception &ex) {
+                    std::cerr << "[loadgen] connection " << i << " failed: " << ex.what() << std::endl;
+                    stats[i].errors++;
+                }
+            });
+        }
+
+        std::vector<std::thread> workers;
+        for (unsigned int i = 1; i < opt.threads; ++i) workers.emplace_back([&ioc] { ioc.run(); });
+        ioc.run();
+        for (auto &w: workers) w.join();
+
+        report();
+        return 0;
+    }
+
+private:
+    Options opt;
+    std::vector<std::string> tokens;
+    std::vector<ConnStats> stats;
+    tcp::resolver::results_type endpoints;
+    Clock::time_point start;
+    Clock::time_point end;
+
+    awaitable<void> connection(const unsigned int id) {
+        const auto executor = co_await boost::asio::this_coro::executor;
+        tcp::socket sock(executor);
+        co_await boost::asio::async_connect(sock, endpoints, use_awaitable);
+        sock.set_option(tcp::no_delay(true));
+
+        std::mt19937_64 rng(opt.seed * 7919 + id);
+        if (opt.mode == "open") co_await openLoop(sock, id, rng);
+        else co_await closedLoop(sock, id, rng);
+    }
+
+    // 随机选择下一个请求：撤回或查询
+    std::string nextRequest(std::mt19937_64 &rng, bool &isRevoke) const {
+        const std::string &token = tokens[std::uniform_int_distribution<size_t>(0, tokens.size() - 1)(rng)];
+        const auto now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+        std::map<std::string, std::string> data;
+        data["token"] = token;
+        data["exp_time"] = std::to_string(now + std::uniform_int_distribution<unsigned int>(1, opt.maxLife)(rng));
+        isRevoke = std::uniform_real_distribution<double>(0, 1)(rng) < opt.revokeRatio;
+        if (!isRevoke && opt.deadlineMs > 0) {
+            data["deadline_ms"] = std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                                     std::chrono::system_clock::now().time_since_epoch()).count() + opt.deadlineMs);
+        }
+        return msgAssembly(isRevoke ? "revoke_jwt" : "is_jwt_revoked", data);
+    }
+
+    void record(ConnStats &st, const Clock::time_point intended, const Clock::time_point done) const {
+        const auto second = std::chrono::duration_cast<std::chrono::seconds>(done - start).count();
+        const auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(done - intended).count();
+        st.samples.push_back({static_cast<uint32_t>(std::max<long long>(0, second)),
+                              static_cast<uint64_t>(std::max<long long>(0, latency))});
+    }
+
+    void countResponse(ConnStats &st, const std::string &msg) const {
+        std::string event;
+        std::map<std::string, std::string> data;
+        msgParse(msg, event, data);
+        if (event != "is_jwt_revoked_response") {
+            st.unexpected++;
+            return;
+        }
+        st.responses++;
+        if (data["status"] == "revoked") st.revoked++;
+        else if (data["status"] == "retry") st.retried++;
+    }
+
+    // 开环：发送协程按计划时刻发送，接收协程按 FIFO 匹配回执（Server 对同一连接按序处理）
+    awaitable<void> openLoop(tcp::socket &sock, const unsigned int id, std::mt19937_64 &rng) {
+        ConnStats &st = stats[id];
+        const auto executor = co_await boost::asio::this_coro::executor;
+        std::deque<Clock::time_point> inflight;
+        bool receiverDone = false;
+        boost::asio::steady_timer receiverExit(executor, Clock::time_point::max());
+
+        co_spawn(executor, [&]() -> awaitable<void> {
+            while (true) {
+                const std::string msg = co_await asyncRecvMsgFromSocket(sock);
+                const auto now = Clock::now();
+                if (inflight.empty()) {
+                    st.unexpected++;
+                    continue;
+                }
+                record(st, inflight.front(), now);
+                inflight.pop_front();
+                countResponse(st, msg);
+            }
+        }, [&](const std::exception_ptr &) {
+            receiverDone = true;
+            receiverExit.cancel();
+        });
+
+        // 每个连接分摊总速率，起始时刻错开，避免所有连接同时发送
+        const auto interval = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(opt.connections / opt.rate));
+        auto next = start + interval * id / opt.connections;
+        boost::asio::steady_timer timer(executor);
+        try {
+            while (next < end && !receiverDone) {
+                timer.expires_at(next);
+                co_await timer.async_wait(use_awaitable);
+                bool isRevoke = false;
+                const std::string req = nextRequest(rng, isRevoke);
+                if (isRevoke) {
+                    st.revokes++;
+                } else {
+                    st.queries++;
+                    inflight.push_back(next);
+                }
+                co_await asyncSendMsgToSocket(sock, req);
+                next += interval;
+            }
+        } catch (const std::exception &e) {
+            st.errors++;
+            std::cerr << "[loadgen] send error: " << e.what() << std::endl;
+        }
+
+        // 等待未完成的请求，超时后计为超时
+        const auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                  std::chrono::duration<double>(opt.drainTimeout));
+        while (!inflight.empty() && !receiverDone && Clock::now() < deadline) {
+            timer.expires_after(std::chrono::milliseconds(1));
+            co_await timer.async_wait(use_awaitable);
+        }
+        st.timeouts += inflight.size();
+
+        boost::system::error_code ec;
+        sock.close(ec);
+        if (!receiverDone) co_await receiverExit.async_wait(boost::asio::redirect_error(use_awaitable, ec));
+    }
+
+    // 闭环：一问一答；撤回请求没有回执，直接发送
+    awaitable<void> closedLoop(tcp::socket &sock, const unsigned int id, std::mt19937_64 &rng) {
+        ConnStats &st = stats[id];
+        const auto executor = co_await boost::asio::this_coro::executor;
+        const bool paced = opt.rate > 0;
+        const auto interval = paced
+                                  ? std::chrono::duration_cast<Clock::duration>(
+                                      std::chrono::duration<double>(opt.connections / opt.rate))
+                                  : Clock::duration::zero();
+        boost::asio::steady_timer timer(executor);
+        auto next = start;
+        try {
+            timer.expires_at(start);
+            co_await timer.async_wait(use_awaitable);
+            while (Clock::now() < end) {
+                bool isRevoke = false;
+                const std::string req = nextRequest(rng, isRevoke);
+                if (isRevoke) {
+                    st.revokes++;
+                    co_await asyncSendMsgToSocket(sock, req);
+                    continue;
+                }
+                st.queries++;
+                const auto sent = Clock::now();
+                co_await asyncSendMsgToSocket(sock, req);
+                const std::string resp = co_await asyncRecvMsgFromSocket(sock);
+                const auto done = Clock::now();
+                record(st, sent, done);
+                countResponse(st, resp);
+
+                if (!paced) continue;
+                // 协调遗漏修正：单次延迟超过期望间隔时，补记那些本应在等待期间发出的请求的延迟
+                const auto latency = done - sent;
+                for (auto missed = latency - interval; missed > Clock::duration::zero(); missed -= interval) {
+                    record(st, done - missed, done);
+                }
+                next += interval;
+                if (next < done) next = done;
+                timer.expires_at(next);
+                co_await timer.async_wait(use_awaitable);
+            }
+        } catch (const std::exception &e) {
+            st.errors++;
+            std::cerr << "[loadgen] connection error: " << e.what() << std::endl;
+        }
+        boost::system::error_code ec;
+        sock.close(ec);
+    }
+
+    static uint64_t percentile(const std::vector<uint64_t> &sorted, const double q) {
+        if (sorted.empty()) return 0;
+        const auto idx = static_cast<size_t>(q * static_cast<double>(sorted.size() - 1) + 0.5);
+        return sorted[std::min(idx, sorted.size() - 1)];
+    }
+
+    void report() const {
+        ConnStats total;
+        std::vector<uint64_t> latencies;
+        std::map<uint32_t, std::vector<uint64_t> > perSecond;
+        for (const auto &st: stats) {
+            total.queries += st.queries;
+            total.revokes += st.revokes;
+            total.responses += st.responses;
+            total.revoked += st.revoked;
+            total.retried += st.retried;
+            total.unexpected += st.unexpected;
+            total.timeouts += st.timeouts;
+            total.errors += st.errors;
+            for (const auto &s: st.samples) {
+                latencies.push_back(s.latencyNs);
+                if (opt.timeline) perSecond[s.second].push_back(s.latencyNs);
+            }
+        }
+        std::sort(latencies.begin(), latencies.end());
+
+        const bool corrected = opt.mode == "open" || opt.rate > 0;
+        std::printf("mode: %s%s, connections: %u, threads: %u, duration: %.1fs, target rate: %.0f/s\n",
+                    opt.mode.c_str(), corrected ? " (CO-corrected)" : " (uncorrected)", opt.connections,
+                    opt.threads, opt.duration, opt.rate);
+        std::printf("queries: %llu, revokes: %llu, responses: %llu (revoked: %llu, retry: %llu), timeouts: %llu, "
+                    "unexpected: %llu, errors: %llu\n",
+                    static_cast<unsigned long long>(total.queries), static_cast<unsigned long long>(total.revokes),
+                    static_cast<unsigned long long>(total.responses), static_cast<unsigned long long>(total.revoked),
+                    static_cast<unsigned long long>(total.retried),
+                    static_cast<unsigned long long>(total.timeouts),
+                    static_cast<unsigned long long>(total.unexpected), static_cast<unsigned long long>(total.errors));
+        std::printf("achieved: %.0f responses/s\n", static_cast<double>(total.responses) / opt.duration);
+        std::printf("latency (us): p50 %.1f  p90 %.1f  p99 %.1f  p999 %.1f  max %.1f\n",
+                    percentile(latencies, 0.5) / 1e3, percentile(latencies, 0.9) / 1e3,
+                    percentile(latencies, 0.99) / 1e3, percentile(latencies, 0.999) / 1e3,
+                    latencies.empty() ? 0.0 : latencies.back() / 1e3);
+
+        // 每秒的延迟分布，用于观察角色切换、参数调整期间的停顿
+        if (opt.timeline) {
+            std::printf("%6s %10s %12s %12s %12s\n", "second", "count", "p50(us)", "p99(us)", "max(us)");
+            for (auto &[second, values]: perSecond) {
+                std::sort(values.begin(), values.end());
+                std::printf("%6u %10zu %12.1f %12.1f %12.1f\n", second, values.size(), percentile(values, 0.5) / 1e3,
+                            percentile(values, 0.99) / 1e3, values.back() / 1e3);
+            }
+        }
+
+        if (!opt.jsonPath.empty()) {
+            std::ofstream out(opt.jsonPath);
+            out << "{\"mode\": \"" << opt.mode << "\", \"co_corrected\": " << (corrected ? "true" : "false")
+                    << ", \"connections\": " << opt.connections << ", \"duration\": " << opt.duration
+                    << ", \"target_rate\": " << opt.rate << ", \"queries\": " << total.queries
+                    << ", \"revokes\": " << total.revokes << ", \"responses\": " << total.responses
+                    << ", \"retried\": " << total.retried
+                    << ", \"timeouts\": " << total.timeouts << ", \"errors\": " << total.errors
+                    << ", \"latency_ns\": {\"p50\": " << percentile(latencies, 0.5)
+                    << ", \"p90\": " << percentile(latencies, 0.9) << ", \"p99\": " << percentile(latencies, 0.99)
+                    << ", \"p999\": " << percentile(latencies, 0.999)
+                    << ", \"max\": " << (latencies.empty() ? 0 : latencies.back()) << "}}" << std::endl;
+        }
+    }
+};
+
+int main(const int argc, char *argv[]) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--timeline") {
+            opt.timeline = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Error: " << arg << " option requires an argument." << std::endl;
+            return 1;
+        }
+        const std::string value = argv[++i];
+        if (arg == "--host") opt.host = value;
+        else if (arg == "--port") opt.port = value;
+        else if (arg == "--mode") opt.mode = value;
+        else if (arg == "--rate") opt.rate = std::stod(value);
+        else if (arg == "--connections") opt.connections = std::max(1u, stringToUInt(value));
+        else if (arg == "--threads") opt.threads = std::max(1u, stringToUInt(value));
+        else if (arg == "--duration") opt.duration = std::stod(value);
+        else if (arg == "--revoke-ratio") opt.revokeRatio = std::stod(value);
+        else if (arg == "--tokens") opt.tokens = std::max<size_t>(1, stringToSizeT(value));
+        else if (arg == "--token-size") opt.tokenSize = value;
+        else if (arg == "--max-life") opt.maxLife = std::max(1u, stringToUInt(value));
+        else if (arg == "--drain-timeout") opt.drainTimeout = std::stod(value);
+        else if (arg == "--deadline-ms") opt.deadlineMs = stringToUInt(value);
+        else if (arg == "--json") opt.jsonPath = value;
+        else if (arg == "--seed") opt.seed = stringToUInt(value);
+        else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (opt.mode != "open" && opt.mode != "closed") {
+        std::cerr << "Error: --mode must be open or closed." << std::endl;
+        return 1;
+    }
+    if (opt.mode == "open" && opt.rate <= 0) {
+        std::cerr << "Error: open-loop mode requires --rate > 0." << std::endl;
+        return 1;
+    }
+
+    try {
+        LoadGenerator generator(opt);
+        return generator.run();
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
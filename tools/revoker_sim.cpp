@@ -0,0 +1,371 @@
+// 窗口参数的误判率 / 容量模拟器：在真实的 Engine 与窗口过滤器上按模拟时间重放撤回流，
+// 稳态后定期用从未撤回过的 token 查询，测得实际误判率，并统计内存与每次操作探测 / 写入的窗口数。
+// 时间由 Engine::setSimulatedTime 驱动，模拟时间跨过轮换间隔时调用 Engine::rotate()，几天的撤回流几秒即可重放。
+//
+// 撤回流：
+//   合成（默认）：撤回按泊松过程到达（--revoke-rate 每秒），token 寿命服从 --lifetime，
+//                 撤回发生在 token 寿命中的均匀随机时刻（剩余时长 = 寿命 × U(0,1)）
+//   录制（--log-dir）：读取撤回日志的小时文件，同一小时文件内的记录按行序均匀分布在该小时内
+// 查询的 token 寿命同样服从 --lifetime，在寿命中的均匀随机时刻出示。
+//
+// 用法：revoker_sim [--params <max_jwt_life_time>:<rotation_interval>:<bloom_filter_size>:<hash_function_num>]...
+//                   [--revoke-rate 10] [--lifetime fixed:3600|uniform:MIN:MAX|exp:MEAN] [--duration <秒>]
+//                   [--sample-interval <秒>] [--queries 10000] [--token-size fixed:36] [--log-dir <目录>]
+//                   [--config <配置文件>] [--seed 1] [--json <文件>] [--verbose]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "detail/Engine/Engine.hpp"
+#include "detail/Utils/ConfigReader.hpp"
+#include "detail/Utils/StringParser.hpp"
+#include "TokenGenerator.hpp"
+
+struct ParamSet {
+    unsigned int maxJwtLifeTime = 0;
+    unsigned int rotationInterval = 0;
+    size_t bloomFilterSize = 0;
+    unsigned int hashFunctionNum = 0;
+
+    std::string toString() const {
+        return std::to_string(maxJwtLifeTime) + ":" + std::to_string(rotationInterval) + ":" + std::to_string(bloomFilterSize) +
+               ":" + std::to_string(hashFunctionNum);
+    }
+};
+
+struct Options {
+    std::vector<ParamSet> params;
+    double revokeRate = 10;
+    std::string lifetime = "fixed:3600";
+    double duration = 0; // 0 表示两倍的 max_jwt_life_time（前一半用于填满所有窗口）
+    double sampleInterval = 0; // 0 表示 rotation_interval / 4
+    size_t queries = 10000;
+    std::string tokenSize = "fixed:36";
+    std::string logDir;
+    std::string configPath;
+    unsigned int seed = 1;
+    std::string jsonPath;
+    bool verbose = false;
+};
+
+// token 寿命（秒）分布，格式：fixed:S | uniform:MIN:MAX | exp:MEAN
+class LifetimeDistribution {
+public:
+    explicit LifetimeDistribution(const std::string &spec) {
+        std::vector<std::string> parts;
+        std::istringstream iss(spec);
+        for (std::string part; std::getline(iss, part, ':');) parts.push_back(part);
+        kind = parts.empty() ? "" : parts[0];
+        if ((kind == "fixed" || kind == "exp") && parts.size() == 2) {
+            a = std::stod(parts[1]);
+        } else if (kind == "uniform" && parts.size() == 3) {
+            a = std::stod(parts[1]);
+            b = std::stod(parts[2]);
+        } else {
+            throw std::invalid_argument("Invalid lifetime spec: " + spec + " (expected fixed:S, uniform:MIN:MAX or exp:MEAN)");
+        }
+    }
+
+    template<typename Rng>
+    double operator()(Rng &rng) const {
+        if (kind == "uniform") return std::uniform_real_distribution<double>(a, b)(rng);
+        if (kind == "exp") return std::exponential_distribution<double>(1 / a)(rng);
+        return a;
+    }
+
+private:
+    std::string kind;
+    double a = 0;
+    double b = 0;
+};
+
+// 一次撤回：模拟时刻、token、过期时刻
+struct RevokeEvent {
+    double at;
+    std::string token;
+    time_t exp;
+};
+
+struct SimResult {
+    ParamSet params;
+    unsigned int windows = 0;
+    size_t revokes = 0;
+    size_t revokesOutOfRange = 0; // 已过期或剩余时长超出 max_jwt_life_time，引擎忽略
+    uint64_t windowWrites = 0;
+    size_t queries = 0;
+    size_t queriesOutOfRange = 0;
+    size_t falsePositives = 0;
+    uint64_t windowProbes = 0;
+    size_t revokedChecks = 0;
+    size_t falseNegatives = 0;
+    size_t maxMemoryBytes = 0;
+    double maxOldestEstimatedFpr = 0;
+    double seconds = 0;
+
+    double fpr() const { return queries ? static_cast<double>(falsePositives) / static_cast<double>(queries) : 0; }
+};
+
+class Simulator {
+public:
+    explicit Simulator(const Options &_opt)
+        : opt(_opt), lifetimes(_opt.lifetime), tokenSizes(_opt.tokenSize) {
+        if (!opt.configPath.empty()) config = readConfig(opt.configPath);
+        config["log_file_path"] = ""; // 不写撤回日志
+        config["shm_export_path"] = "";
+        config["startup_snapshot_path"] = "";
+        if (!opt.logDir.empty()) loadRecordedStream();
+    }
+
+    SimResult run(const ParamSet &params) {
+        const auto start = std::chrono::steady_clock::now();
+        SimResult result;
+        result.params = params;
+        result.windows = ceilDiv(params.maxJwtLifeTime, params.rotationInterval);
+
+        const double duration = opt.duration > 0 ? opt.duration : 2.0 * params.maxJwtLifeTime;
+        const double sampleInterval = opt.sampleInterval > 0 ? opt.sampleInterval : params.rotationInterval / 4.0;
+        // 模拟时间的起点：录制流从第一条记录开始，合成流使用固定的时刻，保证各参数组重放同一条撤回流
+        const double t0 = recorded.empty() ? SYNTHETIC_EPOCH : recorded.front().at;
+        const double end = t0 + duration;
+
+        // 引擎自身的输出（参数、logo、轮换信息）只在 --verbose 时保留
+        std::streambuf *coutBuf = std::cout.rdbuf();
+        std::ostringstream discard;
+        if (!opt.verbose) std::cout.rdbuf(discard.rdbuf());
+        {
+            Engine engine(config);
+            engine.setSimulatedTime(static_cast<time_t>(t0));
+            engine.init(params.maxJwtLifeTime, params.rotationInterval, params.bloomFilterSize, params.hashFunctionNum);
+
+            std::mt19937_64 revokeRng(opt.seed);
+            std::mt19937_64 queryRng(opt.seed + 1);
+            std::vector<std::pair<std::string, time_t> > recentRevoked; // 用于检查漏报的最近撤回
+            size_t recordedIndex = 0;
+            double nextRevoke = t0;
+            double nextRotation = t0 + params.rotationInterval;
+            double nextSample = t0 + params.maxJwtLifeTime; // 所有窗口都经历过完整的写入后进入稳态
+
+            while (true) {
+                // 下一次撤回
+                RevokeEvent event;
+                if (!recorded.empty()) {
+                    if (recordedIndex >= recorded.size()) break;
+                    event = recorded[recordedIndex++];
+                } else {
+                    nextRevoke += std::exponential_distribution<double>(opt.revokeRate)(revokeRng);
+                    const double remaining = lifetimes(revokeRng) * std::uniform_real_distribution<double>(0, 1)(revokeRng);
+                    event = {nextRevoke, randomToken(revokeRng, tokenSizes(revokeRng)),
+                             static_cast<time_t>(std::ceil(nextRevoke + remaining))};
+                }
+                if (event.at > end) break;
+
+                // 按时间顺序处理撤回之前的轮换与采样
+                while (std::min(nextRotation, nextSample) <= event.at) {
+                    if (nextRotation <= nextSample) {
+                        engine.setSimulatedTime(static_cast<time_t>(nextRotation));
+                        engine.rotate();
+                        nextRotation += params.rotationInterval;
+                    } else {
+                        engine.setSimulatedTime(static_cast<time_t>(nextSample));
+                        sample(engine, params, static_cast<time_t>(nextSample), queryRng, recentRevoked, result);
+                        nextSample += sampleInterval;
+                    }
+                }
+
+                const auto now = static_cast<time_t>(event.at);
+                engine.setSimulatedTime(now);
+                engine.revokeJwt(event.token, event.exp);
+                ++result.revokes;
+                const time_t remaining = event.exp - now;
+                if (remaining <= 0 || remaining > static_cast<time_t>(params.maxJwtLifeTime)) {
+                    ++result.revokesOutOfRange;
+                    continue;
+                }
+                result.windowWrites += ceilDiv(remaining, params.rotationInterval);
+                if (recentRevoked.size() < RECENT_REVOKED_NUM) {
+                    recentRevoked.emplace_back(event.token, event.exp);
+                } else {
+                    recentRevoked[result.revokes % RECENT_REVOKED_NUM] = {event.token, event.exp};
+                }
+            }
+        }
+        std::cout.rdbuf(coutBuf);
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return result;
+    }
+
+private:
+    static constexpr double SYNTHETIC_EPOCH = 1.7e9;
+    static constexpr size_t RECENT_REVOKED_NUM = 4096;
+
+    const Options &opt;
+    std::map<std::string, std::string> config;
+    LifetimeDistribution lifetimes;
+    TokenSizeDistribution tokenSizes;
+    std::vector<RevokeEvent> recorded;
+
+    // 一次采样：用从未撤回的 token 测误判，用最近撤回且未过期的 token 测漏报（任何窗口实现都不应漏报）
+    void sample(Engine &engine, const ParamSet &params, const time_t now, std::mt19937_64 &rng,
+                const std::vector<std::pair<std::string, time_t> > &recentRevoked, SimResult &result) const {
+        for (size_t i = 0; i < opt.queries; ++i) {
+            const double remaining = lifetimes(rng) * std::uniform_real_distribution<double>(0, 1)(rng);
+            const auto exp = static_cast<time_t>(std::ceil(static_cast<double>(now) + remaining));
+            if (exp - now <= 0 || exp - now > static_cast<time_t>(params.maxJwtLifeTime)) {
+                ++result.queriesOutOfRange;
+                continue;
+            }
+            // 查询 token 的前缀保证与撤回流中的 token 不同
+            const std::string token = "q" + randomToken(rng, tokenSizes(rng));
+            unsigned int probed = 0;
+            if (engine.isRevoked(token, exp, &probed)) ++result.falsePositives;
+            ++result.queries;
+            result.windowProbes += probed;
+        }
+        for (const auto &[token, exp]: recentRevoked) {
+            if (exp <= now) continue;
+            ++result.revokedChecks;
+            if (!engine.isRevoked(token, exp)) ++result.falseNegatives;
+        }
+
+        result.maxMemoryBytes = std::max(result.maxMemoryBytes, engine.measureFilterMemory());
+        if (const auto fpr = engine.getBloomFilterEstimatedFpr(); !fpr.empty()) {
+            result.maxOldestEstimatedFpr = std::max(result.maxOldestEstimatedFpr, fpr.front());
+        }
+    }
+
+    // 录制的撤回流：小时文件名为该小时的起始时间戳
+    void loadRecordedStream() {
+        for (const auto &entry: std::filesystem::directory_iterator(opt.logDir)) {
+            if (!entry.is_regular_file() || entry.path().extension() != ".txt") continue;
+            const double hour = std::stod(entry.path().stem().string());
+            std::ifstream file(entry.path());
+            std::vector<std::pair<std::string, time_t> > lines;
+            for (std::string line; std::getline(file, line);) {
+                const size_t comma = line.rfind(',');
+                if (line.starts_with('!') || comma == std::string::npos || comma == 0) continue;
+                lines.emplace_back(line.substr(0, comma), static_cast<time_t>(std::stoll(line.substr(comma + 1))));
+            }
+            for (size_t i = 0; i < lines.size(); ++i) {
+                recorded.push_back({hour + 3600.0 * static_cast<double>(i) / static_cast<double>(lines.size()),
+                                    std::move(lines[i].first), lines[i].second});
+            }
+        }
+        if (recorded.empty()) throw std::runtime_error("No revoke records found in " + opt.logDir);
+        std::stable_sort(recorded.begin(), recorded.end(), [](const auto &a, const auto &b) { return a.at < b.at; });
+    }
+};
+
+ParamSet parseParamSet(const std::string &spec) {
+    std::vector<std::string> parts;
+    std::istringstream iss(spec);
+    for (std::string part; std::getline(iss, part, ':');) parts.push_back(part);
+    if (parts.size() != 4) throw std::invalid_argument("Invalid --params: " + spec);
+    ParamSet params{stringToUInt(parts[0]), stringToUInt(parts[1]), stringToSizeT(parts[2]), stringToUInt(parts[3])};
+    if (params.maxJwtLifeTime == 0 || params.rotationInterval == 0 || params.bloomFilterSize == 0 ||
+        params.hashFunctionNum == 0) {
+        throw std::invalid_argument("Invalid --params: " + spec);
+    }
+    return params;
+}
+
+std::string toJson(const std::vector<SimResult> &results) {
+    std::string out = "{\n  \"results\": [\n";
+    char buf[1024];
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto &r = results[i];
+        const size_t inRange = r.revokes - r.revokesOutOfRange;
+        std::snprintf(buf, sizeof(buf),
+                      "    {\"params\": \"%s\", \"windows\": %u, \"revokes\": %zu, \"revokes_out_of_range\": %zu, "
+                      "\"window_writes_per_revoke\": %.4f, \"queries\": %zu, \"queries_out_of_range\": %zu, "
+                      "\"false_positives\": %zu, \"fpr\": %.6e, \"window_probes_per_query\": %.4f, "
+                      "\"revoked_checks\": %zu, \"false_negatives\": %zu, \"max_memory_bytes\": %zu, "
+                      "\"max_oldest_window_estimated_fpr\": %.6e, \"seconds\": %.3f}%s\n",
+                      r.params.toString().c_str(), r.windows, r.revokes, r.revokesOutOfRange,
+                      inRange ? static_cast<double>(r.windowWrites) / static_cast<double>(inRange) : 0.0, r.queries,
+                      r.queriesOutOfRange, r.falsePositives, r.fpr(),
+                      r.queries ? static_cast<double>(r.windowProbes) / static_cast<double>(r.queries) : 0.0,
+                      r.revokedChecks, r.falseNegatives, r.maxMemoryBytes, r.maxOldestEstimatedFpr, r.seconds,
+                      i + 1 < results.size() ? "," : "");
+        out += buf;
+    }
+    out += "  ]\n}\n";
+    return out;
+}
+
+int main(const int argc, char *argv[]) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--verbose") {
+            opt.verbose = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Error: " << arg << " option requires an argument." << std::endl;
+            return 1;
+        }
+        const std::string value = argv[++i];
+        try {
+            if (arg == "--params") opt.params.push_back(parseParamSet(value));
+            else if (arg == "--revoke-rate") opt.revokeRate = std::stod(value);
+            else if (arg == "--lifetime") opt.lifetime = value;
+            else if (arg == "--duration") opt.duration = std::stod(value);
+            else if (arg == "--sample-interval") opt.sampleInterval = std::stod(value);
+            else if (arg == "--queries") opt.queries = stringToSizeT(value);
+            else if (arg == "--token-size") opt.tokenSize = value;
+            else if (arg == "--log-dir") opt.logDir = value;
+            else if (arg == "--config") opt.configPath = value;
+            else if (arg == "--seed") opt.seed = stringToUInt(value);
+            else if (arg == "--json") opt.jsonPath = value;
+            else {
+                std::cerr << "Unknown option: " << arg << std::endl;
+                return 1;
+            }
+        } catch (const std::exception &e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+    if (opt.params.empty()) opt.params.push_back({86400, 3600, 8388608, 5}); // master 的默认参数
+    if (!(opt.revokeRate > 0)) {
+        std::cerr << "Error: --revoke-rate must be > 0." << std::endl;
+        return 1;
+    }
+
+    try {
+        Simulator simulator(opt);
+        std::vector<SimResult> results;
+        std::printf("%-32s %7s %10s %9s %10s %12s %9s %9s %6s %10s\n", "params", "windows", "memory MB", "revokes",
+                    "queries", "FPR", "probes/q", "writes/r", "FN", "est oldest");
+        for (const auto &params: opt.params) {
+            const SimResult r = simulator.run(params);
+            std::printf("%-32s %7u %10.2f %9zu %10zu %12.3e %9.2f %9.2f %6zu %10.3e\n", params.toString().c_str(), r.windows,
+                        static_cast<double>(r.maxMemoryBytes) / 1048576, r.revokes, r.queries, r.fpr(),
+                        r.queries ? static_cast<double>(r.windowProbes) / static_cast<double>(r.queries) : 0.0,
+                        r.revokes > r.revokesOutOfRange
+                            ? static_cast<double>(r.windowWrites) / static_cast<double>(r.revokes - r.revokesOutOfRange)
+                            : 0.0, r.falseNegatives, r.maxOldestEstimatedFpr);
+            std::fflush(stdout);
+            results.push_back(r);
+        }
+        if (!opt.jsonPath.empty()) {
+            std::ofstream(opt.jsonPath) << toJson(results);
+            std::cout << "Results written to " << opt.jsonPath << std::endl;
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}